@@ -1,1314 +1,4424 @@
-#include "BPlusTree.h"
-
-#include <cassert>
-#include <limits>
-#include <queue>
-#include <sstream>
-
-// ================================ BPlusTreeNode 实现================================
-
-/**
- * @brief BPlusTreeNode 构造函数
- * @param pageId 页面ID，用于唯一标识此节点
- * @param isLeaf 是否为叶子节点的标志
- * 
- * 初始化B+树节点的基本属性，包括页面头信息和容器预分配
- */
-BPlusTreeNode::BPlusTreeNode(int pageId, bool isLeaf) : dirty(false) {
-    // 设置页面头信息
-    header.pageId = pageId;           // 设置页面唯一标识符
-    header.isLeaf = isLeaf;           // 标记节点类型（叶子或内部节点）
-    header.keyCount = 0;              // 初始化键数量为0
-    header.parentId = -1;             // 初始化父节点ID为-1（表示无父节点）
-    header.nextLeafId = -1;           // 初始化下一个叶子节点ID为-1
-
-    // 预分配键向量容量，提高插入性能
-    keys.reserve(MAX_KEYS_PER_PAGE);
-
-    // 如果不是叶子节点，预分配子节点指针向量容量
-    if (!isLeaf) {
-        children.reserve(MAX_KEYS_PER_PAGE + 1);  // 内部节点的子节点数 = 键数 + 1
-    }
-}
-
-/**
- * @brief 将节点数据序列化到缓冲区
- * @param buffer 目标缓冲区，大小必须为PAGE_SIZE
- * 
- * 将节点的所有数据（页面头、键值、子节点指针）按顺序写入缓冲区，
- * 用于持久化存储到磁盘文件中
- */
-void BPlusTreeNode::serialize(char* buffer) const {
-    // 清零整个缓冲区，确保未使用区域为0
-    memset(buffer, 0, PAGE_SIZE);
-
-    // 复制页面头信息到缓冲区开始位置
-    memcpy(buffer, &header, sizeof(PageHeader));
-    int offset = sizeof(PageHeader);          // 记录当前写入位置
-
-    // 依次复制所有键值对到缓冲区
-    for (int i = 0; i < header.keyCount; i++) {
-        memcpy(buffer + offset, &keys[i], sizeof(KeyValue));
-        offset += sizeof(KeyValue);          // 更新写入位置
-    }
-
-    // 对于内部节点，需要序列化子节点指针
-    if (!header.isLeaf) {
-        for (int i = 0; i <= header.keyCount; i++) {
-            if (i < children.size()) {
-                // 复制有效的子节点ID
-                memcpy(buffer + offset, &children[i], sizeof(int));
-            } else {
-                // 对于不存在的子节点，写入-1作为无效标记
-                int invalidId = -1;
-                memcpy(buffer + offset, &invalidId, sizeof(int));
-            }
-            offset += sizeof(int);           // 更新写入位置
-        }
-    }
-}
-
-/**
- * @brief 从缓冲区反序列化节点数据
- * @param buffer 源缓冲区，包含序列化的节点数据
- * 
- * 从缓冲区中读取节点数据并重建节点状态，
- * 用于从磁盘文件中加载节点数据
- */
-void BPlusTreeNode::deserialize(const char* buffer) {
-    // 从缓冲区复制页面头信息
-    memcpy(&header, buffer, sizeof(PageHeader));
-    int offset = sizeof(PageHeader);          // 记录当前读取位置
-
-    // 清空并重建键向量
-    keys.clear();
-    keys.resize(header.keyCount);            // 根据键数量调整向量大小
-    for (int i = 0; i < header.keyCount; i++) {
-        // 依次读取每个键值对
-        memcpy(&keys[i], buffer + offset, sizeof(KeyValue));
-        offset += sizeof(KeyValue);          // 更新读取位置
-    }
-
-    // 清空子节点向量
-    children.clear();
-    // 对于内部节点，需要反序列化子节点指针
-    if (!header.isLeaf) {
-        children.resize(header.keyCount + 1); // 内部节点的子节点数 = 键数 + 1
-        for (int i = 0; i <= header.keyCount; i++) {
-            // 依次读取每个子节点ID
-            memcpy(&children[i], buffer + offset, sizeof(int));
-            offset += sizeof(int);           // 更新读取位置
-        }
-    }
-
-    // 标记节点为干净状态（未修改）
-    dirty = false;
-}
-
-/**
- * @brief 检查节点是否已满
- * @return true 如果节点已满，false 否则
- * 
- * 判断节点中的键数量是否达到最大限制，
- * 用于决定是否需要进行节点分裂操作
- */
-bool BPlusTreeNode::isFull() const {
-    // 当键数量达到最大值时认为已满
-    return header.keyCount >= MAX_KEYS_PER_PAGE;
-}
-
-/**
- * @brief 在节点中查找键的插入位置
- * @param key 要查找的键值
- * @return 键应该插入的位置索引
- * 
- * 使用二分查找算法在有序键数组中找到指定键的位置，
- * 如果键存在则返回其位置，否则返回应该插入的位置
- */
-int BPlusTreeNode::findKey(const std::string& key) const {
-    int left = 0;                            // 搜索范围左边界
-    int right = header.keyCount;             // 搜索范围右边界
-
-    // 二分查找循环
-    while (left < right) {
-        int mid = left + (right - left) / 2; // 计算中点，防止溢出
-
-        // 比较中点键值与目标键值
-        if (keys[mid].getKey() >= key) {
-            right = mid;                     // 目标在左半部分
-        } else {
-            left = mid + 1;                  // 目标在右半部分
-        }
-    }
-
-    return left;                             // 返回插入位置
-}
-
-/**
- * @brief 在节点中插入键值对
- * @param kv 要插入的键值对
- * @param childId 相关的子节点ID（仅对内部节点有效，默认为-1）
- * 
- * 在节点的正确位置插入新的键值对，保持键的有序性，
- * 对于内部节点还需要插入对应的子节点指针
- */
-void BPlusTreeNode::insertKey(const KeyValue& kv, int childId) {
-    // 检查是否还有空间进行插入
-    if (header.keyCount >= MAX_KEYS_PER_PAGE) {
-        std::cerr << "Warning: Attempting to insert into full node"
-                  << std::endl;
-        return;                              // 节点已满，无法插入
-    }
-
-    // 找到键值对应该插入的位置
-    int pos = findKey(kv.getKey());
-
-    // 在指定位置插入键值对，保持有序性
-    keys.insert(keys.begin() + pos, kv);
-    header.keyCount++;                       // 增加键计数
-
-    // 对于内部节点，需要插入对应的子节点指针
-    if (!header.isLeaf && childId != -1) {
-        // 子节点指针插入在键的右侧
-        children.insert(children.begin() + pos + 1, childId);
-    }
-
-    // 标记节点为脏状态（已修改）
-    dirty = true;
-}
-
-/**
- * @brief 从节点中删除指定索引的键
- * @param index 要删除的键的索引位置
- * 
- * 删除指定位置的键值对，对于内部节点还需要删除对应的子节点指针，
- * 删除后保持数组的连续性
- */
-void BPlusTreeNode::removeKey(int index) {
-    // 检查索引有效性
-    if (index >= 0 && index < header.keyCount) {
-        // 删除指定位置的键
-        keys.erase(keys.begin() + index);
-        header.keyCount--;                   // 减少键计数
-
-        // 对于内部节点，删除对应的子节点指针
-        if (!header.isLeaf && index < (int)children.size()) {
-            // 删除键右侧的子节点指针
-            children.erase(children.begin() + index + 1);
-        }
-
-        // 标记节点为脏状态（已修改）
-        dirty = true;
-    }
-}
-
-/**
- * @brief 分裂节点
- * @param newNode 新创建的节点，用于存放分裂后的右半部分数据
- * @param promotedKey 输出参数，返回需要上提到父节点的键
- * 
- * 将当前节点分裂为两个节点，当前节点保留左半部分，
- * 新节点存储右半部分，并确定需要上提到父节点的键
- */
-void BPlusTreeNode::split(std::shared_ptr<BPlusTreeNode> newNode,
-                          KeyValue& promotedKey) {
-    // 使用更优化的分裂策略
-    int totalKeys = header.keyCount;         // 总键数
-    int mid;                                 // 分裂点
-
-    if (header.isLeaf) {
-        // 叶子节点：尽可能均匀分裂
-        mid = (totalKeys + 1) / 2;          // 向上取整，右边可能多1个
-    } else {
-        // 内部节点：中间键要上提，所以分裂点不同
-        mid = totalKeys / 2;                // 向下取整
-    }
-
-    if (header.isLeaf) {
-        // 叶子节点分裂处理
-        // 将右半部分的键复制到新节点
-        for (int i = mid; i < header.keyCount; i++) {
-            newNode->keys.push_back(keys[i]);
-        }
-        newNode->header.keyCount = header.keyCount - mid;
-
-        // 维护叶子节点链表的连接关系
-        newNode->header.nextLeafId = header.nextLeafId;  // 新节点指向原节点的下一个
-        header.nextLeafId = newNode->header.pageId;      // 原节点指向新节点
-
-        // 叶子节点分裂时，上提的键是右边第一个键的副本
-        if (newNode->header.keyCount > 0) {
-            promotedKey = newNode->keys[0];
-        }
-    } else {
-        // 内部节点分裂处理
-        if (mid < header.keyCount) {
-            promotedKey = keys[mid];         // 中间键上提到父节点
-        }
-
-        // 右边节点获得mid+1到end的键（跳过上提的中间键）
-        for (int i = mid + 1; i < header.keyCount; i++) {
-            newNode->keys.push_back(keys[i]);
-        }
-        newNode->header.keyCount = header.keyCount - mid - 1;
-
-        // 移动对应的子指针到新节点
-        for (int i = mid + 1; i <= header.keyCount && i < (int)children.size();
-             i++) {
-            newNode->children.push_back(children[i]);
-        }
-    }
-
-    // 调整当前节点大小，保留左半部分
-    keys.resize(mid);
-    header.keyCount = mid;
-    if (!header.isLeaf) {
-        children.resize(mid + 1);            // 内部节点保留mid+1个子指针
-    }
-
-    // 标记两个节点都为脏状态
-    dirty = true;
-    newNode->dirty = true;
-}
-
-// ================================ BPlusTree 实现
-// ================================
-
-/**
- * @brief BPlusTree 构造函数
- * 
- * 初始化B+树对象，设置初始状态
- */
-BPlusTree::BPlusTree() {}
-
-/**
- * @brief BPlusTree 析构函数
- * 
- * 清理资源，关闭文件和缓冲池
- */
-BPlusTree::~BPlusTree() { 
-    close();                                 // 确保资源被正确释放
-}
-
-/**
- * @brief 创建或打开B+树文件
- * @param fname 文件名
- * @param pageSize 页面大小（当前实现中未使用）
- * @param bufferPoolSize 缓冲池大小
- * @return true 成功，false 失败
- * 
- * 创建新的B+树文件或打开existing文件，初始化缓冲池和元数据
- */
-bool BPlusTree::create(const std::string& fname, int pageSize,
-                       size_t bufferPoolSize) {
-    filename = fname;                        // 保存文件名
-
-    // 初始化BufferPool，限制缓冲池大小以避免内存问题
-    size_t maxBufferSize = std::min(bufferPoolSize, static_cast<size_t>(1000));
-    bufferPool = std::make_unique<BufferPool>(maxBufferSize);
-
-    // 设置缓冲池的保存回调函数，当页面需要写回磁盘时调用
-    bufferPool->setSaveCallback(
-        [this](std::shared_ptr<BPlusTreeNode> node) { this->savePage(node); });
-
-    // 检查文件是否已存在
-    std::ifstream testFile(filename);
-    bool fileExists = testFile.good();      // 测试文件是否可读
-    testFile.close();
-
-    if (fileExists) {
-        // 文件存在，以读写模式打开
-        file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
-        if (file.is_open()) {
-            loadMetadata();                  // 加载已有的元数据
-            return true;
-        }
-        return false;                        // 文件打开失败
-    } else {
-        // 文件不存在，创建新文件
-        file.open(filename, std::ios::out | std::ios::binary);
-        if (!file.is_open()) {
-            return false;                    // 文件创建失败
-        }
-        file.close();
-
-        // 重新以读写模式打开
-        file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
-        if (!file.is_open()) {
-            return false;                    // 文件打开失败
-        }
-
-        // 初始化新的元数据
-        metadata = Metadata();
-        saveMetadata();                      // 保存初始元数据到文件
-        return true;
-    }
-}
-
-/**
- * @brief 关闭B+树，释放资源
- * 
- * 刷新所有缓冲页面到磁盘，保存元数据，关闭文件
- */
-void BPlusTree::close() {
-    if (bufferPool) {
-        bufferPool->flushAllPages();         // 将所有脏页写回磁盘
-        bufferPool.reset();                  // 释放缓冲池
-    }
-    if (file.is_open()) {
-        saveMetadata();                      // 保存最新的元数据
-        file.close();                        // 关闭文件
-    }
-}
-
-/**
- * @brief 从磁盘加载页面
- * @param pageId 要加载的页面ID
- * @return 加载的节点指针，失败时返回nullptr
- * 
- * 通过缓冲池管理页面加载，如果页面不在缓冲池中则从磁盘读取
- */
-std::shared_ptr<BPlusTreeNode> BPlusTree::loadPage(int pageId) {
-    if (!bufferPool) {
-        return nullptr;                      // 缓冲池未初始化
-    }
-
-    // 通过缓冲池获取页面，如果不存在则使用lambda函数加载
-    auto node = bufferPool->getPage(
-        pageId, [this, pageId]() -> std::shared_ptr<BPlusTreeNode> {
-            // 创建新的节点对象
-            auto newNode = std::make_shared<BPlusTreeNode>(pageId);
-
-            // 计算文件位置，使用更安全的计算方式
-            std::streampos filePos =
-                METADATA_SIZE + static_cast<std::streampos>(pageId) * PAGE_SIZE;
-
-            // 检查文件位置是否合理
-            if (filePos < 0 || pageId < 0) {
-                std::cerr << "Invalid page position: pageId=" << pageId
-                          << ", pos=" << filePos << std::endl;
-                return nullptr;
-            }
-
-            // 定位到文件中的页面位置
-            this->file.seekg(filePos);
-            if (!this->file.good()) {
-                std::cerr << "Failed to seek to position: " << filePos
-                          << std::endl;
-                this->file.clear();          // 清除错误状态
-                return newNode;              // 返回空节点而不是nullptr
-            }
-
-            // 读取页面数据
-            char buffer[PAGE_SIZE];
-            this->file.read(buffer, PAGE_SIZE);
-
-            if (this->file.gcount() == PAGE_SIZE) {
-                // 完整读取，反序列化数据
-                newNode->deserialize(buffer);
-            } else if (this->file.gcount() > 0) {
-                // 部分读取，可能是文件末尾
-                std::cout << "Partial read: " << this->file.gcount() << " bytes"
-                          << std::endl;
-            }
-
-            return newNode;
-        });
-
-    return node;
-}
-
-/**
- * @brief 保存页面到磁盘
- * @param node 要保存的节点
- * 
- * 将节点数据序列化并写入磁盘文件的对应位置
- */
-void BPlusTree::savePage(std::shared_ptr<BPlusTreeNode> node) {
-    // 检查节点有效性和是否需要保存
-    if (!node || !node->dirty) return;
-
-    // 序列化节点数据到缓冲区
-    char buffer[PAGE_SIZE];
-    node->serialize(buffer);
-
-    // 使用更安全的位置计算
-    std::streampos filePos =
-        METADATA_SIZE +
-        static_cast<std::streampos>(node->header.pageId) * PAGE_SIZE;
-
-    // 检查位置有效性
-    if (filePos < 0 || node->header.pageId < 0) {
-        std::cerr << "Invalid save position: pageId=" << node->header.pageId
-                  << ", pos=" << filePos << std::endl;
-        return;
-    }
-
-    // 定位到文件写入位置
-    file.seekp(filePos);
-    if (!file.good()) {
-        std::cerr << "Failed to seek to save position: " << filePos
-                  << std::endl;
-        file.clear();                        // 清除错误状态
-        return;
-    }
-
-    // 写入页面数据
-    file.write(buffer, PAGE_SIZE);
-    if (!file.good()) {
-        std::cerr << "Failed to write page " << node->header.pageId
-                  << " to disk" << std::endl;
-        file.clear();                        // 清除错误状态
-        return;
-    }
-    fileWriteCount++;                        // 增加写入计数
-
-    file.flush();                            // 强制刷新到磁盘
-    node->dirty = false;                     // 标记为干净状态
-}
-
-/**
- * @brief 创建新页面
- * @param isLeaf 是否为叶子节点
- * @return 新创建的节点指针，失败时返回nullptr
- * 
- * 分配新的页面ID，创建新节点，并加入缓冲池管理
- */
-std::shared_ptr<BPlusTreeNode> BPlusTree::createNewPage(bool isLeaf) {
-    // 检查页面ID是否会溢出
-    if (metadata.nextPageId < 0 || metadata.nextPageId > 10000000) {
-        std::cerr << "Page ID overflow or invalid: " << metadata.nextPageId
-                  << std::endl;
-        return nullptr;
-    }
-
-    // 分配新的页面ID
-    int pageId = metadata.nextPageId++;
-    // 创建新节点
-    auto node = std::make_shared<BPlusTreeNode>(pageId, isLeaf);
-    node->dirty = true;                      // 新节点需要保存
-
-    // 将新节点加入缓冲池
-    if (bufferPool) {
-        bufferPool->putPage(pageId, node);
-        bufferPool->markDirty(pageId);       // 标记为脏页
-    }
-    metadata.pageCount++;                    // 增加页面计数
-
-    return node;
-}
-
-/**
- * @brief 保存元数据到文件
- * 
- * 将B+树的元数据（根页面ID、页面计数等）写入文件头部
- */
-void BPlusTree::saveMetadata() {
-    // 定位到文件开始位置
-    file.seekp(0);
-    if (!file.good()) {
-        std::cerr << "Failed to seek to metadata position" << std::endl;
-        file.clear();                        // 清除错误状态
-        return;
-    }
-
-    // 写入元数据结构
-    file.write(reinterpret_cast<const char*>(&metadata), sizeof(Metadata));
-    if (!file.good()) {
-        std::cerr << "Failed to write metadata" << std::endl;
-        file.clear();                        // 清除错误状态
-        return;
-    }
-
-    file.flush();                            // 强制刷新到磁盘
-}
-
-/**
- * @brief 从文件加载元数据
- * 
- * 从文件头部读取B+树的元数据信息
- */
-void BPlusTree::loadMetadata() {
-    // 定位到文件开始位置
-    file.seekg(0);
-    // 读取元数据结构
-    file.read(reinterpret_cast<char*>(&metadata), sizeof(Metadata));
-
-    // 验证元数据的合理性
-    if (metadata.nextPageId < 0 || metadata.pageCount < 0) {
-        std::cout << "Invalid metadata detected, reinitializing..."
-                  << std::endl;
-        metadata = Metadata();              // 重新初始化元数据
-    }
-}
-
-/**
- * @brief 查找包含指定键的叶子节点
- * @param key 要查找的键
- * @return 包含该键的叶子节点指针，未找到时返回nullptr
- * 
- * 从根节点开始，沿着B+树向下查找，直到找到包含指定键的叶子节点
- */
-std::shared_ptr<BPlusTreeNode> BPlusTree::findLeafNode(const std::string& key) {
-    // 检查树是否为空
-    if (metadata.rootPageId == -1) {
-        return nullptr;                      // 空树
-    }
-
-    // 从根节点开始查找
-    auto current = loadPage(metadata.rootPageId);
-
-    // 向下遍历直到叶子节点
-    while (current && !current->header.isLeaf) {
-        // 在当前内部节点中查找键的位置
-        int pos = current->findKey(key);
-
-        // 如果找到相等的键，选择右子树
-        if (pos < current->header.keyCount &&
-            current->keys[pos].getKey() == key) {
-            pos++;                           // 移动到右子树
-        }
-
-        // 检查子节点数组的有效性
-        if (current->children.empty() || pos >= (int)current->children.size()) {
-            return nullptr;                  // 子节点数组无效
-        }
-        if (pos < 0) {
-            pos = 0;                         // 确保索引非负
-        }
-
-        // 检查子节点ID的有效性
-        if (pos < 0 || current->children[pos] == -1) {
-            return nullptr;                  // 无效的子节点ID
-        }
-
-        // 加载子节点并继续向下查找
-        current = loadPage(current->children[pos]);
-    }
-
-    return current;                          // 返回找到的叶子节点
-}
-
-/**
- * @brief 插入键值对到B+树
- * @param key 键
- * @param value 值数组
- * @param rowId 行ID
- * @return true 插入成功，false 插入失败
- * 
- * 在B+树中插入新的键值对，如果键已存在则更新值，
- * 如果节点满了则进行分裂操作
- */
-bool BPlusTree::insert(const std::string& key,
-                       const std::vector<std::string>& value,
-                       const std::string& rowId) {
-    // 构造键值对象
-    std::string val = value.empty() ? "" : value[0];
-    KeyValue kv(key, rowId, val);
-
-    // 处理空树的情况
-    if (metadata.rootPageId == -1) {
-        // 创建第一个节点作为根节点（叶子节点）
-        auto root = createNewPage(true);
-        if (!root) return false;             // 创建失败
-
-        // 插入第一个键值对
-        root->insertKey(kv);
-        metadata.rootPageId = root->header.pageId;  // 设置根节点ID
-        saveMetadata();                      // 保存元数据
-        return true;
-    }
-
-    // 查找目标叶子节点
-    auto leaf = findLeafNode(key);
-    if (!leaf) return false;                 // 查找失败
-
-    // 在叶子节点中查找键的位置
-    int pos = leaf->findKey(key);
-    if (pos < leaf->header.keyCount && leaf->keys[pos].getKey() == key) {
-        // 键已存在，更新值（这是原来的正确行为）
-        leaf->keys[pos] = kv;
-        leaf->dirty = true;                  // 标记为脏页
-        if (bufferPool) {
-            bufferPool->markDirty(leaf->header.pageId);
-        }
-        return true;
-    }
-
-    // 插入新键
-    leaf->insertKey(kv);
-    if (bufferPool) {
-        bufferPool->markDirty(leaf->header.pageId);  // 标记为脏页
-    }
-
-    // 每插入100个键清理一次缓冲池，控制内存使用
-    // 先不管这个，不知道为什么变快了，按理说不应该
-    // static int insertCount = 0;
-    // if (++insertCount % 100 == 0 && bufferPool) {
-    //     bufferPool->flushAllPages();
-    // }
-
-    // 检查是否需要分裂
-    if (leaf->isFull()) {
-        handleOverflow(leaf);                // 处理节点溢出
-    }
-
-    return true;
-}
-
-/**
- * @brief 处理节点溢出（分裂）
- * @param node 发生溢出的节点
- * 
- * 处理节点分裂的连锁反应，使用迭代方式避免递归调用栈溢出
- */
-void BPlusTree::handleOverflow(std::shared_ptr<BPlusTreeNode> node) {
-    // 使用队列存储需要处理的溢出节点
-    std::vector<std::shared_ptr<BPlusTreeNode>> overflowNodes;
-    overflowNodes.push_back(node);
-
-    // 使用循环而不是递归处理溢出，避免栈溢出
-    while (!overflowNodes.empty()) {
-        auto currentNode = overflowNodes.back();
-        overflowNodes.pop_back();
-
-        // 检查节点是否真的需要分裂
-        if (!currentNode || !currentNode->isFull()) continue;
-
-        // 创建新节点用于存储分裂后的右半部分
-        auto newNode = createNewPage(currentNode->header.isLeaf);
-        if (!newNode) continue;              // 创建失败，跳过
-
-        // 执行节点分裂
-        KeyValue promotedKey;
-        currentNode->split(newNode, promotedKey);
-        metadata.splitCount++;               // 增加分裂计数
-
-        // 标记相关页面为脏页
-        if (bufferPool) {
-            bufferPool->markDirty(currentNode->header.pageId);
-            bufferPool->markDirty(newNode->header.pageId);
-        }
-
-        // 处理根节点分裂的特殊情况
-        if (currentNode->header.pageId == metadata.rootPageId) {
-            // 创建新根节点
-            auto newRoot = createNewPage(false);  // 内部节点
-            if (!newRoot) continue;          // 创建失败，跳过
-
-            // 设置新根节点的子节点和键
-            newRoot->children.push_back(currentNode->header.pageId);
-            newRoot->children.push_back(newNode->header.pageId);
-            newRoot->keys.push_back(promotedKey);
-            newRoot->header.keyCount = 1;
-
-            // 更新子节点的父节点引用
-            currentNode->header.parentId = newRoot->header.pageId;
-            newNode->header.parentId = newRoot->header.pageId;
-
-            // 更新根节点ID
-            metadata.rootPageId = newRoot->header.pageId;
-            saveMetadata();
-
-            if (bufferPool) {
-                bufferPool->markDirty(newRoot->header.pageId);
-            }
-        } else {
-            // 非根节点分裂，需要向父节点插入上提的键
-            auto parent = loadPage(currentNode->header.parentId);
-            if (parent) {
-                // 设置新节点的父节点
-                newNode->header.parentId = parent->header.pageId;
-                // 向父节点插入上提的键
-                insertInternal(parent, promotedKey, newNode->header.pageId);
-
-                // 如果父节点也满了，加入队列处理
-                if (parent->isFull()) {
-                    overflowNodes.push_back(parent);
-                }
-            }
-        }
-    }
-}
-
-/**
- * @brief 向内部节点插入键值对
- * @param node 目标内部节点
- * @param kv 要插入的键值对
- * @param rightChildId 键右侧的子节点ID
- * 
- * 在内部节点中插入键值对和对应的子节点指针
- */
-void BPlusTree::insertInternal(std::shared_ptr<BPlusTreeNode> node,
-                               const KeyValue& kv, int rightChildId) {
-    // 检查节点有效性
-    if (!node || node->header.isLeaf) return;
-
-    // 找到插入位置
-    int pos = node->findKey(kv.getKey());
-
-    // 插入键值对
-    node->keys.insert(node->keys.begin() + pos, kv);
-    node->header.keyCount++;
-
-    // 插入右子节点指针
-    if (rightChildId != -1) {
-        node->children.insert(node->children.begin() + pos + 1, rightChildId);
-    }
-
-    // 标记为脏页
-    node->dirty = true;
-    if (bufferPool) {
-        bufferPool->markDirty(node->header.pageId);
-    }
-}
-
-/**
- * @brief 获取指定键的所有值
- * @param key 要查找的键
- * @return 包含所有匹配值的二维向量
- * 
- * 在B+树中查找指定键的所有值，返回匹配的结果集
- */
-std::vector<std::vector<std::string>> BPlusTree::get(const std::string& key) {
-    std::vector<std::vector<std::string>> result;
-
-    // 查找包含该键的叶子节点
-    auto leaf = findLeafNode(key);
-    if (!leaf) return result;                // 未找到
-
-    // 在叶子节点中查找所有匹配的键值对
-    for (int i = 0; i < leaf->header.keyCount; i++) {
-        if (leaf->keys[i].getKey() == key) {
-            std::vector<std::string> values;
-            values.push_back(leaf->keys[i].getValue());
-            result.push_back(values);        // 添加到结果集
-        }
-    }
-
-    return result;
-}
-
-/**
- * @brief 从B+树中删除指定键
- * @param key 要删除的键
- * @return true 删除成功，false 键不存在
- * 
- * 删除指定键，如果删除后节点过小则进行合并或重分布操作
- */
-bool BPlusTree::remove(const std::string& key) {
-    // 查找包含该键的叶子节点
-    auto leaf = findLeafNode(key);
-    if (!leaf) return false;                 // 键不存在
-
-    // 在叶子节点中查找键的位置
-    int pos = leaf->findKey(key);
-    if (pos >= leaf->header.keyCount || leaf->keys[pos].getKey() != key) {
-        return false;                        // 键不存在
-    }
-
-    // 删除键
-    leaf->removeKey(pos);
-    if (bufferPool) {
-        bufferPool->markDirty(leaf->header.pageId);  // 标记为脏页
-    }
-
-    // 检查是否需要处理下溢（节点过小）
-    int minKeys = MAX_KEYS_PER_PAGE / 2;
-    if (leaf->header.keyCount < minKeys &&
-        leaf->header.pageId != metadata.rootPageId) {
-        handleUnderflow(leaf);               // 处理节点下溢
-    }
-
-    return true;
-}
-
-/**
- * @brief 处理节点下溢（合并或重分布）
- * @param node 发生下溢的节点
- * 
- * 当节点中的键数量少于最小要求时，通过合并或重分布来维护B+树的性质
- */
-void BPlusTree::handleUnderflow(std::shared_ptr<BPlusTreeNode> node) {
-    if (!node) return;
-
-    int minKeys = MAX_KEYS_PER_PAGE / 2;
-
-    // 检查节点是否真的需要处理下溢
-    if (node->header.keyCount >= minKeys) {
-        return;                              // 键数量足够，无需处理
-    }
-
-    // 处理根节点的特殊情况
-    if (node->header.pageId == metadata.rootPageId) {
-        // 如果根节点是内部节点且为空，则将其唯一子节点提升为新根
-        if (!node->header.isLeaf && node->header.keyCount == 0 &&
-            !node->children.empty() && node->children[0] != -1) {
-            metadata.rootPageId = node->children[0];
-            auto newRoot = loadPage(metadata.rootPageId);
-            if (newRoot) {
-                newRoot->header.parentId = -1;  // 新根无父节点
-                if (bufferPool) {
-                    bufferPool->markDirty(newRoot->header.pageId);
-                }
-            }
-            saveMetadata();
-            metadata.pageCount--;            // 减少页面计数
-        }
-        return;
-    }
-
-    // 加载父节点
-    auto parent = loadPage(node->header.parentId);
-    if (!parent) return;
-
-    // 在父节点中找到当前节点的位置
-    int nodeIndex = -1;
-    for (int i = 0; i < (int)parent->children.size(); i++) {
-        if (parent->children[i] == node->header.pageId) {
-            nodeIndex = i;
-            break;
-        }
-    }
-    if (nodeIndex == -1) return;             // 未找到节点位置
-
-    // 尝试从左兄弟节点借键
-    if (nodeIndex > 0) {
-        auto leftSibling = loadPage(parent->children[nodeIndex - 1]);
-        if (leftSibling && leftSibling->header.keyCount > minKeys) {
-            redistributeFromLeft(node, leftSibling, parent, nodeIndex - 1);
-            return;
-        }
-    }
-
-    // 尝试从右兄弟节点借键
-    if (nodeIndex < (int)parent->children.size() - 1) {
-        auto rightSibling = loadPage(parent->children[nodeIndex + 1]);
-        if (rightSibling && rightSibling->header.keyCount > minKeys) {
-            redistributeFromRight(node, rightSibling, parent, nodeIndex);
-            return;
-        }
-    }
-
-    // 无法借键，尝试与左兄弟合并
-    if (nodeIndex > 0) {
-        auto leftSibling = loadPage(parent->children[nodeIndex - 1]);
-        if (leftSibling) {
-            mergeNodes(leftSibling, node, parent, nodeIndex - 1);
-            return;
-        }
-    }
-
-    // 尝试与右兄弟合并
-    if (nodeIndex < (int)parent->children.size() - 1) {
-        auto rightSibling = loadPage(parent->children[nodeIndex + 1]);
-        if (rightSibling) {
-            mergeNodes(node, rightSibling, parent, nodeIndex);
-            return;
-        }
-    }
-}
-
-/**
- * @brief 从左兄弟节点重分布键
- * @param node 目标节点
- * @param leftSibling 左兄弟节点
- * @param parent 父节点
- * @param parentKeyIndex 父节点中的键索引
- * 
- * 从左兄弟节点借一个键来增加目标节点的键数量
- */
-void BPlusTree::redistributeFromLeft(std::shared_ptr<BPlusTreeNode> node,
-                                     std::shared_ptr<BPlusTreeNode> leftSibling,
-                                     std::shared_ptr<BPlusTreeNode> parent,
-                                     int parentKeyIndex) {
-    if (node->header.isLeaf) {
-        // 叶子节点重分布
-        // 将左兄弟的最后一个键移动到当前节点的开头
-        node->keys.insert(node->keys.begin(), leftSibling->keys.back());
-        leftSibling->keys.pop_back();
-        leftSibling->header.keyCount--;
-        node->header.keyCount++;
-
-        // 更新父节点中的分隔键为当前节点的第一个键
-        parent->keys[parentKeyIndex] = node->keys[0];
-    } else {
-        // 内部节点重分布
-        // 将父节点的键下降到当前节点
-        node->keys.insert(node->keys.begin(), parent->keys[parentKeyIndex]);
-        node->header.keyCount++;
-
-        // 将左兄弟的最后一个键上升到父节点
-        parent->keys[parentKeyIndex] = leftSibling->keys.back();
-        leftSibling->keys.pop_back();
-        leftSibling->header.keyCount--;
-
-        // 移动对应的子节点指针
-        node->children.insert(node->children.begin(),
-                              leftSibling->children.back());
-        leftSibling->children.pop_back();
-
-        // 更新移动的子节点的父节点引用
-        if (node->children[0] != -1) {
-            auto child = loadPage(node->children[0]);
-            if (child) {
-                child->header.parentId = node->header.pageId;
-                if (bufferPool) {
-                    bufferPool->markDirty(child->header.pageId);
-                }
-            }
-        }
-    }
-
-    // 标记相关节点为脏页
-    if (bufferPool) {
-        bufferPool->markDirty(node->header.pageId);
-        bufferPool->markDirty(leftSibling->header.pageId);
-        bufferPool->markDirty(parent->header.pageId);
-    }
-}
-
-/**
- * @brief 从右兄弟节点重分布键
- * @param node 目标节点
- * @param rightSibling 右兄弟节点
- * @param parent 父节点
- * @param parentKeyIndex 父节点中的键索引
- * 
- * 从右兄弟节点借一个键来增加目标节点的键数量
- */
-void BPlusTree::redistributeFromRight(
-    std::shared_ptr<BPlusTreeNode> node,
-    std::shared_ptr<BPlusTreeNode> rightSibling,
-    std::shared_ptr<BPlusTreeNode> parent, int parentKeyIndex) {
-    if (node->header.isLeaf) {
-        // 叶子节点重分布
-        // 将右兄弟的第一个键移动到当前节点的末尾
-        node->keys.push_back(rightSibling->keys[0]);
-        rightSibling->keys.erase(rightSibling->keys.begin());
-        rightSibling->header.keyCount--;
-        node->header.keyCount++;
-
-        // 更新父节点中的分隔键为右兄弟的第一个键
-        parent->keys[parentKeyIndex] = rightSibling->keys[0];
-    } else {
-        // 内部节点重分布
-        // 将父节点的键下降到当前节点
-        node->keys.push_back(parent->keys[parentKeyIndex]);
-        node->header.keyCount++;
-
-        // 将右兄弟的第一个键上升到父节点
-        parent->keys[parentKeyIndex] = rightSibling->keys[0];
-        rightSibling->keys.erase(rightSibling->keys.begin());
-        rightSibling->header.keyCount--;
-
-        // 移动对应的子节点指针
-        node->children.push_back(rightSibling->children[0]);
-        rightSibling->children.erase(rightSibling->children.begin());
-
-        // 更新移动的子节点的父节点引用
-        if (node->children.back() != -1) {
-            auto child = loadPage(node->children.back());
-            if (child) {
-                child->header.parentId = node->header.pageId;
-                if (bufferPool) {
-                    bufferPool->markDirty(child->header.pageId);
-                }
-            }
-        }
-    }
-
-    // 标记相关节点为脏页
-    if (bufferPool) {
-        bufferPool->markDirty(node->header.pageId);
-        bufferPool->markDirty(rightSibling->header.pageId);
-        bufferPool->markDirty(parent->header.pageId);
-    }
-}
-
-/**
- * @brief 合并两个节点
- * @param leftNode 左节点
- * @param rightNode 右节点
- * @param parent 父节点
- * @param parentKeyIndex 父节点中要删除的键索引
- * 
- * 将右节点的所有键和子节点合并到左节点中，然后删除右节点
- */
-void BPlusTree::mergeNodes(std::shared_ptr<BPlusTreeNode> leftNode,
-                           std::shared_ptr<BPlusTreeNode> rightNode,
-                           std::shared_ptr<BPlusTreeNode> parent,
-                           int parentKeyIndex) {
-    if (leftNode->header.isLeaf) {
-        // 叶子节点合并
-        // 将右节点的所有键复制到左节点
-        for (const auto& key : rightNode->keys) {
-            leftNode->keys.push_back(key);
-        }
-        leftNode->header.keyCount += rightNode->header.keyCount;
-
-        // 维护叶子节点链表的连接关系
-        leftNode->header.nextLeafId = rightNode->header.nextLeafId;
-    } else {
-        // 内部节点合并
-        // 将父节点的键下降到左节点
-        leftNode->keys.push_back(parent->keys[parentKeyIndex]);
-        leftNode->header.keyCount++;
-
-        // 将右节点的所有键复制到左节点
-        for (const auto& key : rightNode->keys) {
-            leftNode->keys.push_back(key);
-        }
-        leftNode->header.keyCount += rightNode->header.keyCount;
-
-        // 将右节点的所有子节点指针复制到左节点
-        for (int childId : rightNode->children) {
-            leftNode->children.push_back(childId);
-            // 更新子节点的父节点引用
-            if (childId != -1) {
-                auto child = loadPage(childId);
-                if (child) {
-                    child->header.parentId = leftNode->header.pageId;
-                    if (bufferPool) {
-                        bufferPool->markDirty(child->header.pageId);
-                    }
-                }
-            }
-        }
-    }
-
-    // 从父节点删除对应的键
-    parent->removeKey(parentKeyIndex);
-
-    // 标记相关节点为脏页
-    if (bufferPool) {
-        bufferPool->markDirty(leftNode->header.pageId);
-        bufferPool->markDirty(parent->header.pageId);
-    }
-
-    // 更新统计信息
-    metadata.pageCount--;                    // 减少页面计数
-    metadata.mergeCount++;                   // 增加合并计数
-
-    // 检查父节点是否需要处理下溢
-    if (parent->header.keyCount < MAX_KEYS_PER_PAGE / 2) {
-        handleUnderflow(parent);
-    }
-}
-
-/**
- * @brief 获取B+树统计信息
- * @return TreeStats 结构，包含树的各种统计信息
- * 
- * 计算并返回B+树的高度、节点数、填充因子等统计信息
- */
-TreeStats BPlusTree::getStat() {
-    TreeStats stats;
-
-    // 检查树是否为空
-    if (metadata.rootPageId == -1) {
-        return stats;                        // 返回默认统计信息
-    }
-
-    // 加载根节点并计算统计信息
-    auto root = loadPage(metadata.rootPageId);
-    if (root) {
-        stats.height = calculateHeight(root);         // 计算树高度
-        stats.nodeCount = metadata.pageCount;        // 节点总数
-        stats.splitCount = metadata.splitCount;      // 分裂次数
-        stats.mergeCount = metadata.mergeCount;      // 合并次数
-        stats.fillFactor = calculateFillFactor();    // 填充因子
-        stats.fileWriteCount = fileWriteCount;       // 文件写入次数
-    }
-
-    return stats;
-}
-
-/**
- * @brief 计算B+树的高度
- * @param node 起始节点（通常是根节点）
- * @return 树的高度
- * 
- * 从给定节点开始，沿着最左路径计算到叶子节点的高度
- */
-int BPlusTree::calculateHeight(std::shared_ptr<BPlusTreeNode> node) {
-    if (!node) return 0;                     // 空节点高度为0
-
-    int height = 0;
-    auto current = node;
-
-    // 使用迭代而不是递归，沿着最左路径向下
-    while (current && !current->header.isLeaf) {
-        height++;                            // 增加高度计数
-        // 检查子节点的有效性
-        if (current->children.empty() || current->children[0] == -1) {
-            break;                           // 无有效子节点，停止
-        }
-        current = loadPage(current->children[0]);  // 移动到第一个子节点
-    }
-
-    return height + 1;                       // +1 for leaf level
-}
-
-/**
- * @brief 计算B+树的填充因子
- * @return 填充因子（0.0到1.0之间的值）
- * 
- * 遍历整个树，计算所有节点的平均填充程度
- */
-double BPlusTree::calculateFillFactor() {
-    // 检查树是否为空
-    if (metadata.pageCount == 0 || metadata.rootPageId == -1) {
-        return 0.0;                          // 空树的填充因子为0
-    }
-
-    int totalKeys = 0;                       // 总键数
-    int totalCapacity = 0;                   // 总容量
-
-    // 使用队列进行层次遍历
-    std::queue<int> nodeQueue;
-    nodeQueue.push(metadata.rootPageId);
-
-    while (!nodeQueue.empty()) {
-        int pageId = nodeQueue.front();
-        nodeQueue.pop();
-
-        // 加载当前节点
-        auto node = loadPage(pageId);
-        if (!node) continue;                 // 加载失败，跳过
-
-        // 累计键数和容量
-        totalKeys += node->header.keyCount;
-        totalCapacity += MAX_KEYS_PER_PAGE;
-
-        // 对于内部节点，将子节点加入队列
-        if (!node->header.isLeaf) {
-            for (int i = 0;
-                 i <= node->header.keyCount && i < (int)node->children.size();
-                 i++) {
-                if (node->children[i] != -1) {
-                    nodeQueue.push(node->children[i]);
-                }
-            }
-        }
-    }
-
-    // 计算填充因子
-    return totalCapacity > 0 ? (double)totalKeys / totalCapacity : 0.0;
-}
-
-/**
- * @brief 设置缓冲池大小
- * @param size 新的缓冲池大小
- * 
- * 创建新的缓冲池并迁移数据，刷新旧缓冲池中的所有页面
- */
-void BPlusTree::setBufferPoolSize(size_t size) {
-    if (bufferPool) {
-        // 创建新的缓冲池
-        auto newBufferPool = std::make_unique<BufferPool>(size);
-        // 设置保存回调函数
-        newBufferPool->setSaveCallback(
-            [this](std::shared_ptr<BPlusTreeNode> node) {
-                this->savePage(node);
-            });
-
-        // 刷新旧缓冲池中的所有页面
-        bufferPool->flushAllPages();
-        // 切换到新缓冲池
-        bufferPool = std::move(newBufferPool);
-    }
-}
-
-/**
- * @brief 获取缓冲池统计信息
- * @return BufferPool::Stats 缓冲池统计信息
- * 
- * 返回缓冲池的命中率、页面数等统计信息
- */
-BufferPool::Stats BPlusTree::getBufferPoolStats() const {
-    if (bufferPool) {
-        return bufferPool->getStats();       // 返回缓冲池统计信息
-    }
-    return BufferPool::Stats();              // 返回默认统计信息
-}
-
-/**
- * @brief 刷新缓冲池中的所有页面
- * @return 刷新的页面数量
- * 
- * 强制将缓冲池中的所有脏页写回磁盘
- */
-int BPlusTree::flushBuffer() {
-    if (bufferPool) {
-        return bufferPool->flushAllPages();  // 刷新所有页面
-    }
-    return 0;                               // 无缓冲池，返回0
-}
-
-/**
- * @brief 打印缓冲池状态信息
- * 
- * 输出缓冲池的当前状态，用于调试和监控
- */
-void BPlusTree::printBufferPoolStatus() const {
-    if (bufferPool) {
-        bufferPool->printStatus();           // 打印缓冲池状态
-    }
-}
-
-/**
- * @brief 打印整个B+树结构
- * 
- * 以层次结构方式打印整个B+树，用于调试和可视化
- */
-void BPlusTree::printTree() {
-    // 检查树是否为空
-    if (metadata.rootPageId == -1) {
-        std::cout << "Empty tree" << std::endl;
-        return;
-    }
-
-    // 从根节点开始打印
-    auto root = loadPage(metadata.rootPageId);
-    printNode(root, 0);                      // 从第0层开始打印
-}
-
-/**
- * @brief 递归打印节点及其子树
- * @param node 要打印的节点
- * @param level 当前层次（用于缩进）
- * 
- * 递归打印节点信息和其所有子节点，形成树状结构显示
- */
-void BPlusTree::printNode(std::shared_ptr<BPlusTreeNode> node, int level) {
-    if (!node) return;                       // 空节点，直接返回
-
-    // 根据层次打印缩进
-    for (int i = 0; i < level; i++) {
-        std::cout << "  ";                   // 每层缩进2个空格
-    }
-
-    // 打印节点基本信息
-    std::cout << "Page " << node->header.pageId << " ("
-              << (node->header.isLeaf ? "Leaf" : "Internal")
-              << ", Keys: " << node->header.keyCount << "): ";
-
-    // 打印节点中的所有键
-    for (int i = 0; i < node->header.keyCount; i++) {
-        std::cout << node->keys[i].getKey() << " ";
-    }
-    std::cout << std::endl;
-
-    // 对于内部节点，递归打印所有子节点
-    if (!node->header.isLeaf) {
-        for (int i = 0;
-             i <= node->header.keyCount && i < (int)node->children.size();
-             i++) {
-            if (node->children[i] != -1) {
-                auto child = loadPage(node->children[i]);
-                printNode(child, level + 1); // 递归打印子节点，层次+1
-            }
-        }
-    }
+#include "BPlusTree.h"
+
+#include <cassert>
+#include <cstdio>
+#include <limits>
+#include <queue>
+#include <sstream>
+
+// ================================ KeyValueArray 实现================================
+
+static_assert(VALUE_REGION_OFFSET + MAX_KEYS_PER_PAGE * VALUE_SIZE <= PAGE_SIZE,
+              "叶子节点列区域超出页面");
+static_assert(CHILD_REGION_OFFSET + (MAX_KEYS_PER_PAGE + 1) * (int)sizeof(int) <=
+                  PAGE_SIZE,
+              "内部节点列区域超出页面");
+
+// 内部节点读取rowId和值时返回的空字段
+static const char EMPTY_FIELD[VALUE_SIZE] = {0};
+
+/**
+ * @brief 由前缀长度和后缀槽宽计算页面各列区域的排布
+ *
+ * 叶子在前缀为0、槽宽为KEY_SIZE时与未压缩的叶子布局相同，值槽变窄时容量随之增加；
+ * 内部节点的子节点区域比键多一项，并按int对齐
+ */
+KeyValueArray::Layout KeyValueArray::makeLayout(size_t prefixLength,
+                                                size_t suffixWidth, bool leaf,
+                                                size_t valueWidth) {
+    Layout result;
+    result.prefixLength = prefixLength;
+    result.suffixWidth = suffixWidth;
+    result.valueWidth = leaf ? valueWidth : 0;
+    size_t keyRegion = KEY_REGION_OFFSET + prefixLength;
+    if (leaf) {
+        result.capacity = (PAGE_SIZE - keyRegion) /
+                          (suffixWidth + ROW_ID_SIZE + valueWidth);
+        result.rowIdOffset = keyRegion + result.capacity * suffixWidth;
+        result.valueOffset = result.rowIdOffset + result.capacity * ROW_ID_SIZE;
+        result.childOffset = 0;
+    } else {
+        const size_t align = sizeof(int);
+        result.capacity = (PAGE_SIZE - keyRegion - sizeof(int) - (align - 1)) /
+                          (suffixWidth + sizeof(int));
+        result.rowIdOffset = result.valueOffset = 0;
+        result.childOffset =
+            (keyRegion + result.capacity * suffixWidth + align - 1) / align * align;
+    }
+    return result;
+}
+
+KeyValueArray::Layout KeyValueArray::layout() const {
+    static const Layout FIXED_LEAF = makeLayout(0, KEY_SIZE, true);
+    static const Layout FIXED_POINTER_LEAF =
+        makeLayout(0, KEY_SIZE, true, VALUE_POINTER_SIZE);
+    static const Layout FIXED_INTERNAL = {
+        0, KEY_SIZE, MAX_KEYS_PER_PAGE, 0, 0, 0, CHILD_REGION_OFFSET};
+    const PageHeader& header = pageHeader();
+    if (header.suffixWidth <= 0) {
+        if (!header.isLeaf) return FIXED_INTERNAL;
+        return header.separatedValues ? FIXED_POINTER_LEAF : FIXED_LEAF;
+    }
+    return makeLayout(header.prefixLength, header.suffixWidth, header.isLeaf,
+                      header.separatedValues ? VALUE_POINTER_SIZE : VALUE_SIZE);
+}
+
+/**
+ * @brief 能容纳全部记录的最紧凑布局：前缀取所有键的最长公共前缀，
+ *        槽宽取最长后缀+1
+ */
+KeyValueArray::Layout KeyValueArray::tightLayout(
+    const std::vector<KeyValue>& entries, bool leaf, size_t valueWidth) {
+    if (entries.empty()) return makeLayout(0, 1, leaf, valueWidth);
+
+    size_t prefixLength = strlen(entries[0].key);
+    for (const auto& kv : entries) {
+        size_t common = 0;
+        while (common < prefixLength && kv.key[common] == entries[0].key[common]) {
+            common++;
+        }
+        prefixLength = common;
+    }
+    size_t longest = 0;
+    for (const auto& kv : entries) {
+        longest = std::max(longest, strlen(kv.key) - prefixLength);
+    }
+    return makeLayout(prefixLength, longest + 1, leaf, valueWidth);
+}
+
+size_t KeyValueArray::compressedCapacity(const std::vector<KeyValue>& entries,
+                                         size_t valueWidth) {
+    return tightLayout(entries, true, valueWidth).capacity;
+}
+
+bool KeyValueArray::isCompressed() const {
+    return pageHeader().suffixWidth > 0;
+}
+
+void KeyValueArray::enablePrefixCompression() {
+    if (count > 0) return;
+    pageHeader().prefixLength = 0;
+    pageHeader().suffixWidth = 1;
+}
+
+void KeyValueArray::clear() {
+    count = 0;
+    // 内部节点的子节点区域位置依赖键布局，保持不变
+    if (isCompressed() && isLeaf()) {
+        pageHeader().prefixLength = 0;
+        pageHeader().suffixWidth = 1;
+    }
+}
+
+bool KeyValueArray::fitsLayout(const KeyValue& kv) const {
+    if (!isCompressed()) return true;
+    Layout current = layout();
+    return strncmp(kv.key, prefix(), current.prefixLength) == 0 &&
+           strlen(kv.key) - current.prefixLength < current.suffixWidth;
+}
+
+/**
+ * @brief 按新键估算重新排布后的容量
+ *
+ * 前缀缩短到与新键的公共部分，原有后缀相应变长；估算值不大于实际重新排布后的容量
+ */
+size_t KeyValueArray::capacityWith(const KeyValue& kv) const {
+    Layout current = layout();
+    if (!isCompressed()) return current.capacity;
+    if (count == 0) {
+        return tightLayout({kv}, isLeaf(), current.valueWidth).capacity;
+    }
+
+    size_t common = 0;
+    while (common < current.prefixLength && kv.key[common] == prefix()[common]) {
+        common++;
+    }
+    size_t width = std::max(current.suffixWidth + current.prefixLength - common,
+                            strlen(kv.key) - common + 1);
+    return makeLayout(common, width, isLeaf(), current.valueWidth).capacity;
+}
+
+const char* KeyValueArray::rowId(size_t index) const {
+    if (!isLeaf()) return EMPTY_FIELD;
+    return frame + layout().rowIdOffset + index * ROW_ID_SIZE;
+}
+
+const char* KeyValueArray::value(size_t index) const {
+    if (!isLeaf()) return EMPTY_FIELD;
+    Layout current = layout();
+    return frame + current.valueOffset + index * current.valueWidth;
+}
+
+int KeyValueArray::compareKey(size_t index, const char* other) const {
+    Layout current = layout();
+    if (current.prefixLength > 0) {
+        int result = strncmp(prefix(), other, current.prefixLength);
+        if (result != 0) return result;
+        other += current.prefixLength;
+    }
+    return strcmp(suffix(index), other);
+}
+
+std::string KeyValueArray::getKey(size_t index) const {
+    size_t prefixLength = layout().prefixLength;
+    return std::string(prefix(), prefixLength) + suffix(index);
+}
+
+/**
+ * @brief 调整记录数，新增的记录全部清零
+ * @param newCount 新的记录数
+ */
+void KeyValueArray::resize(size_t newCount) {
+    newCount = std::min(newCount, capacity());
+    while (count < newCount) {
+        push_back(KeyValue());
+    }
+    count = newCount;
+}
+
+KeyValue KeyValueArray::get(size_t index) const {
+    Layout current = layout();
+    KeyValue kv;
+    memcpy(kv.key, prefix(), current.prefixLength);
+    memcpy(kv.key + current.prefixLength, suffix(index),
+           std::min(current.suffixWidth, KEY_SIZE - current.prefixLength));
+    memcpy(kv.rowId, rowId(index), ROW_ID_SIZE);
+    if (isLeaf()) {
+        memcpy(kv.value, value(index), current.valueWidth);
+    }
+    return kv;
+}
+
+/**
+ * @brief 按给定布局写入第index条记录；内部节点只写入键
+ */
+void KeyValueArray::writeEntry(size_t index, const KeyValue& kv,
+                               const Layout& current) {
+    char* slot = frame + KEY_REGION_OFFSET + current.prefixLength +
+                 index * current.suffixWidth;
+    memset(slot, 0, current.suffixWidth);
+    memcpy(slot, kv.key + current.prefixLength,
+           std::min(strlen(kv.key) - current.prefixLength,
+                    current.suffixWidth - 1));
+    if (isLeaf()) {
+        memcpy(frame + current.rowIdOffset + index * ROW_ID_SIZE, kv.rowId,
+               ROW_ID_SIZE);
+        char* slot = frame + current.valueOffset + index * current.valueWidth;
+        memset(slot, 0, current.valueWidth);
+        memcpy(slot, kv.value, strnlen(kv.value, current.valueWidth - 1));
+        if (current.valueWidth == VALUE_SIZE) {
+            slot[VALUE_SIZE - 1] = kv.value[VALUE_SIZE - 1];  // 溢出指针标记
+        }
+    }
+}
+
+/**
+ * @brief 覆盖第index条记录，压缩叶子中放不下新键时重新排布
+ */
+void KeyValueArray::set(size_t index, const KeyValue& kv) {
+    if (fitsLayout(kv)) {
+        writeEntry(index, kv, layout());
+        return;
+    }
+    std::vector<KeyValue> entries = toVector();
+    entries[index] = kv;
+    if (!rebuild(entries)) {
+        std::cerr << "Warning: Page frame has no room for the new key layout"
+                  << std::endl;
+    }
+}
+
+/**
+ * @brief 原位置更新rowId，超长部分截断
+ */
+void KeyValueArray::setRowId(size_t index, const std::string& rowId) {
+    if (!isLeaf()) return;
+    char* slot = frame + layout().rowIdOffset + index * ROW_ID_SIZE;
+    memset(slot, 0, ROW_ID_SIZE);
+    memcpy(slot, rowId.data(),
+           std::min(rowId.length(), (size_t)ROW_ID_SIZE - 1));
+}
+
+/**
+ * @brief 原位置更新值，超出值槽的部分截断
+ */
+void KeyValueArray::setValue(size_t index, const std::string& value) {
+    if (!isLeaf()) return;
+    Layout current = layout();
+    char* slot = frame + current.valueOffset + index * current.valueWidth;
+    memset(slot, 0, current.valueWidth);
+    memcpy(slot, value.data(),
+           std::min(value.length(), current.valueWidth - 1));
+}
+
+void KeyValueArray::shift(size_t index, int shift) {
+    Layout current = layout();
+    size_t moved = count - index;
+    size_t width = current.suffixWidth;
+    char* keys = frame + KEY_REGION_OFFSET + current.prefixLength;
+    memmove(keys + (index + shift) * width, keys + index * width, moved * width);
+    if (isLeaf()) {
+        char* rowIds = frame + current.rowIdOffset;
+        char* values = frame + current.valueOffset;
+        memmove(rowIds + (index + shift) * ROW_ID_SIZE,
+                rowIds + index * ROW_ID_SIZE, moved * ROW_ID_SIZE);
+        size_t valueWidth = current.valueWidth;
+        memmove(values + (index + shift) * valueWidth,
+                values + index * valueWidth, moved * valueWidth);
+    }
+}
+
+bool KeyValueArray::rebuild(const std::vector<KeyValue>& entries) {
+    Layout current = layout();
+    Layout target = tightLayout(entries, isLeaf(), current.valueWidth);
+    if (entries.size() > target.capacity) return false;
+
+    // 内部节点的子节点区域随键区域移动，先保存到临时缓冲区
+    size_t childBytes = 0;
+    char children[PAGE_SIZE];
+    if (!isLeaf()) {
+        childBytes = (std::min(current.capacity, target.capacity) + 1) * sizeof(int);
+        memcpy(children, frame + current.childOffset, childBytes);
+    }
+
+    PageHeader& header = pageHeader();
+    header.prefixLength = static_cast<short>(target.prefixLength);
+    header.suffixWidth = static_cast<short>(target.suffixWidth);
+    if (!entries.empty()) {
+        memcpy(frame + KEY_REGION_OFFSET, entries[0].key, target.prefixLength);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        writeEntry(i, entries[i], target);
+    }
+    if (childBytes > 0) {
+        memcpy(frame + target.childOffset, children, childBytes);
+    }
+    count = entries.size();
+    return true;
+}
+
+/**
+ * @brief 在index处插入记录，三列分别在页面帧内移动；
+ *        压缩叶子中新键改变前缀或槽宽时整页重新排布
+ */
+void KeyValueArray::insert(size_t index, const KeyValue& kv) {
+    if (fitsLayout(kv) && count < capacity()) {
+        shift(index, 1);
+        count++;
+        writeEntry(index, kv, layout());
+        return;
+    }
+
+    if (isCompressed()) {
+        std::vector<KeyValue> entries = toVector();
+        entries.insert(entries.begin() + index, kv);
+        if (rebuild(entries)) return;
+    }
+    std::cerr << "Warning: Page frame has no room for another key" << std::endl;
+}
+
+void KeyValueArray::erase(size_t index) {
+    shift(index + 1, -1);
+    count--;
+}
+
+void KeyValueArray::append(const KeyValueArray& other) {
+    std::vector<KeyValue> entries = toVector();
+    std::vector<KeyValue> appended = other.toVector();
+    entries.insert(entries.end(), appended.begin(), appended.end());
+    assignEntries(entries);
+}
+
+/**
+ * @brief 用entries替换全部记录，压缩叶子只重新排布一次
+ */
+void KeyValueArray::assignEntries(const std::vector<KeyValue>& entries) {
+    if (isCompressed()) {
+        if (!rebuild(entries)) {
+            std::cerr << "Warning: Page frame has no room for the assigned keys"
+                      << std::endl;
+        }
+        return;
+    }
+    count = 0;
+    for (const auto& kv : entries) push_back(kv);
+}
+
+std::vector<KeyValue> KeyValueArray::toVector() const {
+    std::vector<KeyValue> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        result.push_back(get(i));
+    }
+    return result;
+}
+
+// ================================ ChildArray 实现================================
+
+void ChildArray::resize(size_t newCount) {
+    newCount = std::min(newCount, keys.capacity() + 1);
+    for (size_t i = count; i < newCount; i++) {
+        data()[i] = -1;
+    }
+    count = newCount;
+}
+
+void ChildArray::insert(iterator pos, int childId) {
+    if (count >= keys.capacity() + 1) {
+        std::cerr << "Warning: Page frame has no room for another child"
+                  << std::endl;
+        return;
+    }
+    memmove(pos + 1, pos, (end() - pos) * sizeof(int));
+    *pos = childId;
+    count++;
+}
+
+void ChildArray::erase(iterator pos) {
+    memmove(pos, pos + 1, (end() - pos - 1) * sizeof(int));
+    count--;
+}
+
+// ================================ BPlusTreeNode 实现================================
+
+/**
+ * @brief BPlusTreeNode 构造函数
+ * @param pageId 页面ID，用于唯一标识此节点
+ * @param isLeaf 是否为叶子节点的标志
+ * 
+ * 分配对齐的页面帧并初始化页面头，键和子节点都直接存放在帧中
+ */
+BPlusTreeNode::BPlusTreeNode(int pageId, bool isLeaf)
+    : frame(allocateAligned(PAGE_SIZE, PAGE_ALIGNMENT)),
+      header(*reinterpret_cast<PageHeader*>(frame)),
+      keys(frame),
+      children(frame, keys),
+      dirty(false) {
+    memset(frame, 0, PAGE_SIZE);
+
+    // 设置页面头信息
+    header.pageId = pageId;           // 设置页面唯一标识符
+    header.isLeaf = isLeaf;           // 标记节点类型（叶子或内部节点）
+    header.keyCount = 0;              // 初始化键数量为0
+    header.parentId = -1;             // 初始化父节点ID为-1（表示无父节点）
+    header.nextLeafId = -1;           // 初始化下一个叶子节点ID为-1
+    lastInsertPos = -1;
+}
+
+BPlusTreeNode::~BPlusTreeNode() { freeAligned(frame); }
+
+/**
+ * @brief 页面数据读入frame后恢复视图状态
+ *
+ * 键数取自页面头，内部节点的子节点数为键数+1
+ */
+void BPlusTreeNode::attachFrame() {
+    keys.count = std::min((size_t)std::max(header.keyCount, 0), keys.capacity());
+    children.count = header.isLeaf ? 0 : keys.count + 1;
+    lastInsertPos = -1;
+    dirty = false;
+}
+
+/**
+ * @brief 将节点数据复制到缓冲区
+ * @param buffer 目标缓冲区，大小必须为PAGE_SIZE
+ * 
+ * 节点本身就是页面帧，读写磁盘时直接使用frame；
+ * 该函数只用于需要独立副本的场合
+ */
+void BPlusTreeNode::serialize(char* buffer) const {
+    memcpy(buffer, frame, PAGE_SIZE);
+}
+
+/**
+ * @brief 从缓冲区复制页面数据
+ * @param buffer 源缓冲区，包含完整页面
+ */
+void BPlusTreeNode::deserialize(const char* buffer) {
+    memcpy(frame, buffer, PAGE_SIZE);
+    attachFrame();
+}
+
+/**
+ * @brief 检查节点是否已满
+ * @return true 如果节点已满，false 否则
+ * 
+ * 判断节点中的键数量是否达到最大限制，
+ * 用于决定是否需要进行节点分裂操作
+ */
+bool BPlusTreeNode::isFull() const {
+    // 当键数量达到最大值时认为已满，前缀压缩的叶子按当前布局的容量判断
+    return header.keyCount >= (int)keys.capacity();
+}
+
+/**
+ * @brief 在节点中查找键的插入位置
+ * @param key 要查找的键值
+ * @return 键应该插入的位置索引
+ * 
+ * 使用二分查找算法在有序键数组中找到指定键的位置，
+ * 如果键存在则返回其位置，否则返回应该插入的位置
+ */
+int BPlusTreeNode::findKey(const std::string& key) const {
+    int left = 0;                            // 搜索范围左边界
+    int right = header.keyCount;             // 搜索范围右边界
+
+    // 前缀压缩的叶子先比较一次公共前缀，之后只在后缀上二分
+    KeyValueArray::Layout current = keys.layout();
+    const char* target = key.c_str();
+    if (current.prefixLength > 0) {
+        int result = strncmp(target, keys.prefix(), current.prefixLength);
+        if (result != 0) return result < 0 ? 0 : header.keyCount;
+        target += current.prefixLength;
+    }
+    const char* slots = frame + KEY_REGION_OFFSET + current.prefixLength;
+
+    // 二分查找循环
+    while (left < right) {
+        int mid = left + (right - left) / 2; // 计算中点，防止溢出
+
+        // 比较中点键值与目标键值
+        if (strcmp(slots + mid * current.suffixWidth, target) >= 0) {
+            right = mid;                     // 目标在左半部分
+        } else {
+            left = mid + 1;                  // 目标在右半部分
+        }
+    }
+
+    return left;                             // 返回插入位置
+}
+
+/**
+ * @brief 在节点中插入键值对
+ * @param kv 要插入的键值对
+ * @param childId 相关的子节点ID（仅对内部节点有效，默认为-1）
+ * 
+ * 在节点的正确位置插入新的键值对，保持键的有序性，
+ * 对于内部节点还需要插入对应的子节点指针
+ */
+void BPlusTreeNode::insertKey(const KeyValue& kv, int childId) {
+    // 检查是否还有空间进行插入
+    if (!keys.canInsert(kv)) {
+        std::cerr << "Warning: Attempting to insert into full node"
+                  << std::endl;
+        return;                              // 节点已满，无法插入
+    }
+
+    // 找到键值对应该插入的位置
+    int pos = findKey(kv.getKey());
+
+    // 在指定位置插入键值对，保持有序性
+    keys.insert(pos, kv);
+    header.keyCount++;                       // 增加键计数
+    lastInsertPos = pos;
+
+    // 对于内部节点，需要插入对应的子节点指针
+    if (!header.isLeaf && childId != -1) {
+        // 子节点指针插入在键的右侧
+        children.insert(children.begin() + pos + 1, childId);
+    }
+
+    // 标记节点为脏状态（已修改）
+    dirty = true;
+}
+
+/**
+ * @brief 从节点中删除指定索引的键
+ * @param index 要删除的键的索引位置
+ * 
+ * 删除指定位置的键值对，对于内部节点还需要删除对应的子节点指针，
+ * 删除后保持数组的连续性
+ */
+void BPlusTreeNode::removeKey(int index) {
+    // 检查索引有效性
+    if (index >= 0 && index < header.keyCount) {
+        // 删除指定位置的键
+        keys.erase(index);
+        header.keyCount--;                   // 减少键计数
+
+        // 对于内部节点，删除对应的子节点指针
+        if (!header.isLeaf && index < (int)children.size()) {
+            // 删除键右侧的子节点指针
+            children.erase(children.begin() + index + 1);
+        }
+
+        // 标记节点为脏状态（已修改）
+        dirty = true;
+    }
+}
+
+/**
+ * @brief 分裂节点
+ * @param newNode 新创建的节点，用于存放分裂后的右半部分数据
+ * @param promotedKey 输出参数，返回需要上提到父节点的键
+ * @param splitPoint 左节点保留的键数，-1表示均分
+ * 
+ * 将当前节点分裂为两个节点，当前节点保留左半部分，
+ * 新节点存储右半部分，并确定需要上提到父节点的键
+ */
+void BPlusTreeNode::split(std::shared_ptr<BPlusTreeNode> newNode,
+                          KeyValue& promotedKey, int splitPoint) {
+    // 使用更优化的分裂策略
+    int totalKeys = header.keyCount;         // 总键数
+    int mid;                                 // 分裂点
+
+    if (header.isLeaf) {
+        // 叶子节点：尽可能均匀分裂
+        mid = (totalKeys + 1) / 2;          // 向上取整，右边可能多1个
+        if (splitPoint >= 0) {
+            // 两侧至少各保留一个键
+            mid = std::max(1, std::min(splitPoint, totalKeys - 1));
+        }
+    } else {
+        // 内部节点：中间键要上提，所以分裂点不同
+        mid = totalKeys / 2;                // 向下取整
+        if (splitPoint >= 0) {
+            // keys[mid]上提，两侧至少各保留一个键
+            mid = std::max(1, std::min(splitPoint, totalKeys - 2));
+        }
+    }
+    lastInsertPos = -1;
+
+    if (header.isLeaf) {
+        // 叶子节点分裂处理
+        // 将右半部分的键复制到新节点，两侧按各自的记录重新计算压缩布局
+        std::vector<KeyValue> entries = keys.toVector();
+        keys.assign(entries.begin(), entries.begin() + mid);
+        newNode->keys.assign(entries.begin() + mid, entries.end());
+        newNode->header.keyCount = header.keyCount - mid;
+
+        // 维护叶子节点链表的连接关系
+        newNode->header.nextLeafId = header.nextLeafId;  // 新节点指向原节点的下一个
+        header.nextLeafId = newNode->header.pageId;      // 原节点指向新节点
+
+        // 叶子节点分裂时，上提的键是右边第一个键的副本
+        if (newNode->header.keyCount > 0) {
+            promotedKey = newNode->keys.front();
+        }
+    } else {
+        // 内部节点分裂处理
+        if (mid < header.keyCount) {
+            promotedKey = keys.get(mid);     // 中间键上提到父节点
+        }
+
+        // 右边节点获得mid+1到end的键（跳过上提的中间键）
+        for (int i = mid + 1; i < header.keyCount; i++) {
+            newNode->keys.push_back(keys.get(i));
+        }
+        newNode->header.keyCount = header.keyCount - mid - 1;
+
+        // 移动对应的子指针到新节点
+        for (int i = mid + 1; i <= header.keyCount && i < (int)children.size();
+             i++) {
+            newNode->children.push_back(children[i]);
+        }
+    }
+
+    // 调整当前节点大小，保留左半部分
+    keys.resize(mid);
+    header.keyCount = mid;
+    if (!header.isLeaf) {
+        children.resize(mid + 1);            // 内部节点保留mid+1个子指针
+    }
+
+    // 标记两个节点都为脏状态
+    dirty = true;
+    newNode->dirty = true;
+}
+
+// ================================ 写优化消息缓冲辅助函数 ================================
+
+/**
+ * @brief 把一个键的消息追加到缓冲
+ *
+ * PUT和DELETE覆盖该键之前的所有消息，UPSERT依赖之前的值，追加在后面
+ */
+static void appendMessage(MessageBuffer& buffer, const std::string& key,
+                          BufferedMessage message) {
+    auto& messages = buffer[key];
+    if (message.type != BufferedMessage::Type::UPSERT) {
+        messages.clear();
+    }
+    messages.push_back(std::move(message));
+}
+
+/**
+ * @brief 按写入顺序把消息应用到一条记录上
+ * @param messages 同一键的消息
+ * @param record 输入输出的记录（键和rowId）
+ * @param value 输入输出的完整值
+ * @param exists 记录原来是否存在
+ * @param maxValueLength 值的最大长度，与写入叶子时的截断一致
+ * @return 应用后记录是否存在
+ *
+ * 每一步都按maxValueLength截断，与逐条写入叶子得到的结果一致
+ */
+static bool applyBufferedMessages(const std::vector<BufferedMessage>& messages,
+                                  KeyValue& record, std::string& value,
+                                  bool exists, size_t maxValueLength) {
+    auto clamp = [maxValueLength](const std::string& v) {
+        if (maxValueLength == std::string::npos) return v;
+        return std::string(v.c_str(), std::min(strlen(v.c_str()), maxValueLength));
+    };
+    for (const auto& message : messages) {
+        switch (message.type) {
+            case BufferedMessage::Type::PUT:
+                record = KeyValue(record.getKey(), message.rowId, "");
+                value = clamp(message.value);
+                exists = true;
+                break;
+            case BufferedMessage::Type::DELETE:
+                exists = false;
+                break;
+            case BufferedMessage::Type::UPSERT: {
+                std::string merged = message.mergeFn(exists ? &value : nullptr);
+                std::string rowId = message.rowId.empty() && exists
+                                        ? record.getRowId()
+                                        : message.rowId;
+                record = KeyValue(record.getKey(), rowId, "");
+                value = clamp(merged);
+                exists = true;
+                break;
+            }
+        }
+    }
+    return exists;
+}
+
+/**
+ * @brief 内部节点中键所属的子节点下标，与findLeafNode一致
+ */
+static int routeChild(const BPlusTreeNode& node, const std::string& key) {
+    int pos = node.findKey(key);
+    if (pos < node.header.keyCount && node.keys.compareKey(pos, key) == 0) {
+        pos++;                               // 等于分隔键时进入右子树
+    }
+    return std::min(pos, (int)node.children.size() - 1);
+}
+
+// ================================ 溢出页辅助函数 ================================
+
+// 溢出指针占满整个值槽：8位十六进制首个溢出页ID（0表示没有溢出页）+ 8位十六进制
+// 总长度，之后是以0结尾的值前缀，值槽末字节为OVERFLOW_SLOT_MARK。
+// 普通值写入值槽时按VALUE_SIZE-1截断、末字节总为0，已有文件中的值不会被当作指针
+static const size_t OVERFLOW_HEADER_LENGTH = 16;
+static const size_t OVERFLOW_INLINE_PREFIX = VALUE_SIZE - 2 - OVERFLOW_HEADER_LENGTH;
+static const char OVERFLOW_SLOT_MARK = '\x02';
+// 溢出页在页面头之后全部用于保存值，页面之间经nextLeafId串联
+static const size_t OVERFLOW_PAGE_PAYLOAD = PAGE_SIZE - sizeof(PageHeader);
+
+static bool isOverflowPointer(const std::string& stored) {
+    return stored.size() == (size_t)VALUE_SIZE &&
+           stored[VALUE_SIZE - 1] == OVERFLOW_SLOT_MARK &&
+           stored.find_first_not_of("0123456789abcdef") >= OVERFLOW_HEADER_LENGTH;
+}
+
+static bool parseOverflowPointer(const std::string& stored, int& firstPageId,
+                                 size_t& length) {
+    if (!isOverflowPointer(stored)) return false;
+    firstPageId = (int)std::stoul(stored.substr(0, 8), nullptr, 16);
+    length = std::stoul(stored.substr(8, 8), nullptr, 16);
+    return true;
+}
+
+/**
+ * @brief 由溢出指针读出完整的值
+ * @param loadPage 按页面ID读取页面，树和只读快照各自提供
+ * @return false如果stored不是溢出指针
+ *
+ * 溢出链断开时输出错误，返回已读到的部分
+ */
+template <typename LoadPage>
+static bool readOverflowValue(const std::string& stored, std::string& value,
+                              LoadPage loadPage) {
+    int pageId;
+    size_t length;
+    if (!parseOverflowPointer(stored, pageId, length)) return false;
+
+    value = stored.c_str() + OVERFLOW_HEADER_LENGTH;  // 叶子中保存的前缀
+    value.reserve(length);
+    while (value.size() < length && pageId > 0) {
+        auto page = loadPage(pageId);
+        if (!page) break;
+        size_t n = std::min(length - value.size(), OVERFLOW_PAGE_PAYLOAD);
+        value.append(page->frame + sizeof(PageHeader), n);
+        pageId = page->header.nextLeafId;
+    }
+    if (value.size() < length) {
+        std::cerr << "Broken overflow page chain" << std::endl;
+    }
+    return true;
+}
+
+// ================================ BPlusTree 实现
+// ================================
+
+/**
+ * @brief BPlusTree 构造函数
+ * 
+ * 初始化B+树对象，设置初始状态
+ */
+BPlusTree::BPlusTree()
+    : directIO(false),
+      copyOnWrite(false),
+      asyncIO(true),
+      fileWriteCount(0),
+      splitPolicy(SplitPolicy::EVEN),
+      rightmostLeafId(-1),
+      siblingRedistribution(false),
+      mergeThreshold(MAX_KEYS_PER_PAGE / 2),
+      prefixCompression(false),
+      suffixTruncation(false),
+      bloomEnabled(false),
+      bloomExpectedKeys(100000),
+      bloomRejectCount(0),
+      mvccClock(0),
+      retainedVersionCount(0),
+      versionsSinceCollect(0),
+      messageBufferSize(0),
+      messageFlushCount(0),
+      messageApplyFailed(false),
+      valueLogRequested(false),
+      valueLogGcRatio(0.5),
+      overflowRequested(false),
+      residentLevels(0),
+      residentRootId(-1),
+      readAheadMin(2),
+      readAheadMax(32) {
+    registerBuiltinMergeOperators();
+}
+
+/**
+ * @brief BPlusTree 析构函数
+ * 
+ * 清理资源，关闭文件和缓冲池
+ */
+BPlusTree::~BPlusTree() { 
+    close();                                 // 确保资源被正确释放
+}
+
+/**
+ * @brief 创建或打开B+树文件
+ * @param fname 文件名
+ * @param pageSize 页面大小（当前实现中未使用）
+ * @param bufferPoolSize 缓冲池大小
+ * @return true 成功，false 失败
+ * 
+ * 创建新的B+树文件或打开existing文件，初始化缓冲池和元数据
+ */
+bool BPlusTree::create(const std::string& fname, int pageSize,
+                       size_t bufferPoolSize) {
+    filename = fname;                        // 保存文件名
+    rightmostLeafId = -1;                    // 缓存属于之前打开的文件
+    recordCache.clear();
+
+    // 初始化BufferPool，限制缓冲池大小以避免内存问题
+    size_t maxBufferSize = std::min(bufferPoolSize, static_cast<size_t>(1000));
+    bufferPool = std::make_unique<BufferPool>(maxBufferSize);
+
+    // 设置缓冲池的保存回调函数，当页面需要写回磁盘时调用
+    attachBufferPoolCallbacks();
+
+    // 打开存储层，文件不存在时自动创建
+    auto posixStorage = std::make_unique<PosixStorageManager>(
+        PAGE_SIZE, METADATA_SIZE, directIO);
+    bool created = false;
+    if (copyOnWrite) {
+        // 页面经映射表写到新的物理位置，io_uring引擎直接按页面ID计算偏移，
+        // 因此使用经过存储层的同步引擎
+        auto shadowStorage =
+            std::make_shared<ShadowStorageManager>(std::move(posixStorage));
+        if (!shadowStorage->open(filename, created)) {
+            return false;                    // 打开失败或不是写时复制文件
+        }
+        ioEngine = std::make_unique<SyncIOEngine>(*shadowStorage);
+        storage = shadowStorage;
+    } else {
+        if (!posixStorage->open(filename, created)) {
+            return false;                    // 文件打开失败
+        }
+        if (!created && ShadowStorageManager::isShadowFile(*posixStorage)) {
+            std::cerr << filename << " is a copy-on-write file" << std::endl;
+            return false;
+        }
+
+        // 创建I/O引擎，io_uring不可用时回退到同步pread/pwrite
+        ioEngine = createIOEngine(*posixStorage, asyncIO);
+        storage = std::move(posixStorage);
+    }
+
+    if (!created && !loadMetadata()) {
+        // 旧版本或其他程序写的文件，按当前布局解释会读到错误的页面
+        storage->close();
+        ioEngine.reset();
+        storage.reset();
+        bufferPool.reset();
+        return false;
+    }
+    if (created) {
+        // 初始化新的元数据
+        metadata = Metadata();
+        metadata.valueLog = valueLogRequested ? 1 : 0;
+        saveMetadata();                      // 保存初始元数据到文件
+    }
+    if (overflowRequested && !metadata.valueLog && !metadata.overflowPages) {
+        metadata.overflowPages = 1;          // 已有文件同样可以启用
+        saveMetadata();
+    }
+    deferredOverflow.clear();
+    pinUpperLevels();
+
+    // 是否使用值日志由文件创建时的设置决定
+    valueLog.close();
+    if (metadata.valueLog && !valueLog.open(filename + ".vlog")) {
+        return false;
+    }
+
+    // 过滤器文件只在正常关闭时写出，异常退出后重新打开时文件缺失，按现有键重建。
+    // 未启用过滤器的会话也要删除它：该会话的修改不会反映到文件中，
+    // 之后启用过滤器时加载它会漏判新插入的键
+    if (bloomEnabled && (created || !bloomFilter.load(bloomFilterPath()))) {
+        rebuildBloomFilter();
+    }
+    std::remove(bloomFilterPath().c_str());
+    return true;
+}
+
+/**
+ * @brief 设置是否使用O_DIRECT
+ * @param enabled 是否启用直接I/O
+ *
+ * 仅对之后的create调用生效
+ */
+void BPlusTree::setDirectIO(bool enabled) { directIO = enabled; }
+
+/**
+ * @brief 设置是否使用写时复制存储
+ * @param enabled 是否启用
+ *
+ * 仅对之后的create调用生效
+ */
+void BPlusTree::setCopyOnWrite(bool enabled) { copyOnWrite = enabled; }
+
+/**
+ * @brief 提交
+ * @return true如果成功
+ *
+ * 写回脏页和元数据后持久化；写时复制模式下存储层的sync即发布新版本
+ */
+bool BPlusTree::commit() {
+    if (!bufferPool || !storage || !storage->isOpen()) return false;
+    flushAllMessages();
+    completePrefetches(true);
+    if (messageApplyFailed) {
+        messageApplyFailed = false;
+        std::cerr << "Commit aborted: buffered writes could not be stored"
+                  << std::endl;
+        return false;
+    }
+    if (valueLog.isOpen() && !valueLog.sync()) return false;
+
+    // 任一页面写入失败时不能发布：写时复制模式下新版本的映射表会指向未写入的物理页面
+    size_t failedPages = 0;
+    bufferPool->flushAllPages(&failedPages);
+    if (failedPages > 0) {
+        std::cerr << "Commit aborted: " << failedPages
+                  << " page(s) failed to write" << std::endl;
+        return false;
+    }
+    saveMetadata();
+    return storage->sync();
+}
+
+/**
+ * @brief 固定最近一次提交的版本
+ * @return 只读快照
+ */
+BPlusTreeSnapshot BPlusTree::snapshot() {
+    BPlusTreeSnapshot snap;
+    auto shadowStorage = std::dynamic_pointer_cast<ShadowStorageManager>(storage);
+    if (!shadowStorage || !shadowStorage->isOpen()) return snap;
+
+    snap.storage = shadowStorage;
+    snap.version = shadowStorage->pinCommitted();
+    snap.valueFiles = valueLog.files();
+    if (snap.version) {
+        Metadata committed;
+        memcpy(&committed, snap.version->metadata.data(), sizeof(Metadata));
+        snap.rootPageId = committed.rootPageId;
+        snap.overflowPages = committed.overflowPages && !committed.valueLog;
+    }
+    return snap;
+}
+
+/**
+ * @brief 设置是否维护Bloom过滤器
+ * @param enabled 是否启用
+ * @param expectedKeys 过滤器的初始容量
+ *
+ * 仅对之后的create调用生效
+ */
+void BPlusTree::setBloomFilter(bool enabled, size_t expectedKeys) {
+    bloomEnabled = enabled;
+    bloomExpectedKeys = expectedKeys;
+}
+
+/**
+ * @brief 按现有键重建Bloom过滤器
+ *
+ * 沿叶子链表收集全部键，容量取初始容量和两倍键数中的较大者
+ */
+void BPlusTree::rebuildBloomFilter() {
+    std::vector<std::string> keys;
+    for (BPlusTreeCursor cursor = seek(""); cursor.isValid(); cursor.next()) {
+        keys.push_back(cursor.key());
+    }
+    bloomFilter.reset(std::max(bloomExpectedKeys, keys.size() * 2));
+    for (const auto& key : keys) {
+        bloomFilter.add(key);
+    }
+}
+
+/**
+ * @brief 把键加入过滤器，插入数超过容量或失效位过多时先重建
+ */
+void BPlusTree::bloomAdd(const std::string& key) {
+    if (!bloomEnabled) return;
+    if (bloomFilter.needsRebuild()) {
+        rebuildBloomFilter();
+    }
+    bloomFilter.add(key);
+}
+
+/**
+ * @brief 过滤器是否判定键一定不存在
+ */
+bool BPlusTree::bloomRejects(const std::string& key) {
+    if (!bloomEnabled || bloomFilter.mayContain(key)) return false;
+    bloomRejectCount++;
+    return true;
+}
+
+/**
+ * @brief 设置是否使用io_uring异步I/O引擎
+ * @param enabled 是否优先使用io_uring
+ *
+ * 仅对之后的create调用生效
+ */
+void BPlusTree::setAsyncIO(bool enabled) { asyncIO = enabled; }
+
+/**
+ * @brief 获取当前I/O引擎名称
+ */
+const char* BPlusTree::getIOEngineName() const {
+    return ioEngine ? ioEngine->name() : "none";
+}
+
+/**
+ * @brief 设置缓冲池的单页和批量保存回调
+ */
+void BPlusTree::attachBufferPoolCallbacks() {
+    bufferPool->setSaveCallback(
+        [this](std::shared_ptr<BPlusTreeNode> node) { return this->savePage(node); });
+    bufferPool->setBatchSaveCallback(
+        [this](const std::vector<std::shared_ptr<BPlusTreeNode>>& nodes) {
+            return this->savePages(nodes);
+        });
+}
+
+/**
+ * @brief 关闭B+树，释放资源
+ * 
+ * 刷新所有缓冲页面到磁盘，保存元数据，关闭文件
+ */
+void BPlusTree::close() {
+    if (bufferPool) {
+        flushAllMessages();                  // 缓冲的消息应用到叶子
+    }
+    messageBuffers.clear();
+    if (bufferPool) {
+        for (int firstPageId : deferredOverflow) {
+            releaseOverflowChain(firstPageId);  // 快照随树关闭失效
+        }
+    }
+    deferredOverflow.clear();
+    completePrefetches(true);                // 等待所有预取完成
+    if (bloomEnabled && storage && storage->isOpen()) {
+        bloomFilter.save(bloomFilterPath());
+    }
+    if (bufferPool) {
+        bufferPool->flushAllPages();         // 将所有脏页写回磁盘
+        bufferPool.reset();                  // 释放缓冲池
+    }
+    if (valueLog.isOpen()) {
+        valueLog.sync();                     // 叶子引用的值先于页面持久化
+        valueLog.close();
+    }
+    if (storage && storage->isOpen()) {
+        saveMetadata();                      // 保存最新的元数据
+        storage->sync();                     // 持久化到磁盘
+        storage->close();                    // 关闭文件
+    }
+    ioEngine.reset();                        // 引擎引用存储层，先于其释放
+    storage.reset();
+    recordCache.clear();
+    liveSnapshots.clear();                   // 已有快照随树关闭失效
+    versionChains.clear();
+    retainedVersionCount = 0;
+}
+
+/**
+ * @brief 从磁盘加载页面
+ * @param pageId 要加载的页面ID
+ * @return 加载的节点指针，失败时返回nullptr
+ * 
+ * 通过缓冲池管理页面加载，如果页面不在缓冲池中则从磁盘读取
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTree::loadPage(int pageId) {
+    if (!bufferPool) {
+        return nullptr;                      // 缓冲池未初始化
+    }
+
+    // 收割已完成的预取（只读共享内存队列，无系统调用）
+    if (!pendingReads.empty()) {
+        completePrefetches(false);
+    }
+
+    // 通过缓冲池获取页面，如果不存在则使用lambda函数加载
+    auto node = bufferPool->getPage(
+        pageId, [this, pageId]() -> std::shared_ptr<BPlusTreeNode> {
+            // 页面正在被预取，等待其完成而不是重复读取
+            if (this->pendingReads.count(pageId)) {
+                auto prefetched = this->waitPrefetch(pageId);
+                if (prefetched) return prefetched;
+            }
+
+            // 创建新的节点对象
+            auto newNode = std::make_shared<BPlusTreeNode>(pageId);
+
+            // 检查页面ID是否合理
+            if (pageId < 0 || !this->storage) {
+                std::cerr << "Invalid page position: pageId=" << pageId
+                          << std::endl;
+                return nullptr;
+            }
+
+            // 定位读取页面数据，直接读入节点的对齐页面帧
+            if (this->storage->readPage(pageId, newNode->frame)) {
+                newNode->attachFrame();
+            } else {
+                // 未读到数据时返回空节点
+                newNode->header.pageId = pageId;
+                newNode->header.isLeaf = true;
+                newNode->header.keyCount = 0;
+                newNode->header.parentId = -1;
+                newNode->header.nextLeafId = -1;
+                newNode->attachFrame();
+            }
+
+            return newNode;
+        });
+
+    return node;
+}
+
+/**
+ * @brief 保存页面到磁盘
+ * @param node 要保存的节点
+ * 
+ * 将节点的页面帧写入磁盘文件的对应位置
+ * @return true如果页面已写入（或无需写入）
+ */
+bool BPlusTree::savePage(std::shared_ptr<BPlusTreeNode> node) {
+    // 检查节点有效性和是否需要保存
+    if (!node || !node->dirty) return true;
+
+    // 检查位置有效性
+    if (node->header.pageId < 0 || !storage) {
+        std::cerr << "Invalid save position: pageId=" << node->header.pageId
+                  << std::endl;
+        return false;
+    }
+
+    // 节点的页面帧直接写入，无需seek，不依赖共享的文件偏移
+    if (!storage->writePage(node->header.pageId, node->frame)) {
+        return false;
+    }
+    fileWriteCount++;                        // 增加写入计数
+
+    node->dirty = false;                     // 标记为干净状态
+    return true;
+}
+
+/**
+ * @brief 批量保存页面到磁盘
+ * @param nodes 要保存的节点列表
+ * @return 按输入顺序，每个页面是否已写入（或无需写入）
+ *
+ * 直接以各节点的页面帧为写缓冲区，通过I/O引擎一次提交全部写请求
+ */
+std::vector<bool> BPlusTree::savePages(
+    const std::vector<std::shared_ptr<BPlusTreeNode>>& nodes) {
+    std::vector<bool> written(nodes.size(), true);
+    std::vector<size_t> dirtyIndexes;
+    std::vector<std::shared_ptr<BPlusTreeNode>> dirtyNodes;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const auto& node = nodes[i];
+        if (node && node->dirty && node->header.pageId >= 0) {
+            dirtyIndexes.push_back(i);
+            dirtyNodes.push_back(node);
+        } else if (node && node->dirty) {
+            written[i] = savePage(node);     // 无效的页面ID，报告失败
+        }
+    }
+    if (dirtyNodes.empty()) return written;
+
+    // 没有I/O引擎或只有一个页面时退化为单页写
+    if (!ioEngine || dirtyNodes.size() == 1) {
+        for (size_t i = 0; i < dirtyNodes.size(); i++) {
+            written[dirtyIndexes[i]] = savePage(dirtyNodes[i]);
+        }
+        return written;
+    }
+
+    std::vector<PageIORequest> requests(dirtyNodes.size());
+    std::vector<PageIORequest*> batch;
+    batch.reserve(dirtyNodes.size());
+    for (size_t i = 0; i < dirtyNodes.size(); i++) {
+        requests[i] = PageIORequest(PageIORequest::Type::WRITE,
+                                    dirtyNodes[i]->header.pageId,
+                                    dirtyNodes[i]->frame);
+        batch.push_back(&requests[i]);
+    }
+
+    ioEngine->runBatch(batch);
+
+    for (size_t i = 0; i < dirtyNodes.size(); i++) {
+        if (requests[i].success) {
+            fileWriteCount++;                // 增加写入计数
+            dirtyNodes[i]->dirty = false;    // 标记为干净状态
+        } else {
+            std::cerr << "Failed to write page " << requests[i].pageId
+                      << " to disk" << std::endl;
+            written[dirtyIndexes[i]] = false;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief 异步预取页面到缓冲池
+ * @param pageIds 页面ID列表
+ * @return 实际提交的读请求数
+ */
+int BPlusTree::prefetchPages(const std::vector<int>& pageIds) {
+    if (!ioEngine || !bufferPool) return 0;
+
+    std::vector<PageIORequest*> batch;
+    for (int pageId : pageIds) {
+        // 跳过无效、已缓存和正在预取的页面
+        if (pageId < 0 || pageId >= metadata.nextPageId ||
+            bufferPool->containsPage(pageId) || pendingReads.count(pageId)) {
+            continue;
+        }
+
+        // 读请求直接以新节点的页面帧为目标
+        PendingRead& pending = pendingReads[pageId];
+        pending.node = std::make_shared<BPlusTreeNode>(pageId);
+        pending.request = PageIORequest(PageIORequest::Type::READ, pageId,
+                                        pending.node->frame);
+        batch.push_back(&pending.request);
+    }
+
+    if (batch.empty()) return 0;
+
+    // 一次提交所有读请求
+    if (!ioEngine->submit(batch)) {
+        for (PageIORequest* req : batch) {
+            if (!req->completed) {
+                pendingReads.erase(req->pageId);
+            }
+        }
+        return 0;
+    }
+    return static_cast<int>(batch.size());
+}
+
+/**
+ * @brief 收割已完成的预取，将读到的页面放入缓冲池
+ * @param wait 是否等待所有在途预取完成
+ */
+void BPlusTree::completePrefetches(bool wait) {
+    if (!ioEngine || pendingReads.empty()) return;
+
+    std::vector<PageIORequest*> completed;
+    ioEngine->reap(completed, wait ? pendingReads.size() : 0);
+
+    for (PageIORequest* req : completed) {
+        auto it = pendingReads.find(req->pageId);
+        if (it == pendingReads.end()) continue;
+
+        // 期间页面可能已被同步加载或新建，此时丢弃预取结果
+        if (req->success && bufferPool &&
+            !bufferPool->containsPage(req->pageId)) {
+            auto node = it->second.node;
+            node->attachFrame();
+            bufferPool->putPage(req->pageId, node);
+        }
+
+        pendingReads.erase(it);
+    }
+}
+
+/**
+ * @brief 等待指定页面的预取完成
+ * @param pageId 页面ID
+ * @return 预取到的节点；预取失败时返回nullptr，由调用方同步读取
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTree::waitPrefetch(int pageId) {
+    auto it = pendingReads.find(pageId);
+    if (it == pendingReads.end()) return nullptr;
+
+    PageIORequest* req = &it->second.request;
+    ioEngine->wait({req});
+
+    std::shared_ptr<BPlusTreeNode> node;
+    if (req->success) {
+        node = it->second.node;
+        node->attachFrame();
+    }
+
+    pendingReads.erase(it);
+    return node;
+}
+
+/**
+ * @brief 创建新页面
+ * @param isLeaf 是否为叶子节点
+ * @return 新创建的节点指针，失败时返回nullptr
+ * 
+ * 分配新的页面ID，创建新节点，并加入缓冲池管理
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTree::createNewPage(bool isLeaf) {
+    // 检查页面ID是否会溢出
+    if (metadata.nextPageId < 0 || metadata.nextPageId > 10000000) {
+        std::cerr << "Page ID overflow or invalid: " << metadata.nextPageId
+                  << std::endl;
+        return nullptr;
+    }
+
+    // 分配新的页面ID
+    int pageId = metadata.nextPageId++;
+    // 创建新节点
+    auto node = std::make_shared<BPlusTreeNode>(pageId, isLeaf);
+    node->dirty = true;                      // 新节点需要保存
+    if (isLeaf && valueLog.isOpen()) {
+        node->header.separatedValues = true;  // 值槽只保存指针或短值
+    }
+    if (isLeaf ? prefixCompression : suffixTruncation) {
+        node->keys.enablePrefixCompression();
+    }
+
+    // 将新节点加入缓冲池
+    if (bufferPool) {
+        bufferPool->putPage(pageId, node);
+        bufferPool->markDirty(pageId);       // 标记为脏页
+        if (!isLeaf && residentLevels < 0) {
+            bufferPool->makeResident(pageId);
+        }
+    }
+    metadata.pageCount++;                    // 增加页面计数
+
+    return node;
+}
+
+/**
+ * @brief 保存元数据到文件
+ * 
+ * 将B+树的元数据（根页面ID、页面计数等）写入文件头部
+ */
+void BPlusTree::saveMetadata() {
+    if (!storage) return;
+
+    // 写入元数据结构（位于文件开始位置）
+    storage->writeMetadata(reinterpret_cast<const char*>(&metadata));
+}
+
+/**
+ * @brief 从文件加载元数据
+ * @return false 文件标识或格式版本与当前实现不符
+ * 
+ * 从文件头部读取B+树的元数据信息
+ */
+bool BPlusTree::loadMetadata() {
+    // 从文件开始位置读取元数据结构
+    if (!storage || !storage->readMetadata(reinterpret_cast<char*>(&metadata))) {
+        metadata = Metadata();
+        return true;                         // 空文件按新树处理
+    }
+    if (metadata.magic != METADATA_MAGIC ||
+        metadata.formatVersion != FORMAT_VERSION) {
+        std::cerr << filename << " has an unsupported format (magic "
+                  << std::hex << metadata.magic << std::dec << ", version "
+                  << metadata.formatVersion << ")" << std::endl;
+        metadata = Metadata();
+        return false;
+    }
+
+    // 验证元数据的合理性
+    if (metadata.nextPageId < 0 || metadata.pageCount < 0) {
+        std::cout << "Invalid metadata detected, reinitializing..."
+                  << std::endl;
+        metadata = Metadata();              // 重新初始化元数据
+    }
+    return true;
+}
+
+/**
+ * @brief 查找包含指定键的叶子节点
+ * @param key 要查找的键
+ * @param path 可选输出参数，记录途经的内部节点及所选子节点下标
+ * @return 包含该键的叶子节点指针，未找到时返回nullptr
+ * 
+ * 从根节点开始，沿着B+树向下查找，直到找到包含指定键的叶子节点
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTree::findLeafNode(const std::string& key,
+                                                       TreePath* path) {
+    // 检查树是否为空
+    if (metadata.rootPageId == -1) {
+        return nullptr;                      // 空树
+    }
+    if (path) {
+        path->clear();
+    }
+
+    // 树长高或变矮后原来的常驻层不再是最上面的几层
+    if (residentLevels > 0 && residentRootId != metadata.rootPageId) {
+        pinUpperLevels();
+    }
+
+    // 从根节点开始查找
+    auto current = loadPage(metadata.rootPageId);
+
+    // 向下遍历直到叶子节点
+    while (current && !current->header.isLeaf) {
+        // 在当前内部节点中查找键的位置
+        int pos = current->findKey(key);
+
+        // 如果找到相等的键，选择右子树
+        if (pos < current->header.keyCount &&
+            current->keys.compareKey(pos, key) == 0) {
+            pos++;                           // 移动到右子树
+        }
+
+        // 检查子节点数组的有效性
+        if (current->children.empty() || pos >= (int)current->children.size()) {
+            return nullptr;                  // 子节点数组无效
+        }
+        if (pos < 0) {
+            pos = 0;                         // 确保索引非负
+        }
+
+        // 检查子节点ID的有效性
+        if (pos < 0 || current->children[pos] == -1) {
+            return nullptr;                  // 无效的子节点ID
+        }
+
+        if (path) {
+            path->emplace_back(current, pos);  // 记录查找路径
+        }
+
+        // 加载子节点并继续向下查找
+        current = loadPage(current->children[pos]);
+    }
+
+    return current;                          // 返回找到的叶子节点
+}
+
+/**
+ * @brief 插入键值对到B+树
+ * @param key 键
+ * @param value 值数组
+ * @param rowId 行ID
+ * @return true 插入成功，false 插入失败
+ * 
+ * 在B+树中插入新的键值对，如果键已存在则更新值，
+ * 如果节点满了则进行分裂操作
+ */
+bool BPlusTree::insert(const std::string& key,
+                       const std::vector<std::string>& value,
+                       const std::string& rowId) {
+    maybeCollectValueLog();
+
+    // 构造键值对象
+    std::string val = value.empty() ? "" : value[0];
+    KeyValue kv(key, rowId, val);
+    preserveVersion(kv.getKey(), ++mvccClock);
+    bloomAdd(kv.getKey());
+    recordCache.invalidate(kv.getKey());
+
+    // 写优化模式下作为消息写入根节点的缓冲，完整的值应用到叶子时才写入值日志
+    if (messageBufferingActive()) {
+        bufferMessage(kv.getKey(),
+                      {BufferedMessage::Type::PUT, val, kv.getRowId(), nullptr});
+        return true;
+    }
+
+    // 值日志或溢出页模式下叶子只保存指针或短值；确定目标叶子后才写入，
+    // 写入失败时插入失败，叶子不变
+    auto storeFullValue = [&]() {
+        if (!storesFullValues()) return true;
+        std::string stored;
+        if (!storeValue(val, stored)) return false;
+        kv = storedRecord(kv.getKey(), kv.getRowId(), stored);
+        return true;
+    };
+
+    // 处理空树的情况
+    if (metadata.rootPageId == -1) {
+        if (!storeFullValue()) return false;
+        // 创建第一个节点作为根节点（叶子节点）
+        auto root = createNewPage(true);
+        if (!root) return false;             // 创建失败
+
+        // 插入第一个键值对
+        root->insertKey(kv);
+        metadata.rootPageId = root->header.pageId;  // 设置根节点ID
+        saveMetadata();                      // 保存元数据
+        return true;
+    }
+
+    // 键大于最右叶子中的所有键时直接追加，跳过自根向下的查找
+    auto leaf = findAppendLeaf(key);
+    if (leaf) {
+        if (!storeFullValue()) return false;
+        insertIntoLeaf(leaf, kv);
+        return true;
+    }
+
+    // 查找目标叶子节点
+    leaf = findLeafNode(key);
+    if (!leaf) return false;                 // 查找失败
+    if (!storeFullValue()) return false;
+    if (leaf->header.nextLeafId == -1) {
+        rightmostLeafId = leaf->header.pageId;
+    }
+
+    // 在叶子节点中查找键的位置
+    int pos = leaf->findKey(key);
+    if (pos < leaf->header.keyCount && leaf->keys.compareKey(pos, key) == 0) {
+        // 键已存在，更新值（这是原来的正确行为）
+        releaseValue(leaf->keys.getValue(pos));
+        leaf->keys.set(pos, kv);
+        leaf->dirty = true;                  // 标记为脏页
+        if (bufferPool) {
+            bufferPool->markDirty(leaf->header.pageId);
+        }
+        return true;
+    }
+
+    // 插入新键
+    insertIntoLeaf(leaf, kv);
+
+    // 每插入100个键清理一次缓冲池，控制内存使用
+    // 先不管这个，不知道为什么变快了，按理说不应该
+    // static int insertCount = 0;
+    // if (++insertCount % 100 == 0 && bufferPool) {
+    //     bufferPool->flushAllPages();
+    // }
+
+    return true;
+}
+
+/**
+ * @brief 在已定位的叶子中插入新键
+ * @param leaf 目标叶子节点
+ * @param kv 键值对（键不存在于叶子中）
+ */
+void BPlusTree::insertIntoLeaf(std::shared_ptr<BPlusTreeNode> leaf,
+                               const KeyValue& kv) {
+    // 新键缩短了压缩叶子的公共前缀或加宽了键槽，重新排布后仍放不下时先均分该叶子
+    if (!leaf->keys.canInsert(kv)) {
+        handleOverflow(leaf, true);
+        leaf = findLeafNode(kv.getKey());
+        if (!leaf) return;
+    }
+
+    leaf->insertKey(kv);
+    if (bufferPool) {
+        bufferPool->markDirty(leaf->header.pageId);  // 标记为脏页
+    }
+
+    // 检查是否需要分裂
+    if (leaf->isFull()) {
+        handleOverflow(leaf);                // 处理节点溢出
+    }
+}
+
+/**
+ * @brief 顺序追加快速路径：查找可直接追加key的最右叶子
+ * @param key 要插入的键
+ * @return 最右叶子；key不大于其最大键或缓存无效时返回nullptr
+ *
+ * 最右叶子的键范围没有上界，只要key大于其中的最大键就一定属于该叶子
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTree::findAppendLeaf(
+    const std::string& key) {
+    if (rightmostLeafId == -1) return nullptr;
+
+    auto leaf = loadPage(rightmostLeafId);
+    // 缓存的叶子在上次追加后发生过分裂，沿叶子链表前进到新的最右叶子
+    while (leaf && leaf->header.isLeaf && leaf->header.nextLeafId != -1) {
+        leaf = loadPage(leaf->header.nextLeafId);
+    }
+    if (!leaf || !leaf->header.isLeaf || leaf->header.keyCount == 0) {
+        rightmostLeafId = -1;
+        return nullptr;
+    }
+    rightmostLeafId = leaf->header.pageId;
+
+    if (leaf->keys.compareKey(leaf->header.keyCount - 1, key) >= 0) {
+        return nullptr;
+    }
+    return leaf;
+}
+
+/**
+ * @brief 根据分裂策略选择分裂点
+ * @param node 要分裂的节点
+ * @return 左节点保留的键数，-1表示均分
+ */
+int BPlusTree::chooseSplitPoint(const BPlusTreeNode& node) const {
+    int total = node.header.keyCount;
+    switch (splitPolicy) {
+        case SplitPolicy::SKEWED:
+            return total * 9 / 10;
+        case SplitPolicy::ADAPTIVE:
+            if (node.lastInsertPos == total - 1) {
+                // 在末尾插入（顺序递增），左节点保持满，新键进入右节点
+                return node.header.isLeaf ? total - 1 : total - 2;
+            }
+            if (node.lastInsertPos == 0) {
+                // 在开头插入（顺序递减），右节点保持满
+                return 1;
+            }
+            return -1;
+        case SplitPolicy::EVEN:
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief 相邻两个叶子之间的分隔键
+ * @param left 左叶子
+ * @param right 右叶子
+ * @return 未启用截断时为右叶子的第一个键；否则为其中区分左叶子最大键的最短前缀，
+ *         大于左叶子的所有键且不大于右叶子的所有键
+ */
+KeyValue BPlusTree::leafSeparator(const BPlusTreeNode& left,
+                                  const BPlusTreeNode& right) const {
+    KeyValue rightMin = right.keys.front();
+    if (!suffixTruncation || left.keys.empty()) return rightMin;
+
+    KeyValue leftMax = left.keys.back();
+    size_t common = 0;
+    while (leftMax.key[common] != '\0' &&
+           leftMax.key[common] == rightMin.key[common]) {
+        common++;
+    }
+    KeyValue separator;
+    memcpy(separator.key, rightMin.key,
+           std::min(common + 1, (size_t)KEY_SIZE - 1));
+    return separator;
+}
+
+/**
+ * @brief 替换内部节点中的分隔键
+ * @param parent 内部节点
+ * @param index 分隔键下标
+ * @param separator 新的分隔键
+ *
+ * 新键使压缩的内部节点放不下时，删除旧键后按插入处理，必要时分裂该节点
+ */
+void BPlusTree::replaceSeparator(std::shared_ptr<BPlusTreeNode> parent,
+                                 int index, const KeyValue& separator) {
+    if (parent->keys.canReplace(separator)) {
+        parent->keys.set(index, separator);
+        parent->dirty = true;
+        return;
+    }
+
+    int childId = parent->children[index + 1];
+    parent->removeKey(index);
+    insertInternal(parent, separator, childId);
+    if (parent->isFull()) {
+        handleOverflow(parent);
+    }
+}
+
+/**
+ * @brief 设置节点分裂策略
+ * @param policy 分裂策略
+ */
+void BPlusTree::setSplitPolicy(SplitPolicy policy) { splitPolicy = policy; }
+
+/**
+ * @brief 设置分裂前是否先向兄弟节点重分布
+ * @param enabled 是否启用
+ */
+void BPlusTree::setSiblingRedistribution(bool enabled) {
+    siblingRedistribution = enabled;
+}
+
+/**
+ * @brief 把满节点的一部分键移入同一父节点下键较少的兄弟节点
+ * @param node 满节点（非根）
+ * @return true如果移键后节点不再满
+ *
+ * 移动的键数使两个节点大致均衡，每次移动都通过重分布函数同步父节点分隔键
+ */
+bool BPlusTree::shiftToSibling(std::shared_ptr<BPlusTreeNode> node) {
+    auto parent = loadPage(node->header.parentId);
+    if (!parent) return false;
+
+    int nodeIndex = -1;
+    for (int i = 0; i < (int)parent->children.size(); i++) {
+        if (parent->children[i] == node->header.pageId) {
+            nodeIndex = i;
+            break;
+        }
+    }
+    if (nodeIndex == -1) return false;
+
+    std::shared_ptr<BPlusTreeNode> leftSibling;
+    std::shared_ptr<BPlusTreeNode> rightSibling;
+    if (nodeIndex > 0) {
+        leftSibling = loadPage(parent->children[nodeIndex - 1]);
+    }
+    if (nodeIndex < (int)parent->children.size() - 1) {
+        rightSibling = loadPage(parent->children[nodeIndex + 1]);
+    }
+
+    // 接收方移键后不能变满
+    auto hasRoom = [](const std::shared_ptr<BPlusTreeNode>& sibling) {
+        return sibling &&
+               sibling->header.keyCount < (int)sibling->keys.capacity() - 1;
+    };
+    bool useLeft = hasRoom(leftSibling);
+    if (hasRoom(rightSibling) &&
+        (!useLeft ||
+         rightSibling->header.keyCount < leftSibling->header.keyCount)) {
+        useLeft = false;
+    } else if (!useLeft) {
+        return false;
+    }
+
+    auto sibling = useLeft ? leftSibling : rightSibling;
+    int moves =
+        std::max(1, (node->header.keyCount - sibling->header.keyCount) / 2);
+    int moved = 0;
+    int separatorIndex = useLeft ? nodeIndex - 1 : nodeIndex;
+    for (int i = 0; i < moves; i++) {
+        // 替换分隔键可能使父节点分裂，节点不再与兄弟同属该父节点时停止
+        if (node->header.parentId != parent->header.pageId ||
+            sibling->header.parentId != parent->header.pageId) {
+            break;
+        }
+        // 压缩页面接收的键可能改变其前缀或槽宽，放不下时停止移动；
+        // 内部节点接收的是父节点中的分隔键
+        KeyValue incoming = node->header.isLeaf
+                                ? (useLeft ? node->keys.front() : node->keys.back())
+                                : parent->keys.get(separatorIndex);
+        if (!sibling->keys.canInsert(incoming)) break;
+        moved++;
+        if (useLeft) {
+            // 节点的第一个键移到左兄弟末尾
+            redistributeFromRight(leftSibling, node, parent, nodeIndex - 1);
+        } else {
+            // 节点的最后一个键移到右兄弟开头
+            redistributeFromLeft(rightSibling, node, parent, nodeIndex);
+        }
+    }
+
+    if (moved == 0) return false;
+    metadata.redistributionCount++;
+    return !node->isFull();
+}
+
+/**
+ * @brief 叶子节点与一个满兄弟一起分裂为三个节点
+ * @param node 满叶子节点（非根）
+ * @return true如果完成分裂；没有兄弟时返回false，由调用方常规分裂
+ *
+ * 两个节点的键平均分配到三个节点中，每个节点约2/3满；
+ * 新节点插入在右侧节点之后，父节点多一个分隔键
+ */
+bool BPlusTree::splitTwoIntoThree(std::shared_ptr<BPlusTreeNode> node) {
+    auto parent = loadPage(node->header.parentId);
+    if (!parent) return false;
+
+    int nodeIndex = -1;
+    for (int i = 0; i < (int)parent->children.size(); i++) {
+        if (parent->children[i] == node->header.pageId) {
+            nodeIndex = i;
+            break;
+        }
+    }
+    if (nodeIndex == -1 || parent->children.size() < 2) return false;
+
+    // 优先与右兄弟组成一对，最右子节点与左兄弟组成一对
+    int leftIndex =
+        nodeIndex < (int)parent->children.size() - 1 ? nodeIndex : nodeIndex - 1;
+    auto left = loadPage(parent->children[leftIndex]);
+    auto right = loadPage(parent->children[leftIndex + 1]);
+    if (!left || !right) return false;
+
+    auto third = createNewPage(true);
+    if (!third) return false;
+
+    std::vector<KeyValue> entries = left->keys.toVector();
+    std::vector<KeyValue> rightEntries = right->keys.toVector();
+    entries.insert(entries.end(), rightEntries.begin(), rightEntries.end());
+    int total = static_cast<int>(entries.size());
+    int first = total / 3;
+    int second = (total - first) / 2;
+
+    left->keys.assign(entries.begin(), entries.begin() + first);
+    right->keys.assign(entries.begin() + first,
+                       entries.begin() + first + second);
+    third->keys.assign(entries.begin() + first + second, entries.end());
+    left->header.keyCount = first;
+    right->header.keyCount = second;
+    third->header.keyCount = total - first - second;
+    left->lastInsertPos = right->lastInsertPos = -1;
+
+    // 维护叶子链表和父节点分隔键
+    third->header.nextLeafId = right->header.nextLeafId;
+    right->header.nextLeafId = third->header.pageId;
+    replaceSeparator(parent, leftIndex, leafSeparator(*left, *right));
+    // 替换分隔键可能使父节点分裂，新叶子插入right当前所在的父节点
+    parent = loadPage(right->header.parentId);
+    if (!parent) return false;
+    third->header.parentId = parent->header.pageId;
+    insertInternal(parent, leafSeparator(*right, *third), third->header.pageId);
+
+    left->dirty = right->dirty = true;
+    if (bufferPool) {
+        bufferPool->markDirty(left->header.pageId);
+        bufferPool->markDirty(right->header.pageId);
+        bufferPool->markDirty(third->header.pageId);
+        bufferPool->markDirty(parent->header.pageId);
+    }
+
+    metadata.splitCount++;
+    metadata.threeWaySplitCount++;
+    return true;
+}
+
+/**
+ * @brief 读-改-写
+ * @param key 键
+ * @param mergeFn 合并函数
+ * @param rowId 行ID，为空时保留现有行ID
+ * @return true如果成功
+ *
+ * 与get后再insert相比只下降一次，键存在时直接改写叶子中的值
+ */
+bool BPlusTree::upsert(const std::string& key, const MergeFunction& mergeFn,
+                       const std::string& rowId) {
+    if (!mergeFn) return false;
+
+    if (metadata.rootPageId == -1) {
+        return insert(key, {mergeFn(nullptr)}, rowId);
+    }
+    maybeCollectValueLog();
+    std::string storedKey = KeyValue(key, "", "").getKey();
+    preserveVersion(storedKey, ++mvccClock);
+    bloomAdd(storedKey);
+    recordCache.invalidate(storedKey);
+
+    // 写优化模式下合并函数随消息缓冲，应用到叶子时才读取现有值
+    if (messageBufferingActive()) {
+        bufferMessage(storedKey,
+                      {BufferedMessage::Type::UPSERT, "", rowId, mergeFn});
+        return true;
+    }
+
+    auto leaf = findLeafNode(key);
+    if (!leaf) return false;
+
+    int pos = leaf->findKey(key);
+    if (pos < leaf->header.keyCount && leaf->keys.compareKey(pos, key) == 0) {
+        // 原位置更新值
+        std::string stored = leaf->keys.getValue(pos);
+        std::string existing = loadValue(stored);
+        std::string value = mergeFn(&existing);
+        std::string replacement;
+        if (!storeValue(value, replacement)) return false;
+        releaseValue(stored);
+        leaf->keys.set(pos, storedRecord(leaf->keys.getKey(pos),
+                                         rowId.empty() ? leaf->keys.getRowId(pos)
+                                                       : rowId,
+                                         replacement));
+
+        leaf->dirty = true;
+        if (bufferPool) {
+            bufferPool->markDirty(leaf->header.pageId);
+        }
+        return true;
+    }
+
+    std::string stored;
+    if (!storeValue(mergeFn(nullptr), stored)) return false;
+    insertIntoLeaf(leaf, storedRecord(key, rowId, stored));
+    return true;
+}
+
+/**
+ * @brief 注册合并操作符
+ * @param name 操作符名称
+ * @param op 合并操作符
+ */
+void BPlusTree::registerMergeOperator(const std::string& name,
+                                      const MergeOperator& op) {
+    mergeOperators[name] = op;
+}
+
+/**
+ * @brief 使用已注册的合并操作符执行读-改-写
+ * @param key 键
+ * @param opName 操作符名称
+ * @param operand 操作数
+ * @param rowId 行ID
+ * @return true如果成功
+ */
+bool BPlusTree::merge(const std::string& key, const std::string& opName,
+                      const std::string& operand, const std::string& rowId) {
+    auto it = mergeOperators.find(opName);
+    if (it == mergeOperators.end()) {
+        std::cerr << "Unknown merge operator: " << opName << std::endl;
+        return false;
+    }
+
+    // 写优化模式下合并函数可能在本次调用返回后才执行，按值捕获
+    MergeOperator op = it->second;
+    return upsert(
+        key,
+        [op, operand](const std::string* existing) {
+            return op(existing, operand);
+        },
+        rowId);
+}
+
+/**
+ * @brief 注册内置合并操作符
+ *
+ * 数值操作符把无法解析的现有值视为0
+ */
+void BPlusTree::registerBuiltinMergeOperators() {
+    auto toNumber = [](const std::string* s) -> long long {
+        return s ? strtoll(s->c_str(), nullptr, 10) : 0;
+    };
+
+    mergeOperators["add"] = [toNumber](const std::string* existing,
+                                       const std::string& operand) {
+        return std::to_string(toNumber(existing) + toNumber(&operand));
+    };
+    mergeOperators["append"] = [](const std::string* existing,
+                                  const std::string& operand) {
+        return existing ? *existing + operand : operand;
+    };
+    mergeOperators["max"] = [toNumber](const std::string* existing,
+                                       const std::string& operand) {
+        long long value = toNumber(&operand);
+        if (existing) value = std::max(value, toNumber(existing));
+        return std::to_string(value);
+    };
+}
+
+/**
+ * @brief 添加插入操作
+ * @param key 键
+ * @param value 值数组（只使用第一个元素，与insert一致）
+ * @param rowId 行ID
+ */
+void WriteBatch::put(const std::string& key,
+                     const std::vector<std::string>& value,
+                     const std::string& rowId) {
+    std::string val = value.empty() ? "" : value[0];
+    operations.push_back({Operation::Type::PUT, KeyValue(key, rowId, val), val});
+}
+
+/**
+ * @brief 添加删除操作
+ * @param key 键
+ */
+void WriteBatch::remove(const std::string& key) {
+    operations.push_back({Operation::Type::DELETE, KeyValue(key, "", ""), ""});
+}
+
+/**
+ * @brief 应用批量写操作
+ * @param batch 批量写操作
+ * @return true如果全部应用成功
+ */
+bool BPlusTree::write(const WriteBatch& batch) {
+    if (batch.empty()) return true;
+    maybeCollectValueLog();
+
+    // 按键稳定排序，同一键只保留最后一次操作
+    std::vector<const WriteBatch::Operation*> ops;
+    ops.reserve(batch.operations.size());
+    for (const auto& op : batch.operations) {
+        ops.push_back(&op);
+    }
+    std::stable_sort(ops.begin(), ops.end(),
+                     [](const WriteBatch::Operation* a,
+                        const WriteBatch::Operation* b) {
+                         return strcmp(a->kv.key, b->kv.key) < 0;
+                     });
+    size_t unique = 0;
+    for (size_t i = 0; i < ops.size(); i++) {
+        if (unique > 0 && strcmp(ops[unique - 1]->kv.key, ops[i]->kv.key) == 0) {
+            ops[unique - 1] = ops[i];
+        } else {
+            ops[unique++] = ops[i];
+        }
+    }
+    ops.resize(unique);
+
+    // 剩余的页面ID足够整批在最坏情况下分裂，应用阶段分配页面不会失败
+    auto pageIdsAvailable = [&]() {
+        int calculatedHeight = 1;
+        if (metadata.rootPageId != -1) {
+            calculatedHeight = calculateHeight(loadPage(metadata.rootPageId));
+        }
+        long long worstCasePages =
+            (long long)ops.size() / std::max(1, MAX_KEYS_PER_PAGE / 2 - 1) * 2 +
+            calculatedHeight + 2;
+        if (metadata.nextPageId < 0 ||
+            metadata.nextPageId + worstCasePages > 10000000) {
+            std::cerr << "WriteBatch rejected: not enough page IDs" << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    // 写优化模式下整批作为消息写入根节点的缓冲，值在消息应用到叶子时才写入
+    if (messageBufferingActive()) {
+        if (!pageIdsAvailable()) return false;
+        noteBatchWrite(ops);
+        for (const auto* op : ops) {
+            if (op->type == WriteBatch::Operation::Type::PUT) {
+                bufferMessage(op->kv.getKey(),
+                              {BufferedMessage::Type::PUT, op->value,
+                               op->kv.getRowId(), nullptr});
+            } else {
+                bufferMessage(op->kv.getKey(), {BufferedMessage::Type::DELETE,
+                                                "", "", nullptr});
+            }
+        }
+        saveMetadata();
+        return true;
+    }
+
+    // 第一阶段：写入所有的值并为每个目标叶子归并出新内容，不修改任何叶子；
+    // 任一步失败时释放已写入的值，树保持不变
+    std::vector<std::string> added;
+    auto discardAdded = [&]() {
+        for (const auto& value : added) releaseValue(value);
+    };
+    std::vector<KeyValue> records;
+    records.reserve(ops.size());
+    for (const auto* op : ops) {
+        if (op->type != WriteBatch::Operation::Type::PUT || !storesFullValues()) {
+            records.push_back(op->kv);
+            continue;
+        }
+        std::string stored;
+        if (!storeValue(op->value, stored)) {
+            discardAdded();
+            return false;
+        }
+        added.push_back(stored);
+        records.push_back(
+            storedRecord(op->kv.getKey(), op->kv.getRowId(), stored));
+    }
+
+    // 溢出页已分配，检查余下的页面ID；空树时创建根叶子
+    if (!pageIdsAvailable()) {
+        discardAdded();
+        return false;
+    }
+    if (metadata.rootPageId == -1) {
+        auto root = createNewPage(true);
+        if (!root) {
+            discardAdded();
+            return false;
+        }
+        metadata.rootPageId = root->header.pageId;
+    }
+
+    // 每组只查找一次叶子，并由查找路径得到该叶子的键上界。
+    // 持有的叶子正在使用，缓冲池不会淘汰，应用时仍是同一个对象
+    struct LeafGroup {
+        std::shared_ptr<BPlusTreeNode> leaf;
+        std::vector<KeyValue> merged;     // 归并后的叶子内容
+        std::vector<std::string> replaced;  // 被覆盖或删除的值，应用后释放
+        std::string firstKey;             // 含删除的组应用后按该键检查下溢
+        bool removed;
+    };
+    std::vector<LeafGroup> groups;
+    size_t i = 0;
+    while (i < ops.size()) {
+        TreePath path;
+        auto leaf = findLeafNode(ops[i]->kv.getKey(), &path);
+        if (!leaf) {
+            discardAdded();
+            return false;
+        }
+
+        std::string upperBound;
+        bool bounded = false;
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            if (it->second < it->first->header.keyCount) {
+                upperBound = it->first->keys.getKey(it->second);
+                bounded = true;
+                break;
+            }
+        }
+
+        // 归并叶子中的现有记录和落在该叶子范围内的操作
+        LeafGroup group;
+        group.leaf = leaf;
+        group.firstKey = ops[i]->kv.getKey();
+        group.removed = false;
+        group.merged.reserve(leaf->header.keyCount + 8);
+        int pos = 0;
+        size_t j = i;
+        for (; j < ops.size(); j++) {
+            const WriteBatch::Operation* op = ops[j];
+            if (bounded && upperBound.compare(op->kv.key) <= 0) break;
+
+            while (pos < leaf->header.keyCount &&
+                   leaf->keys.compareKey(pos, op->kv.key) < 0) {
+                group.merged.push_back(leaf->keys.get(pos++));
+            }
+            bool exists = pos < leaf->header.keyCount &&
+                          leaf->keys.compareKey(pos, op->kv.key) == 0;
+            if (exists) {
+                group.replaced.push_back(leaf->keys.getValue(pos));
+                pos++;                       // 原记录被覆盖或删除
+            }
+            if (op->type == WriteBatch::Operation::Type::PUT) {
+                group.merged.push_back(records[j]);
+            } else {
+                group.removed = true;
+            }
+        }
+        for (; pos < leaf->header.keyCount; pos++) {
+            group.merged.push_back(leaf->keys.get(pos));
+        }
+        i = j;
+        groups.push_back(std::move(group));
+    }
+
+    // 第二阶段：整批可以应用，更新快照版本、记录缓存和过滤器后写入各叶子。
+    // 页面ID已预留、叶子都已在内存中，这里只有树结构损坏时才会失败
+    noteBatchWrite(ops);
+    for (auto& group : groups) {
+        if (!applyLeafBatch(group.leaf, group.merged, false)) return false;
+        for (const auto& value : group.replaced) releaseValue(value);
+    }
+
+    // 下溢在所有组应用后处理：合并或重分布会修改相邻的叶子，
+    // 而相邻叶子可能是之后的组已归并好内容的目标
+    std::vector<int> checked;
+    for (const auto& group : groups) {
+        if (!group.removed) continue;
+        auto leaf = findLeafNode(group.firstKey);
+        if (!leaf || std::find(checked.begin(), checked.end(),
+                               leaf->header.pageId) != checked.end()) {
+            continue;
+        }
+        checked.push_back(leaf->header.pageId);
+        checkUnderflow(leaf);
+    }
+
+    saveMetadata();
+    return true;
+}
+
+/**
+ * @brief 记录即将应用的一批写操作
+ * @param ops 按键排序去重后的操作
+ *
+ * 整批使用同一个时间戳，快照要么看到整批、要么都看不到；
+ * 应用前一次性更新过滤器，避免中途重建时漏掉尚未写入的键
+ */
+void BPlusTree::noteBatchWrite(const std::vector<const WriteBatch::Operation*>& ops) {
+    uint64_t timestamp = ++mvccClock;
+    for (const auto* op : ops) {
+        preserveVersion(op->kv.getKey(), timestamp);
+        recordCache.invalidate(op->kv.getKey());
+    }
+
+    if (bloomEnabled) {
+        if (bloomFilter.needsRebuild()) {
+            rebuildBloomFilter();
+        }
+        for (const auto* op : ops) {
+            if (op->type == WriteBatch::Operation::Type::PUT) {
+                bloomFilter.add(op->kv.getKey());
+            } else {
+                bloomFilter.noteRemoval();
+            }
+        }
+    }
+}
+
+/**
+ * @brief 用归并后的记录替换叶子内容，必要时多路分裂
+ * @param leaf 目标叶子
+ * @param entries 归并后的有序记录
+ * @param removed 该组是否包含删除，只有删除才可能使叶子下溢
+ * @return true如果成功
+ *
+ * 记录数不超过容量时原地替换；否则一次性均匀分配到所需数量的叶子中，
+ * 依次把分隔键插入父节点，父节点满时按常规方式向上分裂
+ */
+bool BPlusTree::applyLeafBatch(std::shared_ptr<BPlusTreeNode> leaf,
+                               std::vector<KeyValue>& entries, bool removed) {
+    int capacity = MAX_KEYS_PER_PAGE - 1;  // 达到MAX_KEYS_PER_PAGE即分裂
+    int total = static_cast<int>(entries.size());
+
+    // 新叶子同样使用前缀压缩时，按全部记录压缩后的容量分配；
+    // 记录的子集前缀不会更短、后缀不会更长，容量不会更小
+    if (prefixCompression && leaf->keys.isCompressed()) {
+        capacity = std::max(
+            capacity, (int)KeyValueArray::compressedCapacity(
+                          entries, leaf->keys.valueWidth()) - 1);
+    } else if (!leaf->keys.isCompressed()) {
+        capacity = std::max(capacity, (int)leaf->keys.capacity() - 1);
+    }
+
+    if (total <= capacity) {
+        leaf->keys.assign(entries.begin(), entries.end());
+        leaf->header.keyCount = total;
+        leaf->dirty = true;
+        if (bufferPool) {
+            bufferPool->markDirty(leaf->header.pageId);
+        }
+
+        // 删除导致下溢时按常规方式合并或重分布；只有插入的组不会使叶子变小，
+        // 不检查，以免本来就未满的叶子被计入避免的合并次数
+        if (removed) {
+            checkUnderflow(leaf);
+        }
+        return true;
+    }
+
+    // 根叶子需要先创建新的根
+    if (leaf->header.pageId == metadata.rootPageId) {
+        auto newRoot = createNewPage(false);
+        if (!newRoot) return false;
+        newRoot->children.push_back(leaf->header.pageId);
+        leaf->header.parentId = newRoot->header.pageId;
+        metadata.rootPageId = newRoot->header.pageId;
+    }
+
+    // 均匀分配到最少数量的叶子
+    int leafCount = (total + capacity - 1) / capacity;
+    int base = total / leafCount;
+    int extra = total % leafCount;
+
+    int offset = 0;
+    std::shared_ptr<BPlusTreeNode> previous;
+    for (int n = 0; n < leafCount; n++) {
+        int size = base + (n < extra ? 1 : 0);
+        std::shared_ptr<BPlusTreeNode> target = leaf;
+        if (n > 0) {
+            target = createNewPage(true);
+            if (!target) return false;
+            // 维护叶子链表
+            target->header.nextLeafId = previous->header.nextLeafId;
+            previous->header.nextLeafId = target->header.pageId;
+            metadata.splitCount++;
+        }
+
+        target->keys.assign(entries.begin() + offset,
+                            entries.begin() + offset + size);
+        target->header.keyCount = size;
+        target->dirty = true;
+        if (bufferPool) {
+            bufferPool->markDirty(target->header.pageId);
+        }
+
+        if (n > 0) {
+            // 新叶子紧邻前一个叶子，分隔键插入前一个叶子的父节点
+            auto parent = loadPage(previous->header.parentId);
+            if (!parent) return false;
+            target->header.parentId = parent->header.pageId;
+            insertInternal(parent, leafSeparator(*previous, *target),
+                           target->header.pageId);
+            if (parent->isFull()) {
+                handleOverflow(parent);
+            }
+        }
+
+        offset += size;
+        previous = target;
+    }
+    return true;
+}
+
+/**
+ * @brief 处理节点溢出（分裂）
+ * @param node 发生溢出的节点
+ * @param force 为true时即使node未满也将其均分一次（压缩叶子放不下新键时使用）
+ * 
+ * 处理节点分裂的连锁反应，使用迭代方式避免递归调用栈溢出
+ */
+void BPlusTree::handleOverflow(std::shared_ptr<BPlusTreeNode> node,
+                               bool force) {
+    // 使用队列存储需要处理的溢出节点
+    std::vector<std::shared_ptr<BPlusTreeNode>> overflowNodes;
+    overflowNodes.push_back(node);
+
+    // 使用循环而不是递归处理溢出，避免栈溢出
+    while (!overflowNodes.empty()) {
+        auto currentNode = overflowNodes.back();
+        overflowNodes.pop_back();
+
+        // 强制分裂只作用于第一个节点
+        bool forced = force;
+        force = false;
+
+        // 检查节点是否真的需要分裂
+        if (!currentNode || (!forced && !currentNode->isFull())) continue;
+
+        // B*树：先尝试移键到兄弟节点，兄弟都满时叶子做2分3分裂
+        if (!forced && siblingRedistribution &&
+            currentNode->header.pageId != metadata.rootPageId) {
+            if (shiftToSibling(currentNode)) continue;
+            if (currentNode->header.isLeaf && splitTwoIntoThree(currentNode)) {
+                auto parent = loadPage(currentNode->header.parentId);
+                if (parent && parent->isFull()) {
+                    overflowNodes.push_back(parent);
+                }
+                continue;
+            }
+        }
+
+        // 创建新节点用于存储分裂后的右半部分
+        auto newNode = createNewPage(currentNode->header.isLeaf);
+        if (!newNode) continue;              // 创建失败，跳过
+
+        // 执行节点分裂
+        KeyValue promotedKey;
+        currentNode->split(newNode, promotedKey,
+                           forced ? -1 : chooseSplitPoint(*currentNode));
+        metadata.splitCount++;               // 增加分裂计数
+        if (newNode->header.isLeaf) {
+            promotedKey = leafSeparator(*currentNode, *newNode);
+        }
+
+        // 内部节点分裂后，移到新节点的子节点需要更新父节点引用，
+        // 属于这些子节点的缓冲消息随之移到新节点
+        if (!newNode->header.isLeaf) {
+            rebalanceMessages(currentNode, newNode, promotedKey.getKey());
+            for (int childId : newNode->children) {
+                if (childId == -1) continue;
+                auto child = loadPage(childId);
+                if (child) {
+                    child->header.parentId = newNode->header.pageId;
+                    if (bufferPool) {
+                        bufferPool->markDirty(childId);
+                    }
+                }
+            }
+        }
+
+        // 标记相关页面为脏页
+        if (bufferPool) {
+            bufferPool->markDirty(currentNode->header.pageId);
+            bufferPool->markDirty(newNode->header.pageId);
+            // 常驻层的内部节点分裂出的新节点与其同层，一并常驻
+            if (!newNode->header.isLeaf &&
+                bufferPool->isResident(currentNode->header.pageId)) {
+                bufferPool->makeResident(newNode->header.pageId);
+            }
+        }
+
+        // 严重溢出的节点（如批量写入后的父节点）分裂一次后可能仍然是满的
+        if (currentNode->isFull()) {
+            overflowNodes.push_back(currentNode);
+        }
+        if (newNode->isFull()) {
+            overflowNodes.push_back(newNode);
+        }
+
+        // 处理根节点分裂的特殊情况
+        if (currentNode->header.pageId == metadata.rootPageId) {
+            // 创建新根节点
+            auto newRoot = createNewPage(false);  // 内部节点
+            if (!newRoot) continue;          // 创建失败，跳过
+
+            // 设置新根节点的子节点和键
+            newRoot->children.push_back(currentNode->header.pageId);
+            newRoot->children.push_back(newNode->header.pageId);
+            newRoot->keys.push_back(promotedKey);
+            newRoot->header.keyCount = 1;
+
+            // 更新子节点的父节点引用
+            currentNode->header.parentId = newRoot->header.pageId;
+            newNode->header.parentId = newRoot->header.pageId;
+
+            // 更新根节点ID
+            metadata.rootPageId = newRoot->header.pageId;
+            saveMetadata();
+
+            if (bufferPool) {
+                bufferPool->markDirty(newRoot->header.pageId);
+            }
+        } else {
+            // 非根节点分裂，需要向父节点插入上提的键
+            auto parent = loadPage(currentNode->header.parentId);
+            if (parent) {
+                // 设置新节点的父节点
+                newNode->header.parentId = parent->header.pageId;
+                // 向父节点插入上提的键
+                insertInternal(parent, promotedKey, newNode->header.pageId);
+
+                // 如果父节点也满了，加入队列处理
+                if (parent->isFull()) {
+                    overflowNodes.push_back(parent);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 向内部节点插入键值对
+ * @param node 目标内部节点
+ * @param kv 要插入的键值对
+ * @param rightChildId 键右侧的子节点ID
+ * 
+ * 在内部节点中插入键值对和对应的子节点指针
+ */
+void BPlusTree::insertInternal(std::shared_ptr<BPlusTreeNode> node,
+                               const KeyValue& kv, int rightChildId) {
+    // 检查节点有效性
+    if (!node || node->header.isLeaf) return;
+
+    // 压缩的内部节点放不下新分隔键时先均分，再转到键所属的一半
+    bool redirected = false;
+    while (!node->keys.canInsert(kv)) {
+        handleOverflow(node, true);
+        auto parent = loadPage(node->header.parentId);
+        if (!parent) return;
+        int index = 0;
+        while (index < (int)parent->children.size() &&
+               parent->children[index] != node->header.pageId) {
+            index++;
+        }
+        if (index < parent->header.keyCount &&
+            parent->keys.compareKey(index, kv.key) <= 0) {
+            node = loadPage(parent->children[index + 1]);
+            if (!node) return;
+            redirected = true;
+        }
+    }
+    if (redirected && rightChildId != -1) {
+        auto child = loadPage(rightChildId);
+        if (child) {
+            child->header.parentId = node->header.pageId;
+            if (bufferPool) {
+                bufferPool->markDirty(rightChildId);
+            }
+        }
+    }
+
+    // 找到插入位置
+    int pos = node->findKey(kv.getKey());
+
+    // 插入键值对
+    node->keys.insert(pos, kv);
+    node->header.keyCount++;
+    node->lastInsertPos = pos;
+
+    // 插入右子节点指针
+    if (rightChildId != -1) {
+        node->children.insert(node->children.begin() + pos + 1, rightChildId);
+    }
+
+    // 标记为脏页
+    node->dirty = true;
+    if (bufferPool) {
+        bufferPool->markDirty(node->header.pageId);
+    }
+
+    // 调用方只检查原节点是否溢出
+    if (redirected && node->isFull()) {
+        handleOverflow(node);
+    }
+}
+
+/**
+ * @brief 获取指定键的所有值
+ * @param key 要查找的键
+ * @return 包含所有匹配值的二维向量
+ * 
+ * 在B+树中查找指定键的所有值，返回匹配的结果集
+ */
+std::vector<std::vector<std::string>> BPlusTree::get(const std::string& key) {
+    std::vector<std::vector<std::string>> result;
+    if (bloomRejects(key)) return result;    // 过滤器判定不存在
+
+    // 含'\0'的键按其前缀比较，无法按存储的键失效，不进入缓存
+    bool cacheable =
+        recordCache.enabled() && strlen(key.c_str()) == key.size();
+    if (cacheable && recordCache.lookup(key, result)) return result;
+
+    // 查找包含该键的叶子节点，写优化模式下记录路径以合并各层缓冲的消息
+    TreePath path;
+    auto leaf = findLeafNode(key, messageBuffers.empty() ? nullptr : &path);
+    if (!leaf) return result;                // 未找到
+
+    // 路径上缓冲了该键消息的节点，越靠近根的消息越新
+    std::string storedKey = KeyValue(key, "", "").getKey();
+    std::vector<const std::vector<BufferedMessage>*> pending;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        auto buffer = messageBuffers.find(it->first->header.pageId);
+        if (buffer == messageBuffers.end()) continue;
+        auto messages = buffer->second.find(storedKey);
+        if (messages != buffer->second.end()) {
+            pending.push_back(&messages->second);
+        }
+    }
+
+    // 二分定位后收集所有匹配的键值对
+    int first = leaf->findKey(key);
+    if (!pending.empty()) {
+        KeyValue record(storedKey, "", "");
+        std::string value;
+        bool exists = first < leaf->header.keyCount &&
+                      leaf->keys.compareKey(first, key) == 0;
+        if (exists) {
+            record = leaf->keys.get(first);
+            value = loadValue(record.getValue());
+        }
+        size_t maxValueLength =
+            storesFullValues() ? std::string::npos : (size_t)VALUE_SIZE - 1;
+        for (const auto* messages : pending) {
+            exists = applyBufferedMessages(*messages, record, value, exists,
+                                           maxValueLength);
+        }
+        if (exists) {
+            result.push_back({value});
+        }
+    } else {
+        for (int i = first;
+             i < leaf->header.keyCount && leaf->keys.compareKey(i, key) == 0;
+             i++) {
+            std::vector<std::string> values;
+            values.push_back(loadValue(leaf->keys.getValue(i)));
+            result.push_back(values);        // 添加到结果集
+        }
+    }
+
+    if (cacheable) {
+        recordCache.put(key, result);        // 不存在的结果同样缓存
+    }
+    return result;
+}
+
+/**
+ * @brief 批量查询
+ * @param keys 要查询的键列表
+ * @return 与keys一一对应的结果
+ */
+std::vector<std::vector<std::vector<std::string>>> BPlusTree::multiGet(
+    const std::vector<std::string>& keys) {
+    std::vector<std::vector<std::vector<std::string>>> results(keys.size());
+    if (keys.empty() || metadata.rootPageId == -1) return results;
+
+    // 有缓冲的消息时逐键合并路径上的缓冲
+    if (!messageBuffers.empty()) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            results[i] = get(keys[i]);
+        }
+        return results;
+    }
+
+    // 按键排序的下标，结果仍按输入顺序写回；过滤器判定不存在的键不参与下降
+    std::vector<size_t> order;
+    order.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (!bloomRejects(keys[i])) order.push_back(i);
+    }
+    if (order.empty()) return results;
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+        return keys[a] < keys[b];
+    });
+
+    auto root = loadPage(metadata.rootPageId);
+    if (root) {
+        multiGetRecursive(root, keys, order, 0, order.size(), results);
+    }
+    return results;
+}
+
+/**
+ * @brief 批量查询的递归下降
+ * @param node 当前节点
+ * @param keys 查询键
+ * @param order 按键排序的下标
+ * @param begin 本节点负责的order区间起点
+ * @param end 本节点负责的order区间终点（不含）
+ * @param results 输出结果
+ *
+ * 内部节点按分隔键把有序键区间划分给各子节点（一次归并扫描），
+ * 按批预取所需子页面后依次下降；叶子节点对区间内的键逐个二分定位
+ */
+void BPlusTree::multiGetRecursive(
+    std::shared_ptr<BPlusTreeNode> node, const std::vector<std::string>& keys,
+    const std::vector<size_t>& order, size_t begin, size_t end,
+    std::vector<std::vector<std::vector<std::string>>>& results) {
+    if (!node || begin >= end) return;
+
+    if (node->header.isLeaf) {
+        for (size_t i = begin; i < end; i++) {
+            const std::string& key = keys[order[i]];
+            int pos = node->findKey(key);
+            for (; pos < node->header.keyCount &&
+                   node->keys.compareKey(pos, key) == 0;
+                 pos++) {
+                results[order[i]].push_back(
+                    {loadValue(node->keys.getValue(pos))});
+            }
+        }
+        return;
+    }
+
+    // 划分：与findLeafNode一致，等于分隔键时进入右子树
+    struct ChildRange {
+        int childId;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<ChildRange> ranges;
+    size_t i = begin;
+    for (int child = 0; child <= node->header.keyCount && i < end; child++) {
+        size_t rangeBegin = i;
+        if (child < node->header.keyCount) {
+            std::string separator = node->keys.getKey(child);
+            while (i < end && keys[order[i]] < separator) i++;
+        } else {
+            i = end;                         // 最右子树接收剩余所有键
+        }
+        if (i > rangeBegin && child < (int)node->children.size() &&
+            node->children[child] != -1) {
+            ranges.push_back({node->children[child], rangeBegin, i});
+        }
+    }
+
+    // 按批预取子页面，批大小受缓冲池容量限制以免预取页互相淘汰
+    size_t batchSize = 1;
+    if (bufferPool) {
+        batchSize = std::max<size_t>(1, bufferPool->capacity() / 4);
+    }
+    for (size_t b = 0; b < ranges.size(); b += batchSize) {
+        size_t batchEnd = std::min(ranges.size(), b + batchSize);
+        if (batchEnd - b > 1) {
+            std::vector<int> pageIds;
+            for (size_t r = b; r < batchEnd; r++) {
+                pageIds.push_back(ranges[r].childId);
+            }
+            prefetchPages(pageIds);
+        }
+        for (size_t r = b; r < batchEnd; r++) {
+            multiGetRecursive(loadPage(ranges[r].childId), keys, order,
+                              ranges[r].begin, ranges[r].end, results);
+        }
+    }
+}
+
+/**
+ * @brief 从B+树中删除指定键
+ * @param key 要删除的键
+ * @return true 删除成功，false 键不存在
+ * 
+ * 删除指定键，如果删除后节点过小则进行合并或重分布操作
+ */
+bool BPlusTree::remove(const std::string& key) {
+    if (bloomRejects(key)) return false;     // 过滤器判定不存在
+    maybeCollectValueLog();
+
+    // 写优化模式下按合并缓冲后的结果判断键是否存在，删除作为消息缓冲
+    if (messageBufferingActive()) {
+        if (get(key).empty()) return false;
+        bufferRemoval(key);
+        return true;
+    }
+
+    // 查找包含该键的叶子节点
+    auto leaf = findLeafNode(key);
+    if (!leaf) return false;                 // 键不存在
+
+    // 在叶子节点中查找键的位置
+    int pos = leaf->findKey(key);
+    if (pos >= leaf->header.keyCount || leaf->keys.compareKey(pos, key) != 0) {
+        return false;                        // 键不存在
+    }
+
+    // 删除键
+    std::string storedKey = leaf->keys.getKey(pos);
+    preserveVersion(storedKey, ++mvccClock);
+    recordCache.invalidate(storedKey);
+    releaseValue(leaf->keys.getValue(pos));
+    leaf->removeKey(pos);
+    if (bloomEnabled) {
+        bloomFilter.noteRemoval();
+    }
+    if (bufferPool) {
+        bufferPool->markDirty(leaf->header.pageId);  // 标记为脏页
+    }
+
+    // 检查是否需要处理下溢（节点过小）
+    checkUnderflow(leaf);
+
+    return true;
+}
+
+/**
+ * @brief 删除键，不检查键是否存在
+ * @param key 要删除的键
+ *
+ * 写优化模式下只缓冲删除消息，应用到叶子时键不存在则忽略；
+ * 删除计入过滤器的删除次数，最多使其提前重建
+ */
+void BPlusTree::removeBlind(const std::string& key) {
+    if (!messageBufferingActive()) {
+        remove(key);
+        return;
+    }
+    if (bloomRejects(key)) return;           // 过滤器判定不存在
+    maybeCollectValueLog();
+    bufferRemoval(key);
+}
+
+/**
+ * @brief 删除后检查叶子下溢
+ * @param leaf 刚删除过键的叶子
+ *
+ * 低于合并阈值时合并或重分布；只低于默认阈值时不做结构修改，
+ * 计入避免的结构修改次数
+ */
+void BPlusTree::checkUnderflow(std::shared_ptr<BPlusTreeNode> leaf) {
+    if (leaf->header.pageId == metadata.rootPageId) return;
+
+    if (leaf->header.keyCount < mergeThreshold) {
+        handleUnderflow(leaf);               // 处理节点下溢
+    } else if (leaf->header.keyCount < MAX_KEYS_PER_PAGE / 2) {
+        metadata.avoidedUnderflowCount++;
+    }
+}
+
+/**
+ * @brief 设置叶子页面是否使用前缀压缩
+ * @param enabled 是否启用
+ */
+void BPlusTree::setPrefixCompression(bool enabled) {
+    prefixCompression = enabled;
+}
+
+/**
+ * @brief 设置是否截断分隔键
+ * @param enabled 是否启用
+ */
+void BPlusTree::setSuffixTruncation(bool enabled) {
+    suffixTruncation = enabled;
+}
+
+/**
+ * @brief 设置合并阈值
+ * @param minKeys 最小键数
+ */
+void BPlusTree::setMergeThreshold(int minKeys) {
+    mergeThreshold = std::max(0, std::min(minKeys, MAX_KEYS_PER_PAGE / 2));
+}
+
+/**
+ * @brief 处理节点下溢（合并或重分布）
+ * @param node 发生下溢的节点
+ * 
+ * 当节点中的键数量少于最小要求时，通过合并或重分布来维护B+树的性质
+ */
+void BPlusTree::handleUnderflow(std::shared_ptr<BPlusTreeNode> node) {
+    if (!node) return;
+
+    // 合并阈值不超过MAX_KEYS_PER_PAGE / 2，合并后的叶子不会溢出
+    int minKeys = mergeThreshold;
+
+    // 检查节点是否真的需要处理下溢
+    if (node->header.keyCount >= minKeys) {
+        return;                              // 键数量足够，无需处理
+    }
+
+    // 处理根节点的特殊情况
+    if (node->header.pageId == metadata.rootPageId) {
+        // 如果根节点是内部节点且为空，则将其唯一子节点提升为新根
+        if (!node->header.isLeaf && node->header.keyCount == 0 &&
+            !node->children.empty() && node->children[0] != -1) {
+            if (bufferPool) {
+                bufferPool->releaseResident(node->header.pageId);
+            }
+            metadata.rootPageId = node->children[0];
+            auto newRoot = loadPage(metadata.rootPageId);
+            if (newRoot) {
+                newRoot->header.parentId = -1;  // 新根无父节点
+                if (bufferPool) {
+                    bufferPool->markDirty(newRoot->header.pageId);
+                }
+            }
+            saveMetadata();
+            metadata.pageCount--;            // 减少页面计数
+            if (newRoot) {
+                moveAllMessages(node->header.pageId, newRoot);
+            }
+        }
+        return;
+    }
+
+    // 加载父节点
+    auto parent = loadPage(node->header.parentId);
+    if (!parent) return;
+
+    // 在父节点中找到当前节点的位置
+    int nodeIndex = -1;
+    for (int i = 0; i < (int)parent->children.size(); i++) {
+        if (parent->children[i] == node->header.pageId) {
+            nodeIndex = i;
+            break;
+        }
+    }
+    if (nodeIndex == -1) return;             // 未找到节点位置
+
+    // 尝试从左兄弟节点借键
+    if (nodeIndex > 0) {
+        auto leftSibling = loadPage(parent->children[nodeIndex - 1]);
+        if (leftSibling && leftSibling->header.keyCount > minKeys) {
+            redistributeFromLeft(node, leftSibling, parent, nodeIndex - 1);
+            return;
+        }
+    }
+
+    // 尝试从右兄弟节点借键
+    if (nodeIndex < (int)parent->children.size() - 1) {
+        auto rightSibling = loadPage(parent->children[nodeIndex + 1]);
+        if (rightSibling && rightSibling->header.keyCount > minKeys) {
+            redistributeFromRight(node, rightSibling, parent, nodeIndex);
+            return;
+        }
+    }
+
+    // 无法借键，尝试与左兄弟合并
+    if (nodeIndex > 0) {
+        auto leftSibling = loadPage(parent->children[nodeIndex - 1]);
+        if (leftSibling) {
+            mergeNodes(leftSibling, node, parent, nodeIndex - 1);
+            return;
+        }
+    }
+
+    // 尝试与右兄弟合并
+    if (nodeIndex < (int)parent->children.size() - 1) {
+        auto rightSibling = loadPage(parent->children[nodeIndex + 1]);
+        if (rightSibling) {
+            mergeNodes(node, rightSibling, parent, nodeIndex);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 从左兄弟节点重分布键
+ * @param node 目标节点
+ * @param leftSibling 左兄弟节点
+ * @param parent 父节点
+ * @param parentKeyIndex 父节点中的键索引
+ * 
+ * 从左兄弟节点借一个键来增加目标节点的键数量
+ */
+void BPlusTree::redistributeFromLeft(std::shared_ptr<BPlusTreeNode> node,
+                                     std::shared_ptr<BPlusTreeNode> leftSibling,
+                                     std::shared_ptr<BPlusTreeNode> parent,
+                                     int parentKeyIndex) {
+    if (node->header.isLeaf) {
+        // 叶子节点重分布
+        // 将左兄弟的最后一个键移动到当前节点的开头
+        node->keys.insert(0, leftSibling->keys.back());
+        leftSibling->keys.pop_back();
+        leftSibling->header.keyCount--;
+        node->header.keyCount++;
+
+        // 更新父节点中的分隔键为当前节点的第一个键
+        replaceSeparator(parent, parentKeyIndex,
+                         leafSeparator(*leftSibling, *node));
+    } else {
+        // 内部节点重分布
+        // 将父节点的键下降到当前节点
+        node->keys.insert(0, parent->keys.get(parentKeyIndex));
+        node->header.keyCount++;
+
+        // 将左兄弟的最后一个键上升到父节点
+        KeyValue separator = leftSibling->keys.back();
+        leftSibling->keys.pop_back();
+        leftSibling->header.keyCount--;
+
+        // 移动对应的子节点指针及其缓冲消息
+        node->children.insert(node->children.begin(),
+                              leftSibling->children.back());
+        leftSibling->children.pop_back();
+        rebalanceMessages(leftSibling, node, separator.getKey());
+        replaceSeparator(parent, parentKeyIndex, separator);
+
+        // 更新移动的子节点的父节点引用
+        if (node->children[0] != -1) {
+            auto child = loadPage(node->children[0]);
+            if (child) {
+                child->header.parentId = node->header.pageId;
+                if (bufferPool) {
+                    bufferPool->markDirty(child->header.pageId);
+                }
+            }
+        }
+    }
+
+    // 标记相关节点为脏页
+    if (bufferPool) {
+        bufferPool->markDirty(node->header.pageId);
+        bufferPool->markDirty(leftSibling->header.pageId);
+        bufferPool->markDirty(parent->header.pageId);
+    }
+}
+
+/**
+ * @brief 从右兄弟节点重分布键
+ * @param node 目标节点
+ * @param rightSibling 右兄弟节点
+ * @param parent 父节点
+ * @param parentKeyIndex 父节点中的键索引
+ * 
+ * 从右兄弟节点借一个键来增加目标节点的键数量
+ */
+void BPlusTree::redistributeFromRight(
+    std::shared_ptr<BPlusTreeNode> node,
+    std::shared_ptr<BPlusTreeNode> rightSibling,
+    std::shared_ptr<BPlusTreeNode> parent, int parentKeyIndex) {
+    if (node->header.isLeaf) {
+        // 叶子节点重分布
+        // 将右兄弟的第一个键移动到当前节点的末尾
+        node->keys.push_back(rightSibling->keys.front());
+        rightSibling->keys.erase(0);
+        rightSibling->header.keyCount--;
+        node->header.keyCount++;
+
+        // 更新父节点中的分隔键为右兄弟的第一个键
+        replaceSeparator(parent, parentKeyIndex,
+                         leafSeparator(*node, *rightSibling));
+    } else {
+        // 内部节点重分布
+        // 将父节点的键下降到当前节点
+        node->keys.push_back(parent->keys.get(parentKeyIndex));
+        node->header.keyCount++;
+
+        // 将右兄弟的第一个键上升到父节点
+        KeyValue separator = rightSibling->keys.front();
+        rightSibling->keys.erase(0);
+        rightSibling->header.keyCount--;
+
+        // 移动对应的子节点指针及其缓冲消息
+        node->children.push_back(rightSibling->children[0]);
+        rightSibling->children.erase(rightSibling->children.begin());
+        rebalanceMessages(node, rightSibling, separator.getKey());
+        replaceSeparator(parent, parentKeyIndex, separator);
+
+        // 更新移动的子节点的父节点引用
+        if (node->children.back() != -1) {
+            auto child = loadPage(node->children.back());
+            if (child) {
+                child->header.parentId = node->header.pageId;
+                if (bufferPool) {
+                    bufferPool->markDirty(child->header.pageId);
+                }
+            }
+        }
+    }
+
+    // 标记相关节点为脏页
+    if (bufferPool) {
+        bufferPool->markDirty(node->header.pageId);
+        bufferPool->markDirty(rightSibling->header.pageId);
+        bufferPool->markDirty(parent->header.pageId);
+    }
+}
+
+/**
+ * @brief 合并两个节点
+ * @param leftNode 左节点
+ * @param rightNode 右节点
+ * @param parent 父节点
+ * @param parentKeyIndex 父节点中要删除的键索引
+ * 
+ * 将右节点的所有键和子节点合并到左节点中，然后删除右节点
+ */
+void BPlusTree::mergeNodes(std::shared_ptr<BPlusTreeNode> leftNode,
+                           std::shared_ptr<BPlusTreeNode> rightNode,
+                           std::shared_ptr<BPlusTreeNode> parent,
+                           int parentKeyIndex) {
+    if (leftNode->header.isLeaf) {
+        // 叶子节点合并
+        // 将右节点的所有键复制到左节点
+        leftNode->keys.append(rightNode->keys);
+        leftNode->header.keyCount += rightNode->header.keyCount;
+
+        // 维护叶子节点链表的连接关系
+        leftNode->header.nextLeafId = rightNode->header.nextLeafId;
+
+        // 右节点不再属于树，最右叶子缓存转移到左节点
+        if (rightNode->header.pageId == rightmostLeafId) {
+            rightmostLeafId = leftNode->header.pageId;
+        }
+    } else {
+        // 内部节点合并
+        // 将父节点的键下降到左节点
+        leftNode->keys.push_back(parent->keys.get(parentKeyIndex));
+        leftNode->header.keyCount++;
+
+        // 将右节点的所有键复制到左节点
+        leftNode->keys.append(rightNode->keys);
+        leftNode->header.keyCount += rightNode->header.keyCount;
+
+        // 右节点不再属于树，不再常驻，缓冲消息移到左节点
+        if (bufferPool) {
+            bufferPool->releaseResident(rightNode->header.pageId);
+        }
+        moveAllMessages(rightNode->header.pageId, leftNode);
+
+        // 将右节点的所有子节点指针复制到左节点
+        for (int childId : rightNode->children) {
+            leftNode->children.push_back(childId);
+            // 更新子节点的父节点引用
+            if (childId != -1) {
+                auto child = loadPage(childId);
+                if (child) {
+                    child->header.parentId = leftNode->header.pageId;
+                    if (bufferPool) {
+                        bufferPool->markDirty(child->header.pageId);
+                    }
+                }
+            }
+        }
+    }
+
+    // 从父节点删除对应的键
+    parent->removeKey(parentKeyIndex);
+
+    // 标记相关节点为脏页
+    if (bufferPool) {
+        bufferPool->markDirty(leftNode->header.pageId);
+        bufferPool->markDirty(parent->header.pageId);
+    }
+
+    // 更新统计信息
+    metadata.pageCount--;                    // 减少页面计数
+    metadata.mergeCount++;                   // 增加合并计数
+
+    // 内部节点合并时下降的父节点键可能使左节点达到上限，
+    // 满节点（18个键、19个子节点）超出页面大小，需要重新分裂
+    if (leftNode->isFull()) {
+        leftNode->lastInsertPos = -1;        // 不是插入导致的溢出，均分
+        handleOverflow(leftNode);
+        return;
+    }
+
+    // 检查父节点是否需要处理下溢
+    if (parent->header.keyCount < mergeThreshold) {
+        handleUnderflow(parent);
+    }
+}
+
+// ================================ 只读快照 ================================
+
+/**
+ * @brief 读取快照版本中的页面，内部节点读入后缓存
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTreeSnapshot::loadPage(int pageId) {
+    auto it = internalNodes.find(pageId);
+    if (it != internalNodes.end()) return it->second;
+
+    auto node = std::make_shared<BPlusTreeNode>(pageId);
+    if (!storage || !storage->readVersionPage(*version, pageId, node->frame)) {
+        return nullptr;
+    }
+    node->attachFrame();
+    if (!node->header.isLeaf) {
+        internalNodes[pageId] = node;
+    }
+    return node;
+}
+
+/**
+ * @brief 自快照的根向下查找键所在的叶子，与BPlusTree::findLeafNode一致
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTreeSnapshot::findLeaf(
+    const std::string& key) {
+    if (!version || rootPageId == -1) return nullptr;
+
+    auto current = loadPage(rootPageId);
+    while (current && !current->header.isLeaf) {
+        int pos = current->findKey(key);
+        if (pos < current->header.keyCount &&
+            current->keys.compareKey(pos, key) == 0) {
+            pos++;                           // 等于分隔键时进入右子树
+        }
+        if (pos >= (int)current->children.size() ||
+            current->children[pos] == -1) {
+            return nullptr;
+        }
+        current = loadPage(current->children[pos]);
+    }
+    return current;
+}
+
+/**
+ * @brief 快照中指定键的所有值
+ */
+std::vector<std::vector<std::string>> BPlusTreeSnapshot::get(
+    const std::string& key) {
+    std::vector<std::vector<std::string>> result;
+    auto leaf = findLeaf(key);
+    if (!leaf) return result;
+
+    for (int i = leaf->findKey(key);
+         i < leaf->header.keyCount && leaf->keys.compareKey(i, key) == 0; i++) {
+        result.push_back({loadValue(leaf->keys.getValue(i))});
+    }
+    return result;
+}
+
+/**
+ * @brief 按快照固定的值日志文件或该版本的溢出页解析叶子中保存的值
+ */
+std::string BPlusTreeSnapshot::loadValue(const std::string& stored) {
+    if (overflowPages) {
+        std::string value;
+        if (readOverflowValue(stored, value, [this](int pageId) {
+                return loadPage(pageId);
+            })) {
+            return value;
+        }
+        return stored;
+    }
+    if (!ValueLog::isPointer(stored)) return stored;
+    std::string value;
+    if (!ValueLog::read(valueFiles, stored, value)) {
+        std::cerr << "Snapshot: dangling value log pointer" << std::endl;
+        value.clear();
+    }
+    return value;
+}
+
+/**
+ * @brief 快照中的范围查询，沿该版本的叶子链表前进
+ */
+std::vector<KeyValue> BPlusTreeSnapshot::scan(const std::string& startKey,
+                                              const std::string& endKey,
+                                              int limit) {
+    std::vector<KeyValue> result;
+    auto leaf = findLeaf(startKey);
+    int index = leaf ? leaf->findKey(startKey) : 0;
+    while (leaf) {
+        for (; index < leaf->header.keyCount; index++) {
+            if (limit >= 0 && (int)result.size() >= limit) return result;
+            if (leaf->keys.compareKey(index, endKey) > 0) return result;
+            KeyValue record = leaf->keys.get(index);
+            std::string stored = record.getValue();
+            std::string value = loadValue(stored);
+            if (value != stored) {
+                record = KeyValue(record.getKey(), record.getRowId(), value);
+            }
+            result.push_back(record);
+        }
+        int next = leaf->header.nextLeafId;
+        leaf = next == -1 ? nullptr : loadPage(next);
+        index = 0;
+    }
+    return result;
+}
+
+// ================================ 多版本读 ================================
+
+std::vector<std::vector<std::string>> MVCCSnapshot::get(const std::string& key) {
+    if (!isValid()) return {};
+    return tree->snapshotGet(*timestamp, key);
+}
+
+std::vector<KeyValue> MVCCSnapshot::scan(const std::string& startKey,
+                                         const std::string& endKey, int limit) {
+    if (!isValid()) return {};
+    return tree->snapshotScan(*timestamp, startKey, endKey, limit);
+}
+
+/**
+ * @brief 开始多版本读快照
+ * @return 快照句柄
+ */
+MVCCSnapshot BPlusTree::beginSnapshot() {
+    // 快照期间写操作直接应用到叶子，先应用已缓冲的消息
+    flushAllMessages();
+
+    MVCCSnapshot snap;
+    snap.tree = this;
+    snap.timestamp = std::make_shared<const uint64_t>(mvccClock);
+    liveSnapshots.push_back(snap.timestamp);
+    return snap;
+}
+
+/**
+ * @brief 是否还有未释放的快照
+ * @param newest 输出参数，最新快照的时间戳
+ *
+ * 顺便清理已释放的句柄；没有快照时丢弃所有旧版本
+ */
+bool BPlusTree::snapshotsActive(uint64_t* newest) {
+    uint64_t newestTimestamp = 0;
+    size_t live = 0;
+    for (size_t i = 0; i < liveSnapshots.size(); i++) {
+        auto timestamp = liveSnapshots[i].lock();
+        if (!timestamp) continue;
+        newestTimestamp = std::max(newestTimestamp, *timestamp);
+        liveSnapshots[live++] = liveSnapshots[i];
+    }
+    liveSnapshots.resize(live);
+
+    if (live == 0 && !versionChains.empty()) {
+        versionChains.clear();
+        retainedVersionCount = 0;
+    }
+    if (newest) *newest = newestTimestamp;
+    return live > 0;
+}
+
+/**
+ * @brief 写操作修改键之前保存其当前记录
+ * @param key 存储的键
+ * @param timestamp 写操作的时间戳
+ *
+ * 只有在该键上一次保存的旧版本之后开始过快照时才需要保存：
+ * 更早的快照读取链中已有的旧版本，不会看到当前记录
+ */
+void BPlusTree::preserveVersion(const std::string& key, uint64_t timestamp) {
+    uint64_t newest = 0;
+    if (!snapshotsActive(&newest)) return;
+
+    auto& chain = versionChains[key];
+    if (!chain.empty() && chain.back().endTimestamp > newest) return;
+
+    RecordVersion version;
+    version.endTimestamp = timestamp;
+    auto leaf = findLeafNode(key);
+    if (leaf) {
+        for (int i = leaf->findKey(key);
+             i < leaf->header.keyCount && leaf->keys.compareKey(i, key) == 0;
+             i++) {
+            version.records.push_back(leaf->keys.get(i));
+        }
+    }
+    chain.push_back(std::move(version));
+    retainedVersionCount++;
+
+    if (++versionsSinceCollect >= 1024) {
+        collectVersions();
+    }
+}
+
+/**
+ * @brief 回收低水位（最早的快照）之前被替换的旧版本
+ */
+void BPlusTree::collectVersions() {
+    versionsSinceCollect = 0;
+    uint64_t lowWater = UINT64_MAX;
+    for (const auto& weak : liveSnapshots) {
+        if (auto timestamp = weak.lock()) {
+            lowWater = std::min(lowWater, *timestamp);
+        }
+    }
+
+    // 替换时间不晚于低水位的旧版本对所有快照都不可见
+    for (auto it = versionChains.begin(); it != versionChains.end();) {
+        auto& chain = it->second;
+        auto keep = std::find_if(chain.begin(), chain.end(),
+                                 [lowWater](const RecordVersion& v) {
+                                     return v.endTimestamp > lowWater;
+                                 });
+        retainedVersionCount -= keep - chain.begin();
+        chain.erase(chain.begin(), keep);
+        it = chain.empty() ? versionChains.erase(it) : std::next(it);
+    }
+}
+
+/**
+ * @brief 快照可见的旧版本
+ * @return 第一个在快照之后被替换的版本；nullptr表示当前记录可见
+ */
+const RecordVersion* BPlusTree::visibleVersion(const std::string& key,
+                                               uint64_t timestamp) const {
+    auto it = versionChains.find(key);
+    if (it == versionChains.end()) return nullptr;
+    for (const auto& version : it->second) {
+        if (version.endTimestamp > timestamp) return &version;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 快照点查询
+ */
+std::vector<std::vector<std::string>> BPlusTree::snapshotGet(
+    uint64_t timestamp, const std::string& key) {
+    // 与叶子中的比较一致，按'\0'之前的部分查找
+    const RecordVersion* version = visibleVersion(key.c_str(), timestamp);
+    if (!version) return get(key);
+
+    std::vector<std::vector<std::string>> result;
+    for (const auto& record : version->records) {
+        result.push_back({loadValue(record.getValue())});
+    }
+    return result;
+}
+
+/**
+ * @brief 快照范围查询
+ *
+ * 沿叶子链表扫描当前记录，同时按序遍历范围内的版本链：
+ * 有可见旧版本的键用旧版本替换（旧版本为空时跳过），
+ * 快照之后删除的键只出现在版本链中，同样按旧版本输出
+ */
+std::vector<KeyValue> BPlusTree::snapshotScan(uint64_t timestamp,
+                                              const std::string& startKey,
+                                              const std::string& endKey,
+                                              int limit) {
+    std::vector<KeyValue> result;
+    auto full = [&result, limit]() {
+        return limit >= 0 && (int)result.size() >= limit;
+    };
+
+    auto cursor = seek(startKey);
+    auto chain = versionChains.lower_bound(startKey);
+    while (!full()) {
+        bool haveCurrent = cursor.isValid() && cursor.key() <= endKey;
+        bool haveChain = chain != versionChains.end() && chain->first <= endKey;
+        if (!haveCurrent && !haveChain) break;
+
+        std::string key = haveCurrent && (!haveChain || cursor.key() < chain->first)
+                              ? cursor.key()
+                              : chain->first;
+        const RecordVersion* version = nullptr;
+        if (haveChain && chain->first == key) {
+            version = visibleVersion(key, timestamp);
+            ++chain;
+        }
+
+        if (version) {
+            for (const auto& record : version->records) {
+                if (full()) break;
+                result.push_back(loadRecord(record));
+            }
+        }
+        for (; cursor.isValid() && cursor.key() == key; cursor.next()) {
+            if (!version && !full()) result.push_back(cursor.current());
+        }
+    }
+    return result;
+}
+
+// ================================ 写优化消息缓冲 ================================
+
+/**
+ * @brief 设置写优化模式
+ * @param messagesPerNode 每个内部节点最多缓冲的键数，0表示禁用
+ *
+ * 禁用时立即把所有消息应用到叶子
+ */
+void BPlusTree::setMessageBuffering(size_t messagesPerNode) {
+    if (messagesPerNode == 0) {
+        flushAllMessages();
+    }
+    messageBufferSize = messagesPerNode;
+}
+
+/**
+ * @brief 写操作是否进入消息缓冲
+ *
+ * 根为叶子时没有可缓冲的内部节点；多版本读快照需要在写入时
+ * 读出被替换的记录，此时直接应用到叶子
+ */
+bool BPlusTree::messageBufferingActive() {
+    if (messageBufferSize == 0 || metadata.rootPageId == -1) return false;
+    if (snapshotsActive()) return false;
+    auto root = loadPage(metadata.rootPageId);
+    return root && !root->header.isLeaf;
+}
+
+/**
+ * @brief 把消息写入根节点的缓冲，超出容量时向下推送
+ * @param key 存储的键
+ * @param message 消息
+ */
+void BPlusTree::bufferMessage(const std::string& key, BufferedMessage message) {
+    appendMessage(messageBuffers[metadata.rootPageId], key, std::move(message));
+
+    // 下推过程中根可能分裂或变矮，每次按当前的根检查
+    while (true) {
+        auto it = messageBuffers.find(metadata.rootPageId);
+        if (it == messageBuffers.end() || it->second.size() <= messageBufferSize) {
+            break;
+        }
+        flushMessages(metadata.rootPageId);
+    }
+}
+
+/**
+ * @brief 缓冲一条删除消息
+ * @param key 要删除的键
+ */
+void BPlusTree::bufferRemoval(const std::string& key) {
+    std::string storedKey = KeyValue(key, "", "").getKey();
+    recordCache.invalidate(storedKey);
+    if (bloomEnabled) {
+        bloomFilter.noteRemoval();
+    }
+    bufferMessage(storedKey, {BufferedMessage::Type::DELETE, "", "", nullptr});
+}
+
+/**
+ * @brief 把内部节点缓冲中发往同一子节点的一批消息下推一层
+ * @param pageId 内部节点页面ID
+ *
+ * 选择消息最多的子节点：子节点为内部节点时追加到其缓冲（比其中已有的消息新），
+ * 超出容量时继续下推；子节点为叶子时按叶子分组应用
+ */
+void BPlusTree::flushMessages(int pageId) {
+    auto it = messageBuffers.find(pageId);
+    if (it == messageBuffers.end()) return;
+    auto node = loadPage(pageId);
+    if (!node || node->header.isLeaf || node->children.empty()) {
+        MessageBuffer orphaned = std::move(it->second);
+        messageBuffers.erase(it);
+        applyMessagesToLeaves(orphaned);
+        return;
+    }
+
+    // 缓冲按键有序，发往同一子节点的消息是连续的一段
+    MessageBuffer& buffer = it->second;
+    auto bestBegin = buffer.begin();
+    auto bestEnd = buffer.begin();
+    size_t bestCount = 0;
+    int bestChild = -1;
+    for (auto begin = buffer.begin(); begin != buffer.end();) {
+        int child = routeChild(*node, begin->first);
+        auto end = begin;
+        size_t count = 0;
+        while (end != buffer.end() && routeChild(*node, end->first) == child) {
+            ++end;
+            count++;
+        }
+        if (count > bestCount) {
+            bestBegin = begin;
+            bestEnd = end;
+            bestCount = count;
+            bestChild = child;
+        }
+        begin = end;
+    }
+
+    MessageBuffer batch;
+    batch.insert(std::make_move_iterator(bestBegin),
+                 std::make_move_iterator(bestEnd));
+    buffer.erase(bestBegin, bestEnd);
+    if (buffer.empty()) {
+        messageBuffers.erase(it);
+    }
+    messageFlushCount++;
+
+    auto child = loadPage(node->children[bestChild]);
+    if (!child) return;
+    if (child->header.isLeaf) {
+        applyMessagesToLeaves(batch);
+        return;
+    }
+
+    int childId = child->header.pageId;
+    MessageBuffer& childBuffer = messageBuffers[childId];
+    for (auto& entry : batch) {
+        for (auto& message : entry.second) {
+            appendMessage(childBuffer, entry.first, std::move(message));
+        }
+    }
+    while (true) {
+        auto childIt = messageBuffers.find(childId);
+        if (childIt == messageBuffers.end() ||
+            childIt->second.size() <= messageBufferSize) {
+            break;
+        }
+        flushMessages(childId);
+    }
+}
+
+/**
+ * @brief 把所有缓冲的消息应用到叶子
+ *
+ * 优先从根开始下推，上层的消息与下层的合并后只应用一次
+ */
+void BPlusTree::flushAllMessages() {
+    while (!messageBuffers.empty()) {
+        int pageId = messageBuffers.count(metadata.rootPageId)
+                         ? metadata.rootPageId
+                         : messageBuffers.begin()->first;
+        flushMessages(pageId);
+    }
+}
+
+/**
+ * @brief 把一批消息应用到叶子
+ * @param batch 按键有序的消息
+ *
+ * 与write相同：每组只查找一次叶子，由查找路径得到叶子的键上界，
+ * 归并叶子中的记录和落在其范围内的消息后用applyLeafBatch替换
+ */
+void BPlusTree::applyMessagesToLeaves(const MessageBuffer& batch) {
+    auto op = batch.begin();
+    while (op != batch.end()) {
+        TreePath path;
+        auto leaf = findLeafNode(op->first, &path);
+        if (!leaf) return;
+
+        std::string upperBound;
+        bool bounded = false;
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            if (it->second < it->first->header.keyCount) {
+                upperBound = it->first->keys.getKey(it->second);
+                bounded = true;
+                break;
+            }
+        }
+
+        std::vector<KeyValue> merged;
+        merged.reserve(leaf->header.keyCount + 8);
+        std::vector<std::string> replaced;   // 叶子更新后才释放
+        size_t maxValueLength =
+            storesFullValues() ? std::string::npos : (size_t)VALUE_SIZE - 1;
+        int pos = 0;
+        bool removed = false;
+        for (; op != batch.end(); ++op) {
+            if (bounded && upperBound.compare(op->first) <= 0) break;
+
+            while (pos < leaf->header.keyCount &&
+                   leaf->keys.compareKey(pos, op->first) < 0) {
+                merged.push_back(leaf->keys.get(pos++));
+            }
+            KeyValue record(op->first, "", "");
+            std::string value;
+            bool exists = pos < leaf->header.keyCount &&
+                          leaf->keys.compareKey(pos, op->first) == 0;
+            if (exists) {
+                record = leaf->keys.get(pos++);
+                // 只有合并函数需要现有值，覆盖和删除不读取值日志
+                if (op->second.front().type == BufferedMessage::Type::UPSERT) {
+                    value = loadValue(record.getValue());
+                }
+            }
+            KeyValue original = record;
+            std::string stored;
+            if (!applyBufferedMessages(op->second, record, value, exists,
+                                       maxValueLength)) {
+                if (exists) {
+                    replaced.push_back(original.getValue());
+                    removed = true;          // 现有记录被删除
+                }
+            } else if (storeValue(value, stored)) {
+                if (exists) replaced.push_back(original.getValue());
+                merged.push_back(
+                    storedRecord(record.getKey(), record.getRowId(), stored));
+            } else {
+                // 值写入失败时保留原记录，该键的消息不应用，下一次commit失败
+                messageApplyFailed = true;
+                if (exists) merged.push_back(original);
+            }
+        }
+        for (; pos < leaf->header.keyCount; pos++) {
+            merged.push_back(leaf->keys.get(pos));
+        }
+
+        if (!applyLeafBatch(leaf, merged, removed)) return;
+        for (const auto& stale : replaced) releaseValue(stale);
+    }
+    saveMetadata();
+}
+
+/**
+ * @brief 相邻内部节点之间移动子节点后，按新的分隔键重新划分两者的缓冲
+ * @param left 左节点
+ * @param right 右节点
+ * @param separator 两者之间的分隔键，不小于它的键属于右节点
+ */
+void BPlusTree::rebalanceMessages(std::shared_ptr<BPlusTreeNode> left,
+                                  std::shared_ptr<BPlusTreeNode> right,
+                                  const std::string& separator) {
+    if (messageBuffers.empty()) return;
+    auto leftIt = messageBuffers.find(left->header.pageId);
+    auto rightIt = messageBuffers.find(right->header.pageId);
+
+    // 同一层中每个键只在它所属的节点上有消息，两侧移动的键互不重叠
+    if (leftIt != messageBuffers.end()) {
+        auto begin = leftIt->second.lower_bound(separator);
+        if (begin != leftIt->second.end()) {
+            MessageBuffer& target = messageBuffers[right->header.pageId];
+            leftIt = messageBuffers.find(left->header.pageId);
+            target.insert(std::make_move_iterator(begin),
+                          std::make_move_iterator(leftIt->second.end()));
+            leftIt->second.erase(begin, leftIt->second.end());
+            if (leftIt->second.empty()) messageBuffers.erase(leftIt);
+        }
+    }
+    rightIt = messageBuffers.find(right->header.pageId);
+    if (rightIt != messageBuffers.end()) {
+        auto end = rightIt->second.lower_bound(separator);
+        if (end != rightIt->second.begin()) {
+            MessageBuffer& target = messageBuffers[left->header.pageId];
+            rightIt = messageBuffers.find(right->header.pageId);
+            target.insert(std::make_move_iterator(rightIt->second.begin()),
+                          std::make_move_iterator(end));
+            rightIt->second.erase(rightIt->second.begin(), end);
+            if (rightIt->second.empty()) messageBuffers.erase(rightIt);
+        }
+    }
+}
+
+/**
+ * @brief 节点移出树时把它的全部消息移到接替它的节点
+ * @param fromId 移出树的内部节点
+ * @param to 接替的节点（合并的左节点或变矮后的新根）
+ *
+ * 移出的消息比接替节点中已有的新；接替节点是叶子时直接应用
+ */
+void BPlusTree::moveAllMessages(int fromId, std::shared_ptr<BPlusTreeNode> to) {
+    auto it = messageBuffers.find(fromId);
+    if (it == messageBuffers.end()) return;
+    MessageBuffer moved = std::move(it->second);
+    messageBuffers.erase(it);
+
+    if (to->header.isLeaf) {
+        applyMessagesToLeaves(moved);
+        return;
+    }
+    MessageBuffer& target = messageBuffers[to->header.pageId];
+    for (auto& entry : moved) {
+        for (auto& message : entry.second) {
+            appendMessage(target, entry.first, std::move(message));
+        }
+    }
+}
+
+// ================================ 键值分离值日志 ================================
+
+// 自动回收至少需要的垃圾字节数，避免小日志频繁整体搬迁
+static const uint64_t VALUE_LOG_GC_MIN_BYTES = 1 << 20;
+
+/**
+ * @brief 设置是否使用值日志
+ * @param enabled 是否启用
+ * @param gcGarbageRatio 自动回收的垃圾占比，0表示只手动回收
+ *
+ * 仅对之后create新建的文件生效
+ */
+void BPlusTree::setValueLog(bool enabled, double gcGarbageRatio) {
+    valueLogRequested = enabled;
+    valueLogGcRatio = gcGarbageRatio;
+}
+
+/**
+ * @brief 把值转换为写入叶子值槽的形式
+ * @param value 完整的值
+ * @param stored 输出参数，值日志指针；短值（不含'\0'且不与指针混淆）原样输出
+ * @return false如果值日志追加或溢出页分配失败，调用方不能修改叶子
+ *
+ * 未启用值日志和溢出页时原样输出，由KeyValue按VALUE_SIZE截断
+ */
+bool BPlusTree::storeValue(const std::string& value, std::string& stored) {
+    if (!valueLog.isOpen()) {
+        if (metadata.overflowPages) return storeOverflowValue(value, stored);
+        stored = value;
+        return true;
+    }
+    bool inlineValue = value.size() < (size_t)VALUE_POINTER_SIZE &&
+                       value.find('\0') == std::string::npos &&
+                       (value.empty() || value[0] != '\x01');
+    if (inlineValue) {
+        stored = value;
+        return true;
+    }
+
+    stored = valueLog.append(value);
+    if (stored.empty()) {
+        std::cerr << "Value log append failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 由storeValue输出的内容组装记录
+ *
+ * 溢出指针连同值槽末字节的标记一起写入；其余的值经KeyValue截断，标记字节为0
+ */
+KeyValue BPlusTree::storedRecord(const std::string& key, const std::string& rowId,
+                                 const std::string& stored) const {
+    KeyValue kv(key, rowId, stored);
+    if (metadata.overflowPages && isOverflowPointer(stored)) {
+        memcpy(kv.value, stored.data(), VALUE_SIZE);
+    }
+    return kv;
+}
+
+/**
+ * @brief 由叶子值槽中保存的内容得到完整的值
+ */
+std::string BPlusTree::loadValue(const std::string& stored) {
+    if (!valueLog.isOpen()) {
+        return metadata.overflowPages ? loadOverflowValue(stored) : stored;
+    }
+    if (!ValueLog::isPointer(stored)) return stored;
+    std::string value;
+    if (!valueLog.read(stored, value)) {
+        std::cerr << "Dangling value log pointer" << std::endl;
+        value.clear();
+    }
+    return value;
+}
+
+/**
+ * @brief 解析记录中的值日志或溢出页指针，值超出VALUE_SIZE-1字节时截断
+ */
+KeyValue BPlusTree::loadRecord(const KeyValue& record) {
+    std::string stored = record.getValue();
+    bool pointer = valueLog.isOpen() ? ValueLog::isPointer(stored)
+                                     : metadata.overflowPages &&
+                                           isOverflowPointer(stored);
+    if (!pointer) return record;
+    return KeyValue(record.getKey(), record.getRowId(), loadValue(stored));
+}
+
+/**
+ * @brief 叶子中的值被覆盖或删除，指向的日志空间计为垃圾，溢出页被释放
+ */
+void BPlusTree::releaseValue(const std::string& stored) {
+    if (valueLog.isOpen()) {
+        valueLog.release(stored);
+        return;
+    }
+    int firstPageId;
+    size_t length;
+    if (!metadata.overflowPages ||
+        !parseOverflowPointer(stored, firstPageId, length) || firstPageId <= 0) {
+        return;
+    }
+
+    // 多版本读快照的旧版本仍引用这些溢出页，快照全部结束后再释放
+    if (snapshotsActive()) {
+        deferredOverflow.push_back(firstPageId);
+        return;
+    }
+    for (int deferred : deferredOverflow) {
+        releaseOverflowChain(deferred);
+    }
+    deferredOverflow.clear();
+    releaseOverflowChain(firstPageId);
+}
+
+/**
+ * @brief 写操作开始前检查垃圾占比，超过阈值时回收
+ *
+ * 只在写操作修改树之前调用，回收时没有持有任何叶子或未写入的指针
+ */
+void BPlusTree::maybeCollectValueLog() {
+    if (!valueLog.isOpen() || valueLogGcRatio <= 0) return;
+    uint64_t garbage = valueLog.garbageBytes();
+    if (garbage < VALUE_LOG_GC_MIN_BYTES ||
+        garbage < valueLogGcRatio * valueLog.totalBytes()) {
+        return;
+    }
+    collectValueLog();
+}
+
+/**
+ * @brief 回收值日志
+ * @return 释放的字节数
+ *
+ * 先把缓冲的消息应用到叶子，再沿叶子链表把每个指针指向的值追加到新一代文件
+ * 并原位改写指针；提交后旧文件不再被引用，才将其删除。中途失败或崩溃时
+ * 新旧文件都保留，叶子引用的值在任一代中都可读取。多版本读快照的旧版本
+ * 同样引用日志，有快照时不回收
+ */
+uint64_t BPlusTree::collectValueLog() {
+    if (!valueLog.isOpen() || !bufferPool || snapshotsActive()) return 0;
+    flushAllMessages();
+    uint32_t generation = valueLog.startGeneration();
+    if (generation == 0) return 0;
+
+    int leafId = -1;
+    {
+        BPlusTreeCursor cursor = seek("");
+        if (cursor.isValid()) leafId = cursor.leaf->header.pageId;
+    }
+
+    // 每个叶子读入后立即改写并标记脏页，之后被淘汰时写回
+    while (leafId != -1) {
+        auto leaf = loadPage(leafId);
+        if (!leaf) return 0;
+        bool changed = false;
+        for (int i = 0; i < leaf->header.keyCount; i++) {
+            std::string stored = leaf->keys.getValue(i);
+            if (!ValueLog::isPointer(stored)) continue;
+            std::string value;
+            if (!valueLog.read(stored, value)) continue;  // 值已丢失，保持原样
+            std::string moved = valueLog.append(value);
+            if (moved.empty()) return 0;
+            leaf->keys.setValue(i, moved);
+            changed = true;
+        }
+        if (changed) {
+            leaf->dirty = true;
+            bufferPool->markDirty(leafId);
+        }
+        leafId = leaf->header.nextLeafId;
+    }
+
+    if (!commit()) return 0;
+    return valueLog.dropGenerationsBefore(generation);
+}
+
+/**
+ * @brief 获取值日志统计信息
+ */
+ValueLog::Stats BPlusTree::getValueLogStats() const {
+    return valueLog.getStats();
+}
+
+// ================================ 溢出页 ================================
+
+/**
+ * @brief 设置超长值是否溢出到溢出页
+ * @param enabled 是否启用
+ *
+ * 仅对之后的create调用生效；文件一旦启用，之后打开时始终生效
+ */
+void BPlusTree::setOverflowPages(bool enabled) { overflowRequested = enabled; }
+
+/**
+ * @brief 分配一个溢出页
+ *
+ * 优先复用空闲链表中的页面，否则经createNewPage分配；
+ * 溢出页计入overflowPageCount而不是树的节点数
+ */
+std::shared_ptr<BPlusTreeNode> BPlusTree::allocateOverflowPage() {
+    std::shared_ptr<BPlusTreeNode> page;
+    if (metadata.freeOverflowPage > 0) {
+        page = loadPage(metadata.freeOverflowPage);
+        if (page) {
+            metadata.freeOverflowPage = page->header.nextLeafId;
+            int pageId = page->header.pageId;
+            memset(page->frame, 0, PAGE_SIZE);
+            page->header.pageId = pageId;
+            page->header.parentId = -1;
+            page->header.isLeaf = true;
+            page->header.nextLeafId = -1;
+            page->attachFrame();
+        }
+    }
+    if (!page) {
+        page = createNewPage(true);
+        if (!page) return nullptr;
+        metadata.pageCount--;
+    }
+    metadata.overflowPageCount++;
+    return page;
+}
+
+/**
+ * @brief 把值转换为写入叶子值槽的形式
+ * @param value 完整的值
+ * @param stored 输出参数，能放入值槽的值原样输出，否则为溢出指针
+ * @return false如果分配溢出页失败，已分配的溢出页被释放
+ *
+ * 超出VALUE_SIZE-1字节或含'\0'的值写成溢出指针：
+ * 叶子保留最多110字节的前缀，其余部分依次写入溢出页
+ */
+bool BPlusTree::storeOverflowValue(const std::string& value,
+                                   std::string& stored) {
+    bool inlineValue = value.size() < (size_t)VALUE_SIZE &&
+                       value.find('\0') == std::string::npos;
+    if (inlineValue) {
+        stored = value;
+        return true;
+    }
+
+    size_t prefixLength = std::min(
+        {value.size(), OVERFLOW_INLINE_PREFIX, strnlen(value.c_str(), value.size())});
+
+    // 从后向前写，每页写入时已知下一页的ID
+    int nextPageId = 0;
+    size_t remaining = value.size() - prefixLength;
+    size_t pages = (remaining + OVERFLOW_PAGE_PAYLOAD - 1) / OVERFLOW_PAGE_PAYLOAD;
+    for (size_t i = pages; i-- > 0;) {
+        auto page = allocateOverflowPage();
+        if (!page) {
+            std::cerr << "Overflow page allocation failed" << std::endl;
+            releaseOverflowChain(nextPageId);
+            return false;
+        }
+        size_t offset = prefixLength + i * OVERFLOW_PAGE_PAYLOAD;
+        size_t n = std::min(OVERFLOW_PAGE_PAYLOAD, value.size() - offset);
+        memcpy(page->frame + sizeof(PageHeader), value.data() + offset, n);
+        page->header.nextLeafId = nextPageId;
+        page->dirty = true;
+        bufferPool->markDirty(page->header.pageId);
+        nextPageId = page->header.pageId;
+    }
+
+    char header[OVERFLOW_HEADER_LENGTH + 1];
+    snprintf(header, sizeof(header), "%08x%08x", (unsigned)nextPageId,
+             (unsigned)value.size());
+    stored.assign(VALUE_SIZE, '\0');
+    memcpy(&stored[0], header, OVERFLOW_HEADER_LENGTH);
+    memcpy(&stored[OVERFLOW_HEADER_LENGTH], value.data(), prefixLength);
+    stored[VALUE_SIZE - 1] = OVERFLOW_SLOT_MARK;
+    return true;
+}
+
+/**
+ * @brief 由叶子值槽中保存的内容得到完整的值
+ */
+std::string BPlusTree::loadOverflowValue(const std::string& stored) {
+    std::string value;
+    if (!readOverflowValue(stored, value,
+                           [this](int pageId) { return loadPage(pageId); })) {
+        return stored;
+    }
+    return value;
+}
+
+/**
+ * @brief 把溢出链上的页面放入空闲链表
+ */
+void BPlusTree::releaseOverflowChain(int firstPageId) {
+    int pageId = firstPageId;
+    while (pageId > 0) {
+        auto page = loadPage(pageId);
+        if (!page) break;
+        int next = page->header.nextLeafId;
+        page->header.nextLeafId = metadata.freeOverflowPage;
+        page->dirty = true;
+        bufferPool->markDirty(pageId);
+        metadata.freeOverflowPage = pageId;
+        metadata.overflowPageCount--;
+        pageId = next;
+    }
+}
+
+// ================================ 范围扫描与预读 ================================
+
+/**
+ * @brief 游标是否指向有效记录
+ */
+bool BPlusTreeCursor::isValid() const {
+    return leaf && index >= 0 && index < leaf->header.keyCount;
+}
+
+/**
+ * @brief 获取游标当前记录
+ */
+KeyValue BPlusTreeCursor::current() const {
+    return tree->loadRecord(leaf->keys.get(index));
+}
+
+std::string BPlusTreeCursor::key() const { return leaf->keys.getKey(index); }
+
+std::string BPlusTreeCursor::value() const {
+    return tree->loadValue(leaf->keys.getValue(index));
+}
+
+std::string BPlusTreeCursor::rowId() const {
+    return leaf->keys.getRowId(index);
+}
+
+/**
+ * @brief 移动到下一条记录，必要时沿叶子链表跨到下一个叶子
+ */
+void BPlusTreeCursor::next() {
+    if (!leaf) return;
+    index++;
+    while (leaf && index >= leaf->header.keyCount) {
+        tree->advanceCursorLeaf(*this);
+    }
+}
+
+/**
+ * @brief 定位到第一个不小于key的记录
+ * @param key 起始键
+ * @return 游标
+ */
+BPlusTreeCursor BPlusTree::seek(const std::string& key) {
+    flushAllMessages();                      // 游标沿叶子链表读取，先应用所有消息
+
+    BPlusTreeCursor cursor;
+    cursor.tree = this;
+    cursor.readAheadWindow = readAheadMin;
+
+    cursor.leaf = findLeafNode(key, &cursor.path);
+    if (!cursor.leaf) return cursor;
+
+    cursor.index = cursor.leaf->findKey(key);
+    // 当前叶子中没有不小于key的记录时移动到后续叶子
+    while (cursor.leaf && cursor.index >= cursor.leaf->header.keyCount) {
+        advanceCursorLeaf(cursor);
+    }
+    return cursor;
+}
+
+/**
+ * @brief 范围查询
+ * @param startKey 起始键（包含）
+ * @param endKey 结束键（包含）
+ * @param limit 最多返回的记录数，-1表示不限制
+ * @return 按键有序的记录列表
+ */
+std::vector<KeyValue> BPlusTree::scan(const std::string& startKey,
+                                      const std::string& endKey, int limit) {
+    std::vector<KeyValue> result;
+    for (auto cursor = seek(startKey); cursor.isValid(); cursor.next()) {
+        if (limit >= 0 && (int)result.size() >= limit) break;
+        if (cursor.key() > endKey) break;
+        result.push_back(cursor.current());
+    }
+    return result;
+}
+
+/**
+ * @brief 设置顺序扫描的自适应预读窗口
+ * @param minPages 初始预读页数
+ * @param maxPages 预读窗口上限，0表示禁用
+ */
+void BPlusTree::setReadAhead(int minPages, int maxPages) {
+    readAheadMin = std::max(1, minPages);
+    readAheadMax = std::max(0, maxPages);
+}
+
+/**
+ * @brief 游标移动到下一个叶子
+ * @param cursor 游标
+ *
+ * 沿nextLeafId移动，同时推进父路径；路径与叶子链表不一致时重新下降定位，
+ * 随后根据顺序访问情况触发预读
+ */
+void BPlusTree::advanceCursorLeaf(BPlusTreeCursor& cursor) {
+    int nextLeafId = cursor.leaf->header.nextLeafId;
+    if (nextLeafId == -1) {
+        cursor.leaf.reset();                 // 到达最后一个叶子
+        cursor.path.clear();
+        return;
+    }
+
+    cursor.leaf = loadPage(nextLeafId);
+    cursor.index = 0;
+    if (!cursor.leaf) {
+        cursor.path.clear();
+        return;
+    }
+
+    // 同步父路径
+    bool pathInSync = advancePath(cursor.path) && !cursor.path.empty() &&
+                      cursor.path.back().first->children[cursor.path.back().second] ==
+                          nextLeafId;
+    if (!pathInSync && cursor.leaf->header.keyCount > 0) {
+        findLeafNode(cursor.leaf->keys.getKey(0), &cursor.path);
+        cursor.prefetchedAhead = 0;
+    }
+
+    if (cursor.prefetchedAhead > 0) {
+        cursor.prefetchedAhead--;
+    }
+    cursor.sequentialLeaves++;
+    readAhead(cursor);
+}
+
+/**
+ * @brief 根据顺序访问情况异步预取后续叶子
+ * @param cursor 游标
+ *
+ * 连续访问两个以上叶子后开始预取，已预取的叶子消耗过半时补充下一窗口，
+ * 每次补充后窗口翻倍，直到上限（不超过缓冲池容量的四分之一）
+ */
+void BPlusTree::readAhead(BPlusTreeCursor& cursor) {
+    if (readAheadMax <= 0 || !bufferPool || cursor.path.empty()) return;
+    if (cursor.sequentialLeaves < 2) return;
+    if (cursor.prefetchedAhead > cursor.readAheadWindow / 2) return;
+
+    int limit = std::min<int>(readAheadMax, bufferPool->capacity() / 4);
+    int window = std::max(1, std::min(cursor.readAheadWindow, limit));
+
+    // 从父节点的子节点数组中取出后续叶子ID，跨父节点时继续向上推进
+    TreePath lookahead = cursor.path;
+    std::vector<int> pageIds;
+    int skipped = 0;
+    while ((int)pageIds.size() < window - cursor.prefetchedAhead &&
+           advancePath(lookahead)) {
+        if (skipped < cursor.prefetchedAhead) {
+            skipped++;                       // 已预取过的叶子
+            continue;
+        }
+        pageIds.push_back(
+            lookahead.back().first->children[lookahead.back().second]);
+    }
+
+    prefetchPages(pageIds);
+    cursor.prefetchedAhead += static_cast<int>(pageIds.size());
+    cursor.readAheadWindow = std::min(cursor.readAheadWindow * 2, limit);
+}
+
+/**
+ * @brief 将查找路径推进到下一个叶子位置
+ * @param path 查找路径，最后一项为叶子的父节点
+ * @return false如果已经是最后一个叶子
+ *
+ * 只加载内部节点，不读取叶子页面
+ */
+bool BPlusTree::advancePath(TreePath& path) {
+    if (path.empty()) return false;
+
+    // 找到仍有右侧子节点的最低层
+    int level = static_cast<int>(path.size()) - 1;
+    while (level >= 0 &&
+           path[level].second + 1 > path[level].first->header.keyCount) {
+        level--;
+    }
+    if (level < 0) return false;
+
+    path[level].second++;
+
+    // 向下沿最左路径重建路径
+    for (size_t l = level + 1; l < path.size(); l++) {
+        auto& parent = path[l - 1];
+        auto child = loadPage(parent.first->children[parent.second]);
+        if (!child || child->header.isLeaf) {
+            path.resize(l);
+            return false;
+        }
+        path[l] = {child, 0};
+    }
+    return true;
+}
+
+/**
+ * @brief 获取B+树统计信息
+ * @return TreeStats 结构，包含树的各种统计信息
+ * 
+ * 计算并返回B+树的高度、节点数、填充因子等统计信息
+ */
+TreeStats BPlusTree::getStat() {
+    TreeStats stats;
+    stats.bloomFilterRejects = bloomRejectCount;
+    stats.activeSnapshots = snapshotsActive() ? liveSnapshots.size() : 0;
+    stats.retainedVersions = retainedVersionCount;
+    for (const auto& buffer : messageBuffers) {
+        stats.bufferedMessages += buffer.second.size();
+    }
+    stats.messageFlushes = messageFlushCount;
+    stats.overflowPages = metadata.overflowPageCount;
+
+    // 检查树是否为空
+    if (metadata.rootPageId == -1) {
+        return stats;                        // 返回默认统计信息
+    }
+
+    // 加载根节点并计算统计信息
+    auto root = loadPage(metadata.rootPageId);
+    if (root) {
+        stats.height = calculateHeight(root);         // 计算树高度
+        stats.nodeCount = metadata.pageCount;        // 节点总数
+        stats.splitCount = metadata.splitCount;      // 分裂次数
+        stats.mergeCount = metadata.mergeCount;      // 合并次数
+        stats.redistributionCount = metadata.redistributionCount;
+        stats.threeWaySplitCount = metadata.threeWaySplitCount;
+        stats.avoidedUnderflowCount = metadata.avoidedUnderflowCount;
+        stats.fillFactor = calculateFillFactor();    // 填充因子
+        stats.fileWriteCount = fileWriteCount;       // 文件写入次数
+    }
+
+    return stats;
+}
+
+/**
+ * @brief 计算B+树的高度
+ * @param node 起始节点（通常是根节点）
+ * @return 树的高度
+ * 
+ * 从给定节点开始，沿着最左路径计算到叶子节点的高度
+ */
+int BPlusTree::calculateHeight(std::shared_ptr<BPlusTreeNode> node) {
+    if (!node) return 0;                     // 空节点高度为0
+
+    int height = 0;
+    auto current = node;
+
+    // 使用迭代而不是递归，沿着最左路径向下
+    while (current && !current->header.isLeaf) {
+        height++;                            // 增加高度计数
+        // 检查子节点的有效性
+        if (current->children.empty() || current->children[0] == -1) {
+            break;                           // 无有效子节点，停止
+        }
+        current = loadPage(current->children[0]);  // 移动到第一个子节点
+    }
+
+    return height + 1;                       // +1 for leaf level
+}
+
+/**
+ * @brief 计算B+树的填充因子
+ * @return 填充因子（0.0到1.0之间的值）
+ * 
+ * 遍历整个树，计算所有节点的平均填充程度
+ */
+double BPlusTree::calculateFillFactor() {
+    // 检查树是否为空
+    if (metadata.pageCount == 0 || metadata.rootPageId == -1) {
+        return 0.0;                          // 空树的填充因子为0
+    }
+
+    int totalKeys = 0;                       // 总键数
+    int totalCapacity = 0;                   // 总容量
+
+    // 使用队列进行层次遍历
+    std::queue<int> nodeQueue;
+    nodeQueue.push(metadata.rootPageId);
+
+    while (!nodeQueue.empty()) {
+        int pageId = nodeQueue.front();
+        nodeQueue.pop();
+
+        // 加载当前节点
+        auto node = loadPage(pageId);
+        if (!node) continue;                 // 加载失败，跳过
+
+        // 累计键数和容量
+        totalKeys += node->header.keyCount;
+        totalCapacity += node->keys.capacity();
+
+        // 对于内部节点，将子节点加入队列
+        if (!node->header.isLeaf) {
+            for (int i = 0;
+                 i <= node->header.keyCount && i < (int)node->children.size();
+                 i++) {
+                if (node->children[i] != -1) {
+                    nodeQueue.push(node->children[i]);
+                }
+            }
+        }
+    }
+
+    // 计算填充因子
+    return totalCapacity > 0 ? (double)totalKeys / totalCapacity : 0.0;
+}
+
+/**
+ * @brief 设置缓冲池大小
+ * @param size 新的缓冲池大小
+ * 
+ * 创建新的缓冲池并迁移数据，刷新旧缓冲池中的所有页面
+ */
+void BPlusTree::setBufferPoolSize(size_t size) {
+    if (bufferPool) {
+        // 创建新的缓冲池
+        auto newBufferPool = std::make_unique<BufferPool>(size);
+
+        // 刷新旧缓冲池中的所有页面
+        bufferPool->flushAllPages();
+        // 切换到新缓冲池并设置保存回调函数
+        bufferPool = std::move(newBufferPool);
+        attachBufferPoolCallbacks();
+        pinUpperLevels();
+    }
+}
+
+/**
+ * @brief 获取缓冲池统计信息
+ * @return BufferPool::Stats 缓冲池统计信息
+ * 
+ * 返回缓冲池的命中率、页面数等统计信息
+ */
+BufferPool::Stats BPlusTree::getBufferPoolStats() const {
+    if (bufferPool) {
+        return bufferPool->getStats();       // 返回缓冲池统计信息
+    }
+    return BufferPool::Stats();              // 返回默认统计信息
+}
+
+/**
+ * @brief 设置常驻内存的内部节点层数
+ * @param levels 自根起常驻的层数，-1表示全部内部节点，0表示不常驻
+ *
+ * 树已打开时立即按新层数加载或释放常驻页面
+ */
+void BPlusTree::setResidentLevels(int levels) {
+    residentLevels = std::max(-1, levels);
+    pinUpperLevels();
+}
+
+/**
+ * @brief 按当前根重新确定常驻页面
+ *
+ * 释放原有的常驻页面后逐层加载内部节点并移入常驻区；
+ * 层数由最左路径得到，之后只沿内部节点展开，不读入其余叶子页面
+ */
+void BPlusTree::pinUpperLevels() {
+    if (!bufferPool) return;
+    bufferPool->releaseAllResident();
+    residentRootId = metadata.rootPageId;
+    if (residentLevels == 0 || metadata.rootPageId == -1) return;
+
+    int internalLevels = calculateHeight(loadPage(metadata.rootPageId)) - 1;
+    if (residentLevels > 0) {
+        internalLevels = std::min(internalLevels, residentLevels);
+    }
+
+    std::vector<int> level = {metadata.rootPageId};
+    for (int depth = 0; depth < internalLevels && !level.empty(); depth++) {
+        std::vector<int> next;
+        for (int pageId : level) {
+            auto node = loadPage(pageId);
+            if (!node || node->header.isLeaf) continue;
+            bufferPool->makeResident(pageId);
+            if (depth + 1 < internalLevels) {
+                for (int childId : node->children) {
+                    if (childId != -1) next.push_back(childId);
+                }
+            }
+        }
+        level.swap(next);
+    }
+}
+
+/**
+ * @brief 设置点查询结果缓存的容量
+ * @param capacity 最多缓存的键数，0表示禁用
+ *
+ * 缩小容量时按LRU淘汰多出的条目
+ */
+void BPlusTree::setRecordCacheSize(size_t capacity) {
+    recordCache.setCapacity(capacity);
+}
+
+/**
+ * @brief 获取点查询结果缓存的统计信息
+ * @return RecordCache::Stats 命中率、条目数等统计信息
+ */
+RecordCache::Stats BPlusTree::getRecordCacheStats() const {
+    return recordCache.getStats();
+}
+
+/**
+ * @brief 刷新缓冲池中的所有页面
+ * @return 刷新的页面数量
+ * 
+ * 强制将缓冲池中的所有脏页写回磁盘
+ */
+int BPlusTree::flushBuffer() {
+    if (bufferPool) {
+        flushAllMessages();                  // 先把缓冲的消息应用到叶子
+        return bufferPool->flushAllPages();  // 刷新所有页面
+    }
+    return 0;                               // 无缓冲池，返回0
+}
+
+/**
+ * @brief 打印缓冲池状态信息
+ * 
+ * 输出缓冲池的当前状态，用于调试和监控
+ */
+void BPlusTree::printBufferPoolStatus() const {
+    if (bufferPool) {
+        bufferPool->printStatus();           // 打印缓冲池状态
+    }
+}
+
+/**
+ * @brief 打印整个B+树结构
+ * 
+ * 以层次结构方式打印整个B+树，用于调试和可视化
+ */
+void BPlusTree::printTree() {
+    // 检查树是否为空
+    if (metadata.rootPageId == -1) {
+        std::cout << "Empty tree" << std::endl;
+        return;
+    }
+
+    // 从根节点开始打印
+    auto root = loadPage(metadata.rootPageId);
+    printNode(root, 0);                      // 从第0层开始打印
+}
+
+/**
+ * @brief 递归打印节点及其子树
+ * @param node 要打印的节点
+ * @param level 当前层次（用于缩进）
+ * 
+ * 递归打印节点信息和其所有子节点，形成树状结构显示
+ */
+void BPlusTree::printNode(std::shared_ptr<BPlusTreeNode> node, int level) {
+    if (!node) return;                       // 空节点，直接返回
+
+    // 根据层次打印缩进
+    for (int i = 0; i < level; i++) {
+        std::cout << "  ";                   // 每层缩进2个空格
+    }
+
+    // 打印节点基本信息
+    std::cout << "Page " << node->header.pageId << " ("
+              << (node->header.isLeaf ? "Leaf" : "Internal")
+              << ", Keys: " << node->header.keyCount << "): ";
+
+    // 打印节点中的所有键
+    for (int i = 0; i < node->header.keyCount; i++) {
+        std::cout << node->keys.getKey(i) << " ";
+    }
+    std::cout << std::endl;
+
+    // 对于内部节点，递归打印所有子节点
+    if (!node->header.isLeaf) {
+        for (int i = 0;
+             i <= node->header.keyCount && i < (int)node->children.size();
+             i++) {
+            if (node->children[i] != -1) {
+                auto child = loadPage(node->children[i]);
+                printNode(child, level + 1); // 递归打印子节点，层次+1
+            }
+        }
+    }
 }
\ No newline at end of file
@@ -1,213 +1,1198 @@
-#pragma once
-
-#include <algorithm>
-#include <cstring>
-#include <fstream>
-#include <iostream>
-#include <map>
-#include <memory>
-#include <string>
-#include <vector>
-
-#include "BufferPool.h"
-
-// 页面头部信息
-struct PageHeader {
-    int pageId;
-    int parentId;
-    bool isLeaf;
-    int keyCount;
-    int nextLeafId;  // 叶子节点链表
-
-    PageHeader()
-        : pageId(-1), parentId(-1), isLeaf(true), keyCount(0), nextLeafId(-1) {}
-};
-
-// 常量定义
-const int PAGE_SIZE = 1024 * 4;       // 页面大小
-const int METADATA_SIZE = 16384;  // 元数据大小 16KB
-const int KEY_SIZE = 64;          // 键的固定长度
-const int ROW_ID_SIZE = 32;       // rowId的固定长度
-const int VALUE_SIZE = 128;       // 值的固定长度
-const int MAX_KEYS_PER_PAGE = (PAGE_SIZE - sizeof(PageHeader)) / (KEY_SIZE + ROW_ID_SIZE + VALUE_SIZE);
-// 最大每页键数，考虑到页面头部和键值对的大小
-
-// 前向声明
-class BPlusTreeNode;
-class BPlusTree;
-
-// 键值对结构
-struct KeyValue {
-    char key[KEY_SIZE];
-    char rowId[ROW_ID_SIZE];
-    char value[VALUE_SIZE];
-
-    KeyValue() {
-        memset(key, 0, KEY_SIZE);
-        memset(rowId, 0, ROW_ID_SIZE);
-        memset(value, 0, VALUE_SIZE);
-    }
-
-    KeyValue(const std::string& k, const std::string& rid,
-             const std::string& v) {
-        memset(key, 0, KEY_SIZE);
-        memset(rowId, 0, ROW_ID_SIZE);
-        memset(value, 0, VALUE_SIZE);
-
-        strncpy(key, k.c_str(), std::min(k.length(), (size_t)KEY_SIZE - 1));
-        strncpy(rowId, rid.c_str(),
-                std::min(rid.length(), (size_t)ROW_ID_SIZE - 1));
-        strncpy(value, v.c_str(), std::min(v.length(), (size_t)VALUE_SIZE - 1));
-    }
-
-    std::string getKey() const { return std::string(key); }
-    std::string getRowId() const { return std::string(rowId); }
-    std::string getValue() const { return std::string(value); }
-};
-
-// B+树节点
-class BPlusTreeNode {
-   public:
-    PageHeader header;
-    std::vector<KeyValue> keys;
-    std::vector<int> children;  // 子节点页面ID
-    bool dirty;                 // 脏页标记
-
-    BPlusTreeNode(int pageId = -1, bool isLeaf = true);
-    ~BPlusTreeNode() = default;
-
-    // 序列化和反序列化
-    void serialize(char* buffer) const;
-    void deserialize(const char* buffer);
-
-    // 节点操作
-    bool isFull() const;
-    int findKey(const std::string& key) const;
-    void insertKey(const KeyValue& kv, int childId = -1);
-    void removeKey(int index);
-    void split(std::shared_ptr<BPlusTreeNode> newNode, KeyValue& promotedKey);
-
-   private:
-    static const int MAX_KEYS = MAX_KEYS_PER_PAGE;
-    
-};
-
-// 统计信息
-struct TreeStats {
-    int height;
-    int nodeCount;
-    int splitCount;
-    int mergeCount;
-    double fillFactor;
-    size_t fileWriteCount;  // 文件写入计数
-
-    TreeStats()
-        : height(0),
-          nodeCount(0),
-          splitCount(0),
-          mergeCount(0),
-          fillFactor(0.0),
-          fileWriteCount(0)  // 初始化文件写入计数
-    {}
-};
-
-// 元数据结构
-struct Metadata {
-    int rootPageId;
-    int nextPageId;
-    int pageCount;
-    int splitCount;
-    int mergeCount;
-    char padding[METADATA_SIZE - 5 * sizeof(int)];
-
-    Metadata()
-        : rootPageId(-1),
-          nextPageId(1),
-          pageCount(0),
-          splitCount(0),
-          mergeCount(0) {
-        memset(padding, 0, sizeof(padding));
-    }
-};
-
-// B+树主类
-class BPlusTree {
-   private:
-    std::string filename;
-    std::fstream file;
-    Metadata metadata;
-    std::unique_ptr<BufferPool> bufferPool;  // 使用BufferPool替代简单的map缓存
-    size_t fileWriteCount;                   // 文件写入计数, 用于调试和性能分析
-
-    // 页面管理
-    std::shared_ptr<BPlusTreeNode> loadPage(int pageId);
-    void savePage(std::shared_ptr<BPlusTreeNode> node);
-    std::shared_ptr<BPlusTreeNode> createNewPage(bool isLeaf = true);
-    void saveMetadata();
-    void loadMetadata();
-
-    // B+树操作辅助函数
-    std::shared_ptr<BPlusTreeNode> findLeafNode(const std::string& key);
-    void insertInternal(std::shared_ptr<BPlusTreeNode> node, const KeyValue& kv,
-                        int rightChildId = -1);
-    void handleOverflow(std::shared_ptr<BPlusTreeNode> node);
-    void handleUnderflow(std::shared_ptr<BPlusTreeNode> node);
-
-    // 统计辅助函数
-    int calculateHeight(std::shared_ptr<BPlusTreeNode> node);
-    double calculateFillFactor();
-    void mergeNodes(std::shared_ptr<BPlusTreeNode> leftNode,
-                    std::shared_ptr<BPlusTreeNode> rightNode,
-                    std::shared_ptr<BPlusTreeNode> parent, int parentKeyIndex);
-
-    void redistributeFromLeft(std::shared_ptr<BPlusTreeNode> node,
-                              std::shared_ptr<BPlusTreeNode> leftSibling,
-                              std::shared_ptr<BPlusTreeNode> parent,
-                              int parentKeyIndex);
-    void redistributeFromRight(std::shared_ptr<BPlusTreeNode> node,
-                               std::shared_ptr<BPlusTreeNode> rightSibling,
-                               std::shared_ptr<BPlusTreeNode> parent,
-                               int parentKeyIndex);
-
-   public:
-    BPlusTree();
-    ~BPlusTree();
-
-    // 主要接口
-    bool create(const std::string& filename, int pageSize = PAGE_SIZE,
-                size_t bufferPoolSize = 100);
-    void close();
-    bool insert(const std::string& key, const std::vector<std::string>& value,
-                const std::string& rowId);
-    std::vector<std::vector<std::string>> get(const std::string& key);
-    bool remove(const std::string& key);
-    TreeStats getStat();
-
-    // BufferPool相关接口
-    /**
-     * @brief 设置缓冲池大小
-     * @param size 缓冲池大小（页面数）
-     */
-    void setBufferPoolSize(size_t size);
-
-    /**
-     * @brief 获取缓冲池统计信息
-     * @return BufferPool统计信息
-     */
-    BufferPool::Stats getBufferPoolStats() const;
-
-    /**
-     * @brief 刷新所有脏页到磁盘
-     * @return 刷新的页面数量
-     */
-    int flushBuffer();
-
-    /**
-     * @brief 打印缓冲池状态
-     */
-    void printBufferPoolStatus() const;
-
-    // 调试和测试
-    void printTree();
-    void printNode(std::shared_ptr<BPlusTreeNode> node, int level = 0);
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BloomFilter.h"
+#include "BufferPool.h"
+#include "RecordCache.h"
+#include "IOEngine.h"
+#include "StorageManager.h"
+#include "ValueLog.h"
+
+// 页面头部信息
+struct PageHeader {
+    int pageId;
+    int parentId;
+    bool isLeaf;
+    bool separatedValues;  // 叶子值槽只保存值日志指针（窄值槽），占用页面头的填充字节
+    int keyCount;
+    int nextLeafId;  // 叶子节点链表
+    short prefixLength;  // 页面中所有键的公共前缀长度
+    short suffixWidth;   // 键后缀槽宽度，0表示不压缩（完整KEY_SIZE键槽）
+
+    PageHeader()
+        : pageId(-1),
+          parentId(-1),
+          isLeaf(true),
+          separatedValues(false),
+          keyCount(0),
+          nextLeafId(-1),
+          prefixLength(0),
+          suffixWidth(0) {}
+};
+
+// 常量定义
+const int PAGE_SIZE = 1024 * 4;       // 页面大小
+const int METADATA_SIZE = 16384;  // 元数据大小 16KB
+const int KEY_SIZE = 64;          // 键的固定长度
+const int ROW_ID_SIZE = 32;       // rowId的固定长度
+const int VALUE_SIZE = 128;       // 值的固定长度
+const int VALUE_POINTER_SIZE = 32;  // 值日志模式下叶子值槽的宽度（指针或短值）
+const int PAGE_ALIGNMENT = 4096;  // 页面缓冲区对齐（满足O_DIRECT要求）
+const int METADATA_MAGIC = 0x31545042;  // 元数据中的文件标识（"BPT1"）
+const int FORMAT_VERSION = 1;           // 页面布局变化时递增，旧文件需要重建
+const int MAX_KEYS_PER_PAGE = (PAGE_SIZE - sizeof(PageHeader)) / (KEY_SIZE + ROW_ID_SIZE + VALUE_SIZE);
+// 最大每页键数，考虑到页面头部和键值对的大小
+
+// 前向声明
+class BPlusTreeNode;
+class BPlusTree;
+
+// 键值对结构
+struct KeyValue {
+    char key[KEY_SIZE];
+    char rowId[ROW_ID_SIZE];
+    char value[VALUE_SIZE];
+
+    KeyValue() {
+        memset(key, 0, KEY_SIZE);
+        memset(rowId, 0, ROW_ID_SIZE);
+        memset(value, 0, VALUE_SIZE);
+    }
+
+    KeyValue(const std::string& k, const std::string& rid,
+             const std::string& v) {
+        memset(key, 0, KEY_SIZE);
+        memset(rowId, 0, ROW_ID_SIZE);
+        memset(value, 0, VALUE_SIZE);
+
+        // 缓冲区已清零，复制截断后的长度即可保留结尾的0字节
+        memcpy(key, k.data(), std::min(k.length(), (size_t)KEY_SIZE - 1));
+        memcpy(rowId, rid.data(),
+               std::min(rid.length(), (size_t)ROW_ID_SIZE - 1));
+        memcpy(value, v.data(), std::min(v.length(), (size_t)VALUE_SIZE - 1));
+    }
+
+    std::string getKey() const { return std::string(key); }
+
+    /**
+     * @brief 按字节比较键，避免构造临时字符串
+     *
+     * 键不含0字节（KeyEncoder的编码结果也满足），逐字节比较与memcmp顺序一致
+     */
+    int compareKey(const std::string& other) const {
+        return strcmp(key, other.c_str());
+    }
+    std::string getRowId() const { return std::string(rowId); }
+
+    /**
+     * @brief 值槽中的内容
+     *
+     * 构造时值按VALUE_SIZE-1截断，末字节总为0；末字节不为0的值槽保存的是
+     * 溢出指针，整个值槽原样返回
+     */
+    std::string getValue() const {
+        return value[VALUE_SIZE - 1] ? std::string(value, VALUE_SIZE)
+                                     : std::string(value);
+    }
+};
+
+// 页面中各列区域的偏移：按最大键数预留，键区域紧跟页面头部，
+// 叶子节点之后是rowId和值区域，内部节点之后是子节点ID区域。
+// 压缩的页面按页面头中的前缀长度和后缀宽度计算各区域偏移
+const int KEY_REGION_OFFSET = sizeof(PageHeader);
+const int ROW_ID_REGION_OFFSET = KEY_REGION_OFFSET + MAX_KEYS_PER_PAGE * KEY_SIZE;
+const int VALUE_REGION_OFFSET =
+    ROW_ID_REGION_OFFSET + MAX_KEYS_PER_PAGE * ROW_ID_SIZE;
+const int CHILD_REGION_OFFSET = KEY_REGION_OFFSET + MAX_KEYS_PER_PAGE * KEY_SIZE;
+
+/**
+ * @brief 节点内记录的列式视图
+ *
+ * 键、rowId和值分别存放在页面帧中连续的区域里，节点内二分查找只访问键区域，
+ * 每个缓存行容纳一个完整的键，不再把160字节的rowId和值一起带入缓存。
+ * 记录直接在页面字节上读写，以KeyValue的形式按值交换。
+ * 内部节点只有键区域，rowId和值读出为空
+ *
+ * 压缩的页面在页面头之后只保存一次公共前缀，键区域中每个键只保存后缀，
+ * 后缀槽宽度为最长后缀+1；叶子的rowId和值区域、内部节点的子节点区域紧随其后，
+ * 每页可容纳的键数随之增加。新键不以当前前缀开头或后缀超出槽宽时，
+ * 整页按新的前缀和槽宽重新排布
+ *
+ * 值日志模式的叶子值槽宽度为VALUE_POINTER_SIZE，只保存指针或短值
+ */
+class KeyValueArray {
+   public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear();
+    void resize(size_t newCount);
+
+    /**
+     * @brief 当前布局下最多可容纳的记录数
+     */
+    size_t capacity() const { return layout().capacity; }
+
+    /**
+     * @brief 叶子值槽的宽度
+     */
+    size_t valueWidth() const { return layout().valueWidth; }
+
+    /**
+     * @brief 插入kv后（必要时重新排布）是否仍能放入页面
+     */
+    bool canInsert(const KeyValue& kv) const {
+        return count < capacityWith(kv);
+    }
+
+    /**
+     * @brief 用kv覆盖一个键后（必要时重新排布）是否仍能放入页面
+     */
+    bool canReplace(const KeyValue& kv) const {
+        return count <= capacityWith(kv);
+    }
+
+    /**
+     * @brief 启用前缀压缩（叶子和内部节点均可），只能在记录为空时调用
+     */
+    void enablePrefixCompression();
+    bool isCompressed() const;
+
+    /**
+     * @brief 页面公共前缀（不以0结尾）及其长度
+     */
+    const char* prefix() const { return frame + KEY_REGION_OFFSET; }
+    size_t prefixLength() const { return layout().prefixLength; }
+
+    /**
+     * @brief 第index个键去掉公共前缀后的部分，未压缩时即完整键
+     */
+    const char* suffix(size_t index) const {
+        Layout current = layout();
+        return frame + KEY_REGION_OFFSET + current.prefixLength +
+               index * current.suffixWidth;
+    }
+
+    /**
+     * @brief 完整键的原地指针，只用于未压缩的页面
+     */
+    const char* key(size_t index) const { return suffix(index); }
+    const char* rowId(size_t index) const;
+    const char* value(size_t index) const;
+
+    /**
+     * @brief 第index个键与other按字节比较，压缩时先比较公共前缀
+     */
+    int compareKey(size_t index, const char* other) const;
+    int compareKey(size_t index, const std::string& other) const {
+        return compareKey(index, other.c_str());
+    }
+    std::string getKey(size_t index) const;
+    std::string getRowId(size_t index) const {
+        return std::string(rowId(index));
+    }
+    std::string getValue(size_t index) const {
+        const char* slot = value(index);
+        size_t width = valueWidth();
+        return slot[width - 1] ? std::string(slot, width) : std::string(slot);
+    }
+
+    /**
+     * @brief 组装第index条记录
+     */
+    KeyValue get(size_t index) const;
+    KeyValue front() const { return get(0); }
+    KeyValue back() const { return get(count - 1); }
+
+    void set(size_t index, const KeyValue& kv);
+    void setRowId(size_t index, const std::string& rowId);
+    void setValue(size_t index, const std::string& value);
+
+    void insert(size_t index, const KeyValue& kv);
+    void erase(size_t index);
+    void push_back(const KeyValue& kv) { insert(count, kv); }
+    void pop_back() { count--; }
+
+    /**
+     * @brief 追加另一个数组的全部记录
+     */
+    void append(const KeyValueArray& other);
+
+    /**
+     * @brief 取出全部记录
+     */
+    std::vector<KeyValue> toVector() const;
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+        assignEntries(std::vector<KeyValue>(first, last));
+    }
+
+    /**
+     * @brief 有序记录全部放入一个前缀压缩叶子时的容量
+     */
+    static size_t compressedCapacity(const std::vector<KeyValue>& entries,
+                                     size_t valueWidth = VALUE_SIZE);
+
+   private:
+    friend class BPlusTreeNode;
+    friend class ChildArray;
+
+    // 页面中各列区域的排布
+    struct Layout {
+        size_t prefixLength;  // 公共前缀长度
+        size_t suffixWidth;   // 每个键槽的宽度
+        size_t capacity;      // 最大键数
+        size_t rowIdOffset;   // 叶子：rowId区域偏移
+        size_t valueOffset;   // 叶子：值区域偏移
+        size_t valueWidth;    // 叶子：每个值槽的宽度
+        size_t childOffset;   // 内部节点：子节点区域偏移（4字节对齐）
+    };
+
+    KeyValueArray(char* frame) : frame(frame), count(0) {}
+    KeyValueArray(const KeyValueArray&) = delete;
+    KeyValueArray& operator=(const KeyValueArray&) = delete;
+
+    PageHeader& pageHeader() const {
+        return *reinterpret_cast<PageHeader*>(frame);
+    }
+    bool isLeaf() const { return pageHeader().isLeaf; }
+
+    Layout layout() const;
+    static Layout makeLayout(size_t prefixLength, size_t suffixWidth,
+                             bool leaf, size_t valueWidth = VALUE_SIZE);
+    static Layout tightLayout(const std::vector<KeyValue>& entries, bool leaf,
+                              size_t valueWidth = VALUE_SIZE);
+
+    /**
+     * @brief 页面加入kv后按估算的新前缀和槽宽可容纳的键数（不大于实际值）
+     */
+    size_t capacityWith(const KeyValue& kv) const;
+
+    /**
+     * @brief kv的键能否不改变当前布局直接写入键槽
+     */
+    bool fitsLayout(const KeyValue& kv) const;
+
+    void writeEntry(size_t index, const KeyValue& kv, const Layout& current);
+
+    /**
+     * @brief 按记录计算最紧凑的前缀和槽宽，重新排布整页；内部节点的子节点随之移动
+     * @return false如果记录数超出新布局的容量（页面不做修改）
+     */
+    bool rebuild(const std::vector<KeyValue>& entries);
+    void assignEntries(const std::vector<KeyValue>& entries);
+
+    /**
+     * @brief 把[index, count)区间在各列中整体移动shift个位置
+     */
+    void shift(size_t index, int shift);
+
+    char* frame;   // 所属节点的页面帧
+    size_t count;  // 记录数，不超过当前布局的容量
+};
+
+/**
+ * @brief 内部节点子节点ID的视图，直接读写页面帧中的子节点区域
+ *
+ * 提供与std::vector<int>相同的常用接口，迭代器为int*
+ */
+class ChildArray {
+   public:
+    typedef int* iterator;
+    typedef const int* const_iterator;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+    void resize(size_t newCount);
+
+    int* data() {
+        return reinterpret_cast<int*>(frame + keys.layout().childOffset);
+    }
+    const int* data() const {
+        return reinterpret_cast<const int*>(frame + keys.layout().childOffset);
+    }
+    int& operator[](size_t index) { return data()[index]; }
+    int operator[](size_t index) const { return data()[index]; }
+    int& back() { return data()[count - 1]; }
+    int back() const { return data()[count - 1]; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + count; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + count; }
+
+    void insert(iterator pos, int childId);
+    void erase(iterator pos);
+    void push_back(int childId) { insert(end(), childId); }
+    void pop_back() { count--; }
+
+    bool operator==(const ChildArray& other) const {
+        return count == other.count && std::equal(begin(), end(), other.begin());
+    }
+
+   private:
+    friend class BPlusTreeNode;
+
+    ChildArray(char* frame, const KeyValueArray& keys)
+        : frame(frame), keys(keys), count(0) {}
+    ChildArray(const ChildArray&) = delete;
+    ChildArray& operator=(const ChildArray&) = delete;
+
+    char* frame;                // 所属节点的页面帧
+    const KeyValueArray& keys;  // 同一帧中的键，子节点区域位置由其布局决定
+    size_t count;               // 子节点数，不超过键容量+1
+};
+
+// 节点分裂策略
+enum class SplitPolicy {
+    EVEN,      // 均分（默认）
+    SKEWED,    // 90/10：左节点保留90%的键
+    ADAPTIVE   // 按最近插入位置：末尾插入时左节点保持满，开头插入时右节点保持满，否则均分
+};
+
+// B+树节点：页面帧的视图
+//
+// 节点持有一个对齐的页面帧，页面头、键和子节点都直接在帧中读写，
+// 从磁盘读入和写回时直接使用该帧，不再序列化/反序列化
+class BPlusTreeNode {
+   public:
+    char* const frame;          // 对齐的页面帧，大小为PAGE_SIZE
+    PageHeader& header;         // 帧中的页面头
+    KeyValueArray keys;         // 帧中列式存储的记录
+    ChildArray children;        // 帧中的子节点页面ID
+    bool dirty;                 // 脏页标记
+    int lastInsertPos;          // 最近一次插入的位置（不持久化，用于选择分裂点）
+
+    BPlusTreeNode(int pageId = -1, bool isLeaf = true);
+    ~BPlusTreeNode();
+
+    BPlusTreeNode(const BPlusTreeNode&) = delete;
+    BPlusTreeNode& operator=(const BPlusTreeNode&) = delete;
+
+    /**
+     * @brief 页面数据直接读入frame后，按页面头恢复键数和子节点数
+     */
+    void attachFrame();
+
+    // 序列化和反序列化（复制整个页面帧）
+    void serialize(char* buffer) const;
+    void deserialize(const char* buffer);
+
+    // 节点操作
+    bool isFull() const;
+    int findKey(const std::string& key) const;
+    void insertKey(const KeyValue& kv, int childId = -1);
+    void removeKey(int index);
+    void split(std::shared_ptr<BPlusTreeNode> newNode, KeyValue& promotedKey,
+               int splitPoint = -1);
+
+   private:
+    static const int MAX_KEYS = MAX_KEYS_PER_PAGE;
+    
+};
+
+/**
+ * @brief 读-改-写合并函数
+ * @param existing 现有值，键不存在时为nullptr
+ * @return 写入的新值
+ */
+using MergeFunction = std::function<std::string(const std::string* existing)>;
+
+/**
+ * @brief 可注册的合并操作符
+ * @param existing 现有值，键不存在时为nullptr
+ * @param operand 操作数
+ * @return 写入的新值
+ */
+using MergeOperator = std::function<std::string(const std::string* existing,
+                                                const std::string& operand)>;
+
+/**
+ * @brief 写优化模式下缓冲在内部节点中、尚未应用到叶子的写消息
+ */
+struct BufferedMessage {
+    enum class Type { PUT, DELETE, UPSERT };
+    Type type;
+    std::string value;      // PUT写入的值
+    std::string rowId;      // PUT/UPSERT的行ID，UPSERT为空时保留现有行ID
+    MergeFunction mergeFn;  // UPSERT的合并函数
+};
+
+// 一个内部节点的消息缓冲：按键有序，同一键的消息按写入顺序排列
+using MessageBuffer = std::map<std::string, std::vector<BufferedMessage>>;
+
+// 根到叶子的查找路径：内部节点及所选子节点下标
+using TreePath = std::vector<std::pair<std::shared_ptr<BPlusTreeNode>, int>>;
+
+/**
+ * @brief 沿叶子链表顺序扫描的游标
+ *
+ * 游标跨越叶子时按顺序访问模式自适应预读后续叶子页面；
+ * 对树的写操作会使已有游标失效
+ */
+class BPlusTreeCursor {
+   public:
+    BPlusTreeCursor()
+        : tree(nullptr),
+          index(0),
+          sequentialLeaves(0),
+          readAheadWindow(0),
+          prefetchedAhead(0) {}
+
+    /**
+     * @brief 游标是否指向有效记录
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 移动到下一条记录
+     */
+    void next();
+
+    /**
+     * @brief 当前记录，其中的值最多VALUE_SIZE-1字节，完整的值见value()
+     */
+    KeyValue current() const;
+    std::string key() const;
+    std::string value() const;
+    std::string rowId() const;
+
+   private:
+    friend class BPlusTree;
+
+    BPlusTree* tree;
+    std::shared_ptr<BPlusTreeNode> leaf;  // 当前叶子节点
+    int index;                            // 叶子内的记录下标
+    TreePath path;                        // 当前叶子的父路径，用于预测后续叶子
+    int sequentialLeaves;                 // 连续顺序访问的叶子数
+    int readAheadWindow;                  // 当前预读窗口（页面数）
+    int prefetchedAhead;                  // 当前叶子之后已提交预取的叶子数
+};
+
+/**
+ * @brief 写时复制模式下一个已提交版本的只读快照
+ *
+ * 直接读取该版本的物理页面，不经过缓冲池，之后的写操作和提交都不影响
+ * 快照看到的内容；持有期间该版本的页面不会被复用。快照之间不共享可变状态，
+ * 每个读者使用自己的快照对象，无需加锁
+ */
+class BPlusTreeSnapshot {
+   public:
+    BPlusTreeSnapshot() : rootPageId(-1), overflowPages(false) {}
+
+    /**
+     * @brief 快照是否有效（树未启用写时复制时无效）
+     */
+    bool isValid() const { return version != nullptr; }
+
+    /**
+     * @brief 快照对应的提交序号
+     */
+    uint64_t txnId() const { return version ? version->txnId : 0; }
+
+    std::vector<std::vector<std::string>> get(const std::string& key);
+
+    /**
+     * @brief 范围查询，语义与BPlusTree::scan相同
+     */
+    std::vector<KeyValue> scan(const std::string& startKey,
+                               const std::string& endKey, int limit = -1);
+
+   private:
+    friend class BPlusTree;
+
+    std::shared_ptr<ShadowStorageManager> storage;
+    std::shared_ptr<const ShadowVersion> version;
+    int rootPageId;
+    // 已读入的内部节点，版本不可变，可一直复用
+    std::unordered_map<int, std::shared_ptr<BPlusTreeNode>> internalNodes;
+
+    ValueLog::FileSet valueFiles;  // 值日志模式下固定的日志文件，回收后仍可读取
+    bool overflowPages;            // 该版本是否可能含有溢出页中的值
+
+    std::shared_ptr<BPlusTreeNode> loadPage(int pageId);
+    std::shared_ptr<BPlusTreeNode> findLeaf(const std::string& key);
+    std::string loadValue(const std::string& stored);
+};
+
+/**
+ * @brief 多版本读快照
+ *
+ * 看到开始时刻已完成的所有写操作，之后的写操作在原位置修改叶子前把旧版本
+ * 保存到按键组织的版本链中，快照读取时用旧版本替换当前记录。
+ * 读写双方都不等待对方；所有句柄释放后旧版本被回收。树关闭后快照失效
+ */
+class MVCCSnapshot {
+   public:
+    MVCCSnapshot() : tree(nullptr) {}
+
+    bool isValid() const { return tree && timestamp; }
+
+    /**
+     * @brief 快照的时间戳，时间戳不大于它的写操作可见
+     */
+    uint64_t getTimestamp() const { return timestamp ? *timestamp : 0; }
+
+    std::vector<std::vector<std::string>> get(const std::string& key);
+
+    /**
+     * @brief 范围查询，语义与BPlusTree::scan相同
+     */
+    std::vector<KeyValue> scan(const std::string& startKey,
+                               const std::string& endKey, int limit = -1);
+
+    /**
+     * @brief 提前释放快照，允许回收它需要的旧版本
+     */
+    void release() { timestamp.reset(); }
+
+   private:
+    friend class BPlusTree;
+
+    BPlusTree* tree;
+    std::shared_ptr<const uint64_t> timestamp;  // 树只持有弱引用
+};
+
+/**
+ * @brief 记录被某次写操作替换前的版本
+ */
+struct RecordVersion {
+    uint64_t endTimestamp;         // 替换它的写操作的时间戳
+    std::vector<KeyValue> records;  // 替换前该键的记录，空表示键不存在
+};
+
+/**
+ * @brief 批量写操作
+ *
+ * 收集一组插入和删除，由BPlusTree::write一次性按叶子分组应用；
+ * 同一键的多次操作以最后一次为准
+ */
+class WriteBatch {
+   public:
+    /**
+     * @brief 添加插入（键存在时更新）操作
+     */
+    void put(const std::string& key, const std::vector<std::string>& value,
+             const std::string& rowId);
+
+    /**
+     * @brief 添加删除操作
+     */
+    void remove(const std::string& key);
+
+    void clear() { operations.clear(); }
+    size_t size() const { return operations.size(); }
+    bool empty() const { return operations.empty(); }
+
+   private:
+    friend class BPlusTree;
+
+    struct Operation {
+        enum class Type { PUT, DELETE };
+        Type type;
+        KeyValue kv;        // DELETE时只使用key
+        std::string value;  // PUT的完整值，值日志模式下不截断
+    };
+    std::vector<Operation> operations;
+};
+
+// 统计信息
+struct TreeStats {
+    int height;
+    int nodeCount;
+    int splitCount;
+    int mergeCount;
+    double fillFactor;
+    size_t fileWriteCount;  // 文件写入计数
+    int redistributionCount;  // 满节点向兄弟移键而避免的分裂次数
+    int threeWaySplitCount;   // 2分3分裂次数
+    int avoidedUnderflowCount;  // 放宽合并阈值后避免的合并/重分布次数
+    size_t bloomFilterRejects;  // Bloom过滤器直接判定不存在的查询次数
+    size_t activeSnapshots;     // 未释放的多版本读快照数
+    size_t retainedVersions;    // 为快照保留的旧版本数
+    size_t bufferedMessages;    // 内部节点缓冲中尚未应用到叶子的键数
+    size_t messageFlushes;      // 消息缓冲向下一层下推的批次数
+    int overflowPages;          // 存放超长值的溢出页数（不计入nodeCount）
+
+    TreeStats()
+        : height(0),
+          nodeCount(0),
+          splitCount(0),
+          mergeCount(0),
+          fillFactor(0.0),
+          fileWriteCount(0),  // 初始化文件写入计数
+          redistributionCount(0),
+          threeWaySplitCount(0),
+          avoidedUnderflowCount(0),
+          bloomFilterRejects(0),
+          activeSnapshots(0),
+          retainedVersions(0),
+          bufferedMessages(0),
+          messageFlushes(0),
+          overflowPages(0) {}
+};
+
+// 元数据结构
+struct Metadata {
+    int rootPageId;
+    int nextPageId;
+    int pageCount;
+    int splitCount;
+    int mergeCount;
+    int redistributionCount;
+    int threeWaySplitCount;
+    int avoidedUnderflowCount;
+    int valueLog;  // 非0表示叶子值分离到值日志（文件创建时确定）
+    int overflowPages;      // 非0表示超长值溢出到链式溢出页（启用后一直有效）
+    int overflowPageCount;  // 正在使用的溢出页数
+    int freeOverflowPage;   // 已释放的溢出页链表的首页，0表示空
+    int magic;              // 文件标识，不匹配说明不是本格式的树文件
+    int formatVersion;      // 写入文件的页面布局版本
+    char padding[METADATA_SIZE - 14 * sizeof(int)];
+
+    Metadata()
+        : rootPageId(-1),
+          nextPageId(1),
+          pageCount(0),
+          splitCount(0),
+          mergeCount(0),
+          redistributionCount(0),
+          threeWaySplitCount(0),
+          avoidedUnderflowCount(0),
+          valueLog(0),
+          overflowPages(0),
+          overflowPageCount(0),
+          freeOverflowPage(0),
+          magic(METADATA_MAGIC),
+          formatVersion(FORMAT_VERSION) {
+        memset(padding, 0, sizeof(padding));
+    }
+};
+
+// B+树主类
+class BPlusTree {
+   private:
+    std::string filename;
+    std::shared_ptr<StorageManager> storage;  // 页面存储层（pread/pwrite），快照共享
+    bool directIO;                            // 是否请求O_DIRECT
+    bool copyOnWrite;                         // 是否使用写时复制（影子分页）存储
+    std::unique_ptr<IOEngine> ioEngine;       // 批量/异步页面I/O引擎
+    bool asyncIO;                             // 是否优先使用io_uring
+    Metadata metadata;
+    std::unique_ptr<BufferPool> bufferPool;  // 使用BufferPool替代简单的map缓存
+    size_t fileWriteCount;                   // 文件写入计数, 用于调试和性能分析
+
+    // 已提交、尚未完成的预取读请求
+    struct PendingRead {
+        PageIORequest request;
+        std::shared_ptr<BPlusTreeNode> node;  // 数据直接读入该节点的页面帧
+    };
+    std::unordered_map<int, PendingRead> pendingReads;
+
+    // 页面管理
+    std::shared_ptr<BPlusTreeNode> loadPage(int pageId);
+    bool savePage(std::shared_ptr<BPlusTreeNode> node);
+    std::vector<bool> savePages(
+        const std::vector<std::shared_ptr<BPlusTreeNode>>& nodes);
+    void completePrefetches(bool wait);
+    std::shared_ptr<BPlusTreeNode> waitPrefetch(int pageId);
+    void attachBufferPoolCallbacks();
+    std::shared_ptr<BPlusTreeNode> createNewPage(bool isLeaf = true);
+    void saveMetadata();
+    bool loadMetadata();
+
+    // 分裂策略和顺序追加快速路径
+    SplitPolicy splitPolicy;
+    int rightmostLeafId;  // 缓存的最右叶子，-1表示未知
+
+    bool siblingRedistribution;  // 分裂前是否先向兄弟节点移键（B*树）
+    int mergeThreshold;          // 键数低于该值时合并或重分布，0表示从不合并
+    bool prefixCompression;      // 新建的叶子是否使用前缀压缩
+    bool suffixTruncation;       // 是否上提最短分隔键，新建的内部节点使用压缩布局
+
+    int chooseSplitPoint(const BPlusTreeNode& node) const;
+    bool shiftToSibling(std::shared_ptr<BPlusTreeNode> node);
+    bool splitTwoIntoThree(std::shared_ptr<BPlusTreeNode> node);
+    std::shared_ptr<BPlusTreeNode> findAppendLeaf(const std::string& key);
+    KeyValue leafSeparator(const BPlusTreeNode& left,
+                           const BPlusTreeNode& right) const;
+    void replaceSeparator(std::shared_ptr<BPlusTreeNode> parent, int index,
+                          const KeyValue& separator);
+
+    // 点查询的Bloom过滤器
+    bool bloomEnabled;         // 是否维护Bloom过滤器
+    size_t bloomExpectedKeys;  // 过滤器的初始容量
+    BloomFilter bloomFilter;
+    size_t bloomRejectCount;   // 过滤器直接判定不存在的查询次数
+
+    std::string bloomFilterPath() const { return filename + ".bloom"; }
+    void bloomAdd(const std::string& key);
+    bool bloomRejects(const std::string& key);
+
+    // 热点键的点查询结果缓存，与缓冲池分别计容量
+    RecordCache recordCache;
+
+    // 多版本读：有快照时写操作先保存旧版本，按低水位（最早的快照）回收
+    uint64_t mvccClock;  // 最近一次写操作的时间戳
+    std::vector<std::weak_ptr<const uint64_t>> liveSnapshots;
+    std::map<std::string, std::vector<RecordVersion>> versionChains;  // 按键有序
+    size_t retainedVersionCount;  // 版本链中的旧版本总数
+    size_t versionsSinceCollect;  // 上次回收后新保存的旧版本数
+
+    friend class MVCCSnapshot;
+    bool snapshotsActive(uint64_t* newest = nullptr);
+    void preserveVersion(const std::string& key, uint64_t timestamp);
+    void collectVersions();
+    const RecordVersion* visibleVersion(const std::string& key,
+                                        uint64_t timestamp) const;
+    std::vector<std::vector<std::string>> snapshotGet(uint64_t timestamp,
+                                                      const std::string& key);
+    std::vector<KeyValue> snapshotScan(uint64_t timestamp,
+                                       const std::string& startKey,
+                                       const std::string& endKey, int limit);
+
+    // 写优化（Bε树）模式：写操作作为消息进入根节点的缓冲，
+    // 缓冲超出容量时把消息最多的子节点对应的一批下推一层，到达叶子时按叶子分组应用；
+    // 同一键在上层缓冲中的消息总是比下层的新
+    size_t messageBufferSize;  // 每个内部节点最多缓冲的键数，0表示禁用
+    std::unordered_map<int, MessageBuffer> messageBuffers;  // 按内部节点页面ID
+    size_t messageFlushCount;  // 向下一层下推的批次数
+    bool messageApplyFailed;   // 有消息因值写入失败未能应用，下一次commit失败
+
+    bool messageBufferingActive();
+    void bufferMessage(const std::string& key, BufferedMessage message);
+    void bufferRemoval(const std::string& key);
+    void flushMessages(int pageId);
+    void flushAllMessages();
+    void applyMessagesToLeaves(const MessageBuffer& batch);
+    void rebalanceMessages(std::shared_ptr<BPlusTreeNode> left,
+                           std::shared_ptr<BPlusTreeNode> right,
+                           const std::string& separator);
+    void moveAllMessages(int fromId, std::shared_ptr<BPlusTreeNode> to);
+
+    // 键值分离（WiscKey式）：叶子值槽只保存值日志指针或短值，
+    // 值追加到"<文件名>.vlog.<代号>"，回收时把仍被引用的值搬到下一代文件
+    bool valueLogRequested;  // 新建的文件是否使用值日志
+    double valueLogGcRatio;  // 已知垃圾占比达到该值时自动回收，0表示只手动回收
+    ValueLog valueLog;
+
+    bool storeValue(const std::string& value, std::string& stored);
+    KeyValue storedRecord(const std::string& key, const std::string& rowId,
+                          const std::string& stored) const;
+    std::string loadValue(const std::string& stored);
+    KeyValue loadRecord(const KeyValue& record);
+    void releaseValue(const std::string& stored);
+    void maybeCollectValueLog();
+
+    // 溢出页：超长值在叶子中只保留前缀和溢出页指针，其余部分写入经
+    // createNewPage分配、由nextLeafId串联的溢出页；释放的溢出页进入空闲链表复用
+    bool overflowRequested;              // 是否对之后打开的文件启用溢出页
+    std::vector<int> deferredOverflow;   // 多版本读快照存在期间延迟释放的溢出链
+
+    bool storeOverflowValue(const std::string& value, std::string& stored);
+    std::string loadOverflowValue(const std::string& stored);
+    void releaseOverflowChain(int firstPageId);
+    std::shared_ptr<BPlusTreeNode> allocateOverflowPage();
+
+    // 常驻内存的上层内部节点，放在缓冲池的常驻区中不参与LRU淘汰
+    int residentLevels;  // 自根起常驻的层数，-1表示全部内部节点，0表示不常驻
+    int residentRootId;  // 常驻的层按该根计算，根变化后重新确定
+
+    void pinUpperLevels();
+
+    // 顺序扫描预读配置
+    int readAheadMin;  // 触发预读时的初始窗口
+    int readAheadMax;  // 窗口上限，0表示禁用预读
+
+    // B+树操作辅助函数
+    std::shared_ptr<BPlusTreeNode> findLeafNode(const std::string& key,
+                                                TreePath* path = nullptr);
+    void insertInternal(std::shared_ptr<BPlusTreeNode> node, const KeyValue& kv,
+                        int rightChildId = -1);
+    void handleOverflow(std::shared_ptr<BPlusTreeNode> node, bool force = false);
+    void handleUnderflow(std::shared_ptr<BPlusTreeNode> node);
+    void checkUnderflow(std::shared_ptr<BPlusTreeNode> leaf);
+
+    // 批量查询辅助函数
+    void multiGetRecursive(
+        std::shared_ptr<BPlusTreeNode> node, const std::vector<std::string>& keys,
+        const std::vector<size_t>& order, size_t begin, size_t end,
+        std::vector<std::vector<std::vector<std::string>>>& results);
+
+    // 已注册的合并操作符
+    std::unordered_map<std::string, MergeOperator> mergeOperators;
+
+    void registerBuiltinMergeOperators();
+
+    /**
+     * @brief 在已定位的叶子中插入新键，满时分裂
+     */
+    void insertIntoLeaf(std::shared_ptr<BPlusTreeNode> leaf, const KeyValue& kv);
+
+    // 批量写辅助函数
+    bool applyLeafBatch(std::shared_ptr<BPlusTreeNode> leaf,
+                        std::vector<KeyValue>& entries, bool removed);
+    void noteBatchWrite(const std::vector<const WriteBatch::Operation*>& ops);
+
+    // 游标辅助函数
+    friend class BPlusTreeCursor;
+    void advanceCursorLeaf(BPlusTreeCursor& cursor);
+    void readAhead(BPlusTreeCursor& cursor);
+    bool advancePath(TreePath& path);
+
+    // 统计辅助函数
+    int calculateHeight(std::shared_ptr<BPlusTreeNode> node);
+    double calculateFillFactor();
+    void mergeNodes(std::shared_ptr<BPlusTreeNode> leftNode,
+                    std::shared_ptr<BPlusTreeNode> rightNode,
+                    std::shared_ptr<BPlusTreeNode> parent, int parentKeyIndex);
+
+    void redistributeFromLeft(std::shared_ptr<BPlusTreeNode> node,
+                              std::shared_ptr<BPlusTreeNode> leftSibling,
+                              std::shared_ptr<BPlusTreeNode> parent,
+                              int parentKeyIndex);
+    void redistributeFromRight(std::shared_ptr<BPlusTreeNode> node,
+                               std::shared_ptr<BPlusTreeNode> rightSibling,
+                               std::shared_ptr<BPlusTreeNode> parent,
+                               int parentKeyIndex);
+
+   public:
+    BPlusTree();
+    ~BPlusTree();
+
+    // 主要接口
+    bool create(const std::string& filename, int pageSize = PAGE_SIZE,
+                size_t bufferPoolSize = 100);
+    void close();
+    bool insert(const std::string& key, const std::vector<std::string>& value,
+                const std::string& rowId);
+    std::vector<std::vector<std::string>> get(const std::string& key);
+
+    /**
+     * @brief 批量查询
+     * @param keys 要查询的键列表（可无序、可重复）
+     * @return 与keys一一对应的结果，每项与get(key)的返回值相同
+     *
+     * 对键排序后自根向下一次遍历，共享公共路径上的内部节点，
+     * 同一叶子中的键只访问该叶子一次，并批量预取下一层需要的页面
+     */
+    std::vector<std::vector<std::vector<std::string>>> multiGet(
+        const std::vector<std::string>& keys);
+    bool remove(const std::string& key);
+
+    /**
+     * @brief 删除键，不检查键是否存在
+     * @param key 要删除的键
+     *
+     * 写优化模式下只向根节点的缓冲写入一条删除消息，不读取叶子；
+     * 其他模式下与remove相同。需要知道键是否存在时使用remove
+     */
+    void removeBlind(const std::string& key);
+
+    /**
+     * @brief 读-改-写：只查找一次叶子，在原位置更新值
+     * @param key 键
+     * @param mergeFn 由现有值（不存在时为nullptr）计算新值
+     * @param rowId 行ID，为空时保留现有行ID
+     * @return true如果成功
+     */
+    bool upsert(const std::string& key, const MergeFunction& mergeFn,
+                const std::string& rowId = "");
+
+    /**
+     * @brief 注册合并操作符，同名操作符会被替换
+     * @param name 操作符名称
+     * @param op 合并操作符
+     *
+     * 内置操作符："add"（整数累加）、"append"（字符串追加）、"max"（整数最大值）
+     */
+    void registerMergeOperator(const std::string& name, const MergeOperator& op);
+
+    /**
+     * @brief 使用已注册的合并操作符执行读-改-写
+     * @param key 键
+     * @param opName 操作符名称
+     * @param operand 操作数
+     * @param rowId 行ID，为空时保留现有行ID
+     * @return true如果成功；操作符未注册时返回false
+     */
+    bool merge(const std::string& key, const std::string& opName,
+               const std::string& operand, const std::string& rowId = "");
+
+    /**
+     * @brief 应用批量写操作
+     * @param batch 批量写操作
+     * @return true如果全部应用成功；失败时不做任何修改并返回false
+     *
+     * 操作按键排序后按目标叶子分组：每组只查找一次叶子、标记一次脏页，
+     * 超出容量时一次性多路分裂。整批分两个阶段：先写入所有的值（值日志或溢出页）、
+     * 预留页面ID并归并出每个叶子的新内容，任一步失败时释放已写入的值并返回；
+     * 之后才更新快照版本、记录缓存和过滤器并写入叶子，删除造成的下溢在最后处理。
+     * 整批涉及的叶子在应用前都留在内存中
+     */
+    bool write(const WriteBatch& batch);
+    TreeStats getStat();
+
+    /**
+     * @brief 定位到第一个不小于key的记录
+     * @param key 起始键
+     * @return 游标，树为空或没有更大的键时无效
+     */
+    BPlusTreeCursor seek(const std::string& key);
+
+    /**
+     * @brief 范围查询
+     * @param startKey 起始键（包含）
+     * @param endKey 结束键（包含）
+     * @param limit 最多返回的记录数，-1表示不限制
+     * @return 按键有序的记录列表
+     *
+     * KeyValue的值最多VALUE_SIZE-1字节：使用值日志或溢出页时更长的值在结果中被截断，
+     * 完整的值需经get或游标的value()读取
+     */
+    std::vector<KeyValue> scan(const std::string& startKey,
+                               const std::string& endKey, int limit = -1);
+
+    /**
+     * @brief 设置顺序扫描的自适应预读窗口
+     * @param minPages 检测到顺序访问时的初始预读页数
+     * @param maxPages 持续顺序访问时窗口增长的上限，0表示禁用预读
+     */
+    void setReadAhead(int minPages, int maxPages);
+
+    /**
+     * @brief 设置节点分裂策略
+     * @param policy 分裂策略，键单调递增的顺序写入使用ADAPTIVE可使页面接近全满
+     */
+    void setSplitPolicy(SplitPolicy policy);
+
+    /**
+     * @brief 设置分裂前是否先向兄弟节点重分布（B*树）
+     * @param enabled true时满节点先把键移入同一父节点下未满的左/右兄弟，
+     *                两侧兄弟都满时叶子节点做2分3分裂，填充率可提高到2/3以上
+     */
+    void setSiblingRedistribution(bool enabled);
+
+    /**
+     * @brief 设置合并阈值
+     * @param minKeys 节点键数低于该值时才合并或重分布，取值0到MAX_KEYS_PER_PAGE/2
+     *                （默认）。较小的值避免在边界附近反复删除、插入时的合并/分裂抖动；
+     *                1表示只处理空叶子，0表示延迟删除，空叶子保留在树中
+     */
+    void setMergeThreshold(int minKeys);
+
+    /**
+     * @brief 设置叶子页面是否使用前缀压缩
+     * @param enabled true时新建的叶子只保存一次页面内键的公共前缀，
+     *                键槽按最长后缀收窄，每个叶子可容纳更多记录；
+     *                已有的叶子保持原布局，只影响之后创建的叶子
+     */
+    void setPrefixCompression(bool enabled);
+
+    /**
+     * @brief 设置是否截断分隔键
+     * @param enabled true时叶子分裂只把区分左右两半的最短前缀上提到父节点，
+     *                新建的内部节点按最长分隔键收窄键槽，长字符串键时扇出更大、树更矮
+     */
+    void setSuffixTruncation(bool enabled);
+
+    /**
+     * @brief 设置是否维护Bloom过滤器
+     * @param enabled true时get、multiGet和remove先查询过滤器，
+     *                判定不存在的键不访问任何页面
+     * @param expectedKeys 过滤器的初始容量，键数超过容量时自动按两倍键数重建
+     * 需在create之前调用。过滤器在close时保存到"<文件名>.bloom"，
+     * 打开时加载；文件缺失（如异常退出）时按现有键重建
+     */
+    void setBloomFilter(bool enabled, size_t expectedKeys = 100000);
+
+    /**
+     * @brief 按树中现有的键重建Bloom过滤器，清除已删除键留下的位
+     */
+    void rebuildBloomFilter();
+
+    /**
+     * @brief 设置是否使用O_DIRECT绕过内核页缓存
+     * @param enabled true启用直接I/O，BufferPool成为唯一的缓存层
+     * 需在create之前调用
+     */
+    void setDirectIO(bool enabled);
+
+    /**
+     * @brief 设置是否使用写时复制（影子分页）存储
+     * @param enabled true时修改过的页面写到新的物理位置，commit时原子地发布
+     *                新版本，崩溃后打开文件得到最近一次提交的树，无需预写日志
+     * 需在create之前调用；文件格式与原地更新不同，两种模式不能打开对方的文件。
+     * 写时复制模式使用同步I/O引擎
+     */
+    void setCopyOnWrite(bool enabled);
+
+    /**
+     * @brief 提交：写回所有脏页和元数据并持久化
+     * @return true如果成功
+     * 写时复制模式下原子地发布新版本，之后的snapshot看到本次提交的内容
+     */
+    bool commit();
+
+    /**
+     * @brief 固定最近一次提交的版本
+     * @return 只读快照，未启用写时复制时无效
+     */
+    BPlusTreeSnapshot snapshot();
+
+    /**
+     * @brief 开始多版本读快照
+     * @return 快照句柄，看到此前完成的所有写操作
+     *
+     * 与snapshot()不同，不要求写时复制模式，也不需要提交；
+     * 快照存在期间写操作额外查找一次并保存被替换的记录
+     */
+    MVCCSnapshot beginSnapshot();
+
+    /**
+     * @brief 设置写优化（Bε树）模式
+     * @param messagesPerNode 每个内部节点最多缓冲的键数，0（默认）表示禁用
+     *
+     * 启用后insert、remove、upsert、merge和write不再下降到叶子，而是作为消息
+     * 写入根节点的缓冲；缓冲超出容量时把发往同一子节点的一批消息下推一层，
+     * 到达叶子时每个叶子只读写一次。get沿路径合并各层缓冲中的消息，
+     * scan、seek、commit、close和flushBuffer先把所有消息应用到叶子。
+     * 消息只保存在内存中，与缓冲池中的脏页一样在close或commit时写回；
+     * 多版本读快照存在期间写操作直接应用到叶子。设为0时立即应用所有消息。
+     * remove要返回键是否存在，仍先做一次完整的查询（自根到叶子）；
+     * 不需要该结果时使用removeBlind
+     */
+    void setMessageBuffering(size_t messagesPerNode);
+
+    /**
+     * @brief 设置是否把值分离到追加写的值日志（WiscKey式键值分离）
+     * @param enabled true时新建的文件中叶子只保存值的指针（代号、偏移、长度），
+     *                值追加到"<文件名>.vlog.<代号>"，长度不再受VALUE_SIZE限制；
+     *                短于VALUE_POINTER_SIZE的值直接保存在叶子中。叶子值槽收窄后
+     *                每个叶子可容纳的记录数增加
+     * @param gcGarbageRatio 覆盖和删除留下的垃圾占日志的比例达到该值（且不少于1MB）时，
+     *                       下一次写操作前自动回收；0表示只由collectValueLog回收
+     * 需在create之前调用，只对新建的文件生效；打开已有文件时以文件创建时的设置为准。
+     * get、multiGet和游标的value()返回完整的值；scan和游标的current()
+     * 返回KeyValue，其中的值仍截断到VALUE_SIZE-1字节
+     */
+    void setValueLog(bool enabled, double gcGarbageRatio = 0.5);
+
+    /**
+     * @brief 回收值日志中的垃圾
+     * @return 释放的字节数；未启用值日志或存在多版本读快照时返回0
+     *
+     * 把叶子引用的值按键顺序复制到新一代日志文件并改写指针，提交（commit）后
+     * 删除旧文件。写时复制快照固定了旧文件，回收后仍能读取
+     */
+    uint64_t collectValueLog();
+
+    /**
+     * @brief 设置超长值是否溢出到溢出页
+     * @param enabled true时超过VALUE_SIZE-1字节（或含'\0'）的值在叶子中只保留
+     *                前110字节和溢出页指针，其余部分写入链式溢出页，不再截断；
+     *                短值的叶子布局不变，扫描小记录时叶子密度与原来相同。
+     *                被覆盖或删除的值占用的溢出页进入空闲链表，分配时优先复用
+     * 需在create之前调用。启用后记录在文件的元数据中，之后打开时自动生效；
+     * 同时启用值日志时以值日志为准。与值日志相同，只有get、multiGet和游标的
+     * value()返回完整的值，scan和游标的current()中的值截断到VALUE_SIZE-1字节
+     */
+    void setOverflowPages(bool enabled);
+
+    /**
+     * @brief 当前打开的文件是否完整保存超过VALUE_SIZE-1字节的值
+     * @return true如果使用值日志或溢出页（叶子值槽中可能是指针）；否则写入时截断
+     */
+    bool storesFullValues() const {
+        return valueLog.isOpen() || metadata.overflowPages;
+    }
+
+    /**
+     * @brief 设置是否使用io_uring异步I/O引擎
+     * @param enabled true优先使用io_uring（不可用时回退到同步pread/pwrite）
+     * 需在create之前调用
+     */
+    void setAsyncIO(bool enabled);
+
+    /**
+     * @brief 获取当前I/O引擎名称（"io_uring"或"sync"）
+     */
+    const char* getIOEngineName() const;
+
+    /**
+     * @brief 异步预取页面到缓冲池
+     * @param pageIds 页面ID列表，已缓存或正在预取的页面会被跳过
+     * @return 实际提交的读请求数
+     *
+     * 所有读请求在一次提交中发出，完成后由后续的页面访问收割
+     */
+    int prefetchPages(const std::vector<int>& pageIds);
+
+    // BufferPool相关接口
+    /**
+     * @brief 设置缓冲池大小
+     * @param size 缓冲池大小（页面数）
+     */
+    void setBufferPoolSize(size_t size);
+
+    /**
+     * @brief 获取缓冲池统计信息
+     * @return BufferPool统计信息
+     */
+    BufferPool::Stats getBufferPoolStats() const;
+
+    /**
+     * @brief 设置常驻内存的内部节点层数
+     * @param levels 自根起常驻的层数，-1表示全部内部节点，0（默认）表示不常驻
+     *
+     * 常驻页面移出缓冲池的LRU链表、不计入缓冲池容量，其数量和占用的内存
+     * 见getBufferPoolStats()。所有内部节点常驻时，点查询最多读一次磁盘（叶子）
+     */
+    void setResidentLevels(int levels);
+
+    /**
+     * @brief 设置点查询结果缓存的容量
+     * @param capacity 最多缓存的键数，0（默认）表示禁用
+     *
+     * 缓存get的结果，命中时不访问任何页面；insert、upsert、merge、remove
+     * 和write按键使其失效。容量与缓冲池的页面数相互独立，可随时调整
+     */
+    void setRecordCacheSize(size_t capacity);
+
+    /**
+     * @brief 获取点查询结果缓存的统计信息
+     * @return RecordCache统计信息
+     */
+    RecordCache::Stats getRecordCacheStats() const;
+
+    /**
+     * @brief 获取值日志的统计信息
+     */
+    ValueLog::Stats getValueLogStats() const;
+
+    /**
+     * @brief 刷新所有脏页到磁盘
+     * @return 刷新的页面数量
+     */
+    int flushBuffer();
+
+    /**
+     * @brief 打印缓冲池状态
+     */
+    void printBufferPoolStatus() const;
+
+    // 调试和测试
+    void printTree();
+    void printNode(std::shared_ptr<BPlusTreeNode> node, int level = 0);
 };
\ No newline at end of file
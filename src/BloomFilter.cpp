@@ -0,0 +1,104 @@
+#include "BloomFilter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// 文件头：魔数、容量、插入数、删除数、位数组长度（64位字）
+static const char BLOOM_MAGIC[4] = {'B', 'L', 'M', '1'};
+
+BloomFilter::BloomFilter() : capacity_(0), insertedCount_(0), removedCount_(0) {
+    reset(0);
+}
+
+void BloomFilter::reset(size_t expectedKeys) {
+    capacity_ = std::max(expectedKeys, (size_t)1024);
+    bits_.assign((capacity_ * BITS_PER_KEY + 63) / 64, 0);
+    insertedCount_ = 0;
+    removedCount_ = 0;
+}
+
+/**
+ * @brief FNV-1a后接splitmix64终结函数，结果在不同平台上一致
+ */
+uint64_t BloomFilter::hash(const std::string& key) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char byte : key) {
+        h ^= byte;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/**
+ * @brief 添加键：由一个64位哈希的高低两半双重哈希出HASH_COUNT个位置
+ */
+void BloomFilter::add(const std::string& key) {
+    uint64_t h = hash(key);
+    uint64_t delta = (h >> 32) | 1;
+    uint64_t bitCount = bits_.size() * 64;
+    for (int i = 0; i < HASH_COUNT; i++) {
+        uint64_t bit = h % bitCount;
+        bits_[bit / 64] |= uint64_t(1) << (bit % 64);
+        h += delta;
+    }
+    insertedCount_++;
+}
+
+bool BloomFilter::mayContain(const std::string& key) const {
+    uint64_t h = hash(key);
+    uint64_t delta = (h >> 32) | 1;
+    uint64_t bitCount = bits_.size() * 64;
+    for (int i = 0; i < HASH_COUNT; i++) {
+        uint64_t bit = h % bitCount;
+        if ((bits_[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) return false;
+        h += delta;
+    }
+    return true;
+}
+
+bool BloomFilter::needsRebuild() const {
+    return insertedCount_ > capacity_ ||
+           (removedCount_ > 1024 && removedCount_ * 2 > insertedCount_);
+}
+
+bool BloomFilter::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+
+    uint64_t fields[4] = {capacity_, insertedCount_, removedCount_, bits_.size()};
+    file.write(BLOOM_MAGIC, sizeof(BLOOM_MAGIC));
+    file.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    file.write(reinterpret_cast<const char*>(bits_.data()),
+               bits_.size() * sizeof(uint64_t));
+    return file.good();
+}
+
+bool BloomFilter::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    char magic[4];
+    uint64_t fields[4];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(fields), sizeof(fields));
+    if (!file || memcmp(magic, BLOOM_MAGIC, sizeof(magic)) != 0 ||
+        fields[3] == 0 || fields[3] > (uint64_t(1) << 32)) {
+        return false;
+    }
+
+    std::vector<uint64_t> bits(fields[3]);
+    file.read(reinterpret_cast<char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    if (!file) return false;
+
+    capacity_ = fields[0];
+    insertedCount_ = fields[1];
+    removedCount_ = fields[2];
+    bits_.swap(bits);
+    return true;
+}
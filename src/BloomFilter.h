@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 键的Bloom过滤器
+ *
+ * 查询返回false时键一定不存在，返回true时键可能存在（误判率约1%，
+ * 每键10位、7个哈希函数）。删除无法清除位，只记录次数，
+ * 失效的位过多或插入数超过容量时由调用方按现有键重建。
+ * 哈希与平台和编译器无关，可以保存到文件后重新加载
+ */
+class BloomFilter {
+   public:
+    BloomFilter();
+
+    /**
+     * @brief 清空并按预期键数重新分配位数组
+     * @param expectedKeys 预期键数
+     */
+    void reset(size_t expectedKeys);
+
+    void add(const std::string& key);
+    bool mayContain(const std::string& key) const;
+
+    /**
+     * @brief 记录一次删除，删除的键仍会被判为可能存在
+     */
+    void noteRemoval() { removedCount_++; }
+
+    /**
+     * @brief 插入数超过容量或超过一半的插入已被删除时需要重建
+     */
+    bool needsRebuild() const;
+
+    size_t getCapacity() const { return capacity_; }
+    size_t getInsertedCount() const { return insertedCount_; }
+    size_t getRemovedCount() const { return removedCount_; }
+    size_t getBitCount() const { return bits_.size() * 64; }
+
+    /**
+     * @brief 保存到文件
+     * @return true如果成功
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief 从文件加载
+     * @return false如果文件不存在或格式不符，此时过滤器不变
+     */
+    bool load(const std::string& path);
+
+   private:
+    static const int BITS_PER_KEY = 10;
+    static const int HASH_COUNT = 7;
+
+    std::vector<uint64_t> bits_;
+    size_t capacity_;       // 按该键数分配的位数组
+    size_t insertedCount_;  // 自上次重建以来的插入次数（含更新）
+    size_t removedCount_;   // 自上次重建以来的删除次数
+
+    static uint64_t hash(const std::string& key);
+};
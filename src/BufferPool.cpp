@@ -8,8 +8,8 @@
  * @param maxSize 缓冲池最大页面数
  * @param saveCallback 页面保存回调函数
  */
-BufferPool::BufferPool(size_t maxSize, std::function<void(std::shared_ptr<BPlusTreeNode>)> saveCallback)
-    : maxSize_(maxSize), saveCallback_(saveCallback), hitCount_(0), missCount_(0) {
+BufferPool::BufferPool(size_t maxSize, std::function<bool(std::shared_ptr<BPlusTreeNode>)> saveCallback)
+    : maxSize_(maxSize), residentCount_(0), saveCallback_(saveCallback), hitCount_(0), missCount_(0) {
     if (maxSize_ == 0) {
         maxSize_ = 100;  // 默认最小值
     }
@@ -35,9 +35,11 @@ std::shared_ptr<BPlusTreeNode> BufferPool::getPage(int pageId,
     auto it = pages_.find(pageId);
     
     if (it != pages_.end()) {
-        // 缓存命中
+        // 缓存命中，常驻页面不需要调整LRU位置
         hitCount_++;
-        updateLRU(pageId);
+        if (!it->second.resident) {
+            updateLRU(pageId);
+        }
         return it->second.node;
     }
     
@@ -70,21 +72,23 @@ void BufferPool::putPage(int pageId, std::shared_ptr<BPlusTreeNode> node) {
     if (it != pages_.end()) {
         // 页面已存在，更新并移到最前面
         it->second.node = node;
-        updateLRU(pageId);
+        if (!it->second.resident) {
+            updateLRU(pageId);
+        }
         return;
     }
     
-    // 检查是否需要淘汰页面
-    while (pages_.size() >= maxSize_) {
+    // 检查是否需要淘汰页面，常驻页面不计入容量
+    while (pages_.size() - residentCount_ >= maxSize_) {
         int evictedPageId = evictLRU();
         if (evictedPageId == -1) {
             // 无法淘汰任何页面（所有页面都被固定或都是脏页）
             // 强制淘汰一个脏页
             evictedPageId = forceEvictDirtyPage();
             if (evictedPageId == -1) {
-                // 仍然无法淘汰，可能所有页面都被固定
-                std::cerr << "Warning: BufferPool is full and cannot evict any page" << std::endl;
-                return;
+                // 所有页面都被固定或正在使用，暂时超出容量，
+                // 后续放入页面时再淘汰回容量以内
+                break;
             }
         }
     }
@@ -109,7 +113,9 @@ void BufferPool::markDirty(int pageId) {
         if (it->second.node) {
             it->second.node->dirty = true;
         }
-        updateLRU(pageId);
+        if (!it->second.resident) {
+            updateLRU(pageId);
+        }
     }
 }
 
@@ -121,7 +127,9 @@ void BufferPool::pinPage(int pageId) {
     auto it = pages_.find(pageId);
     if (it != pages_.end()) {
         it->second.pinned = true;
-        updateLRU(pageId);
+        if (!it->second.resident) {
+            updateLRU(pageId);
+        }
     }
 }
 
@@ -136,6 +144,68 @@ void BufferPool::unpinPage(int pageId) {
     }
 }
 
+/**
+ * @brief 把页面移入常驻区
+ * @param pageId 页面ID
+ * @return true如果页面在缓冲池中
+ */
+bool BufferPool::makeResident(int pageId) {
+    auto it = pages_.find(pageId);
+    if (it == pages_.end()) {
+        return false;
+    }
+    if (it->second.resident) {
+        return true;
+    }
+
+    // 移出LRU链表，淘汰时不会再扫描到该页面
+    auto lruIt = lruMap_.find(pageId);
+    if (lruIt != lruMap_.end()) {
+        lruList_.erase(lruIt->second);
+        lruMap_.erase(lruIt);
+    }
+    it->second.resident = true;
+    residentCount_++;
+    return true;
+}
+
+/**
+ * @brief 把常驻页面放回LRU链表
+ * @param pageId 页面ID
+ */
+void BufferPool::releaseResident(int pageId) {
+    auto it = pages_.find(pageId);
+    if (it == pages_.end() || !it->second.resident) {
+        return;
+    }
+    it->second.resident = false;
+    residentCount_--;
+    updateLRU(pageId);
+}
+
+/**
+ * @brief 释放所有常驻页面
+ */
+void BufferPool::releaseAllResident() {
+    if (residentCount_ == 0) return;
+    for (auto& pair : pages_) {
+        if (pair.second.resident) {
+            pair.second.resident = false;
+            updateLRU(pair.first);
+        }
+    }
+    residentCount_ = 0;
+}
+
+/**
+ * @brief 页面是否在常驻区
+ * @param pageId 页面ID
+ */
+bool BufferPool::isResident(int pageId) const {
+    auto it = pages_.find(pageId);
+    return it != pages_.end() && it->second.resident;
+}
+
 /**
  * @brief 刷新指定页面到磁盘
  * @param pageId 页面ID
@@ -149,7 +219,9 @@ bool BufferPool::flushPage(int pageId) {
     
     BufferPoolItem& item = it->second;
     if (item.dirty && item.node && saveCallback_) {
-        saveCallback_(item.node);
+        if (!saveCallback_(item.node)) {
+            return false;  // 写入失败，保留脏页标记以便重试
+        }
         item.dirty = false;
         item.node->dirty = false;
         return true;
@@ -160,21 +232,56 @@ bool BufferPool::flushPage(int pageId) {
 
 /**
  * @brief 刷新所有脏页到磁盘
- * @return 刷新的页面数量
+ * @param failedCount 可选输出参数，写入失败的页面数
+ * @return 成功刷新的页面数量
+ *
+ * 写入失败的页面保留脏页标记，之后的刷新或淘汰时重试
  */
-int BufferPool::flushAllPages() {
+int BufferPool::flushAllPages(size_t* failedCount) {
     int flushedCount = 0;
-    
-    for (auto& pair : pages_) {
-        BufferPoolItem& item = pair.second;
-        if (item.dirty && item.node && saveCallback_) {
-            saveCallback_(item.node);
-            item.dirty = false;
-            item.node->dirty = false;
-            flushedCount++;
+    size_t failed = 0;
+
+    // 优先批量写回，一次提交所有脏页
+    if (batchSaveCallback_) {
+        std::vector<BufferPoolItem*> dirtyItems;
+        std::vector<std::shared_ptr<BPlusTreeNode>> dirtyNodes;
+        for (auto& pair : pages_) {
+            BufferPoolItem& item = pair.second;
+            if (item.dirty && item.node) {
+                dirtyItems.push_back(&item);
+                dirtyNodes.push_back(item.node);
+            }
+        }
+        if (!dirtyNodes.empty()) {
+            std::vector<bool> written = batchSaveCallback_(dirtyNodes);
+            for (size_t i = 0; i < dirtyItems.size(); i++) {
+                if (i < written.size() && written[i]) {
+                    dirtyItems[i]->dirty = false;
+                    dirtyItems[i]->node->dirty = false;
+                    flushedCount++;
+                } else {
+                    failed++;
+                }
+            }
+        }
+    } else {
+        for (auto& pair : pages_) {
+            BufferPoolItem& item = pair.second;
+            if (item.dirty && item.node && saveCallback_) {
+                if (!saveCallback_(item.node)) {
+                    failed++;
+                    continue;
+                }
+                item.dirty = false;
+                item.node->dirty = false;
+                flushedCount++;
+            }
         }
     }
-    
+
+    if (failedCount) {
+        *failedCount = failed;
+    }
     return flushedCount;
 }
 
@@ -195,16 +302,36 @@ void BufferPool::clear() {
     pages_.clear();
     lruMap_.clear();
     lruList_.clear();
+    residentCount_ = 0;
 }
 
 /**
  * @brief 设置页面保存回调函数
  * @param callback 保存回调函数
  */
-void BufferPool::setSaveCallback(std::function<void(std::shared_ptr<BPlusTreeNode>)> callback) {
+void BufferPool::setSaveCallback(std::function<bool(std::shared_ptr<BPlusTreeNode>)> callback) {
     saveCallback_ = callback;
 }
 
+/**
+ * @brief 设置批量保存回调函数
+ * @param callback 批量保存回调函数，返回每个页面是否写入成功
+ */
+void BufferPool::setBatchSaveCallback(
+    std::function<std::vector<bool>(
+        const std::vector<std::shared_ptr<BPlusTreeNode>>&)>
+        callback) {
+    batchSaveCallback_ = callback;
+}
+
+/**
+ * @brief 检查页面是否在缓冲池中
+ * @param pageId 页面ID
+ */
+bool BufferPool::containsPage(int pageId) const {
+    return pages_.find(pageId) != pages_.end();
+}
+
 /**
  * @brief 获取缓冲池统计信息
  */
@@ -231,6 +358,8 @@ BufferPool::Stats BufferPool::getStats() const {
             stats.pinnedPages++;
         }
     }
+    stats.residentPages = residentCount_;
+    stats.residentBytes = residentCount_ * PAGE_SIZE;
     
     return stats;
 }
@@ -245,6 +374,8 @@ void BufferPool::printStatus() const {
     std::cout << "总页面数: " << stats.totalPages << "/" << stats.maxSize << std::endl;
     std::cout << "脏页数量: " << stats.dirtyPages << std::endl;
     std::cout << "固定页面数: " << stats.pinnedPages << std::endl;
+    std::cout << "常驻页面数: " << stats.residentPages << " ("
+              << stats.residentBytes / 1024 << " KB)" << std::endl;
     std::cout << "命中次数: " << stats.hitCount << std::endl;
     std::cout << "未命中次数: " << stats.missCount << std::endl;
     std::cout << "命中率: " << stats.hitRatio * 100 << "%" << std::endl;
@@ -292,8 +423,8 @@ int BufferPool::evictLRU() {
         if (pageIt != pages_.end()) {
             const BufferPoolItem& item = pageIt->second;
             
-            // 跳过被固定的页面和脏页
-            if (!item.pinned && !item.dirty) {
+            // 跳过被固定的页面、脏页和正在被使用的页面
+            if (!item.pinned && !item.dirty && !isInUse(item)) {
                 // 可以安全移除这个页面
                 if (removePageInternal(pageId, false)) {
                     return pageId;
@@ -318,8 +449,8 @@ int BufferPool::forceEvictDirtyPage() {
         if (pageIt != pages_.end()) {
             const BufferPoolItem& item = pageIt->second;
             
-            // 找到非固定的脏页
-            if (!item.pinned && item.dirty) {
+            // 找到非固定且未被使用的脏页
+            if (!item.pinned && item.dirty && !isInUse(item)) {
                 // 先刷新到磁盘
                 if (flushPage(pageId)) {
                     // 然后移除
@@ -350,8 +481,8 @@ bool BufferPool::removePageInternal(int pageId, bool force) {
     
     // 检查是否可以移除
     if (!force) {
-        if (item.pinned) {
-            return false;  // 被固定的页面不能移除
+        if (item.pinned || item.resident) {
+            return false;  // 被固定或常驻的页面不能移除
         }
         
         if (item.dirty) {
@@ -370,6 +501,9 @@ bool BufferPool::removePageInternal(int pageId, bool force) {
     }
     
     // 从页面映射中移除
+    if (item.resident) {
+        residentCount_--;
+    }
     pages_.erase(it);
     
     return true;
@@ -5,6 +5,7 @@
 #include <list>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 // 前向声明
 class BPlusTreeNode;
@@ -17,10 +18,11 @@ struct BufferPoolItem {
     std::shared_ptr<BPlusTreeNode> node;  // 页面节点
     bool dirty;                           // 脏页标记
     bool pinned;                          // 是否被固定（不能被淘汰）
+    bool resident;                        // 是否在常驻区（不在LRU链表中）
     int pageId;                           // 页面ID
 
     BufferPoolItem(std::shared_ptr<BPlusTreeNode> n, int id)
-        : node(n), dirty(false), pinned(false), pageId(id) {}
+        : node(n), dirty(false), pinned(false), resident(false), pageId(id) {}
 };
 
 /**
@@ -31,6 +33,7 @@ struct BufferPoolItem {
  * - LRU淘汰策略，优先淘汰最久未使用的页面
  * - 脏页管理，确保数据一致性
  * - 页面固定机制，防止正在使用的页面被淘汰
+ * - 常驻区，移出LRU链表且不计入容量，用于常驻内存的上层内部节点
  * - 批量刷盘功能，提高I/O效率
  */
 class BufferPool {
@@ -41,7 +44,7 @@ class BufferPool {
      * @param saveCallback 页面保存回调函数
      */
     explicit BufferPool(size_t maxSize = 100,
-                        std::function<void(std::shared_ptr<BPlusTreeNode>)>
+                        std::function<bool(std::shared_ptr<BPlusTreeNode>)>
                             saveCallback = nullptr);
     /**
      * @brief 析构函数
@@ -84,18 +87,45 @@ class BufferPool {
      */
     void unpinPage(int pageId);
 
+    /**
+     * @brief 把页面移入常驻区
+     * @param pageId 页面ID
+     * @return true如果页面在缓冲池中
+     *
+     * 常驻页面不在LRU链表中、不会被淘汰，也不占用maxSize的容量
+     */
+    bool makeResident(int pageId);
+
+    /**
+     * @brief 把常驻页面放回LRU链表头部，之后按常规方式淘汰
+     * @param pageId 页面ID
+     */
+    void releaseResident(int pageId);
+
+    /**
+     * @brief 释放所有常驻页面
+     */
+    void releaseAllResident();
+
+    /**
+     * @brief 页面是否在常驻区
+     * @param pageId 页面ID
+     */
+    bool isResident(int pageId) const;
+
     /**
      * @brief 刷新指定页面到磁盘
      * @param pageId 页面ID
-     * @return true如果成功，false如果页面不存在
+     * @return true如果成功，false如果页面不存在或写入失败（页面仍为脏页）
      */
     bool flushPage(int pageId);
 
     /**
      * @brief 刷新所有脏页到磁盘
-     * @return 刷新的页面数量
+     * @param failedCount 可选输出参数，写入失败的页面数；失败的页面仍为脏页
+     * @return 成功刷新的页面数量
      */
-    int flushAllPages();
+    int flushAllPages(size_t* failedCount = nullptr);
 
     /**
      * @brief 从缓冲池中移除页面
@@ -112,10 +142,31 @@ class BufferPool {
 
     /**
      * @brief 设置页面保存回调函数
-     * @param callback 保存回调函数
+     * @param callback 保存回调函数，返回页面是否写入成功
      */
     void setSaveCallback(
-        std::function<void(std::shared_ptr<BPlusTreeNode>)> callback);
+        std::function<bool(std::shared_ptr<BPlusTreeNode>)> callback);
+
+    /**
+     * @brief 设置批量保存回调函数
+     * @param callback 批量保存回调函数，flushAllPages时一次性写回所有脏页，
+     *                 按输入顺序返回每个页面是否写入成功
+     */
+    void setBatchSaveCallback(
+        std::function<std::vector<bool>(
+            const std::vector<std::shared_ptr<BPlusTreeNode>>&)>
+            callback);
+
+    /**
+     * @brief 检查页面是否在缓冲池中（不影响LRU和命中统计）
+     * @param pageId 页面ID
+     */
+    bool containsPage(int pageId) const;
+
+    /**
+     * @brief 缓冲池容量（页面数）
+     */
+    size_t capacity() const { return maxSize_; }
 
     /**
      * @brief 获取缓冲池统计信息
@@ -124,6 +175,8 @@ class BufferPool {
         size_t totalPages;    // 当前缓存的页面数
         size_t dirtyPages;    // 脏页数量
         size_t pinnedPages;   // 被固定的页面数
+        size_t residentPages;  // 常驻区的页面数（不计入maxSize）
+        size_t residentBytes;  // 常驻区页面帧占用的内存
         size_t maxSize;       // 最大容量
         long long hitCount;   // 命中次数
         long long missCount;  // 未命中次数
@@ -133,6 +186,8 @@ class BufferPool {
             : totalPages(0),
               dirtyPages(0),
               pinnedPages(0),
+              residentPages(0),
+              residentBytes(0),
               maxSize(0),
               hitCount(0),
               missCount(0),
@@ -161,9 +216,13 @@ class BufferPool {
     LRUList lruList_;
 
     // 配置参数
-    size_t maxSize_;  // 最大页面数
-    std::function<void(std::shared_ptr<BPlusTreeNode>)>
+    size_t maxSize_;        // 最大页面数（不含常驻页面）
+    size_t residentCount_;  // 常驻区的页面数
+    std::function<bool(std::shared_ptr<BPlusTreeNode>)>
         saveCallback_;  // 保存回调
+    std::function<std::vector<bool>(
+        const std::vector<std::shared_ptr<BPlusTreeNode>>&)>
+        batchSaveCallback_;  // 批量保存回调
 
     // 统计信息
     mutable long long hitCount_;   // 命中次数
@@ -187,6 +246,15 @@ class BufferPool {
      */
     int forceEvictDirtyPage();
 
+    /**
+     * @brief 页面节点是否仍被缓冲池以外的代码持有
+     *
+     * 淘汰仍被持有的节点会让持有者的后续修改写到一个游离副本上而丢失
+     */
+    static bool isInUse(const BufferPoolItem& item) {
+        return item.node && item.node.use_count() > 1;
+    }
+
     /**
      * @brief 内部移除页面的实现
      * @param pageId 页面ID
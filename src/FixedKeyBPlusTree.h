@@ -0,0 +1,620 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "BPlusTree.h"
+#include "NodeSearch.h"
+#include "StorageManager.h"
+
+/**
+ * @brief 整数键特征
+ *
+ * FixedKeyBPlusTree的键特征需要提供：
+ * - KeyType：可平凡复制的定长键类型
+ * - less(a, b)：严格弱序比较
+ * - lowerBound/upperBound(keys, count, key)：节点内有序键数组的查找
+ */
+template <typename Key>
+struct IntegerKeyTraits {
+    static_assert(std::is_integral<Key>::value, "IntegerKeyTraits需要整数类型");
+    using KeyType = Key;
+
+    static bool less(KeyType a, KeyType b) { return a < b; }
+
+    static int lowerBound(const KeyType* keys, int count, KeyType key) {
+        return std::lower_bound(keys, keys + count, key) - keys;
+    }
+
+    static int upperBound(const KeyType* keys, int count, KeyType key) {
+        return std::upper_bound(keys, keys + count, key) - keys;
+    }
+};
+
+// int64键使用SIMD节点内搜索
+template <>
+inline int IntegerKeyTraits<int64_t>::lowerBound(const int64_t* keys,
+                                                 int count, int64_t key) {
+    return lowerBoundInt64(keys, count, key);
+}
+
+template <>
+inline int IntegerKeyTraits<int64_t>::upperBound(const int64_t* keys,
+                                                 int count, int64_t key) {
+    if (key == std::numeric_limits<int64_t>::max()) return count;
+    return lowerBoundInt64(keys, count, key + 1);
+}
+
+using Int64KeyTraits = IntegerKeyTraits<int64_t>;
+using UInt64KeyTraits = IntegerKeyTraits<uint64_t>;
+
+// 定长键页面头部
+struct FixedKeyPageHeader {
+    int pageId;
+    int isLeaf;
+    int keyCount;
+    int nextLeafId;  // 叶子节点链表
+};
+
+/**
+ * @brief 定长键B+树
+ *
+ * 键类型、比较器和键宽度都是编译期参数。键在页面中连续存放，
+ * 节点内查找直接在键数组上进行（int64键使用SIMD，见NodeSearch.h），
+ * 不经过KeyValue的64字节字符数组和临时字符串。
+ * 4KB页面下int64键的内部节点可容纳339个分隔键（BPlusTree为18个）。
+ *
+ * 页面布局：
+ * - 叶子节点：[头部][键 x LEAF_CAPACITY][值 x LEAF_CAPACITY]
+ * - 内部节点：[头部][键 x INTERNAL_CAPACITY][子节点ID x (INTERNAL_CAPACITY+1)]
+ *
+ * 键唯一，插入已有键时更新值。删除不做合并（与mergeThreshold为0时相同），
+ * 适合以插入和点查为主的id→记录表。
+ *
+ * @tparam KeyTraits 键特征，见IntegerKeyTraits
+ * @tparam ValueSize 每条记录的值占用的字节数
+ */
+template <typename KeyTraits, size_t ValueSize = VALUE_SIZE>
+class FixedKeyBPlusTree {
+   public:
+    using KeyType = typename KeyTraits::KeyType;
+
+    static_assert(std::is_trivially_copyable<KeyType>::value,
+                  "键类型必须可平凡复制");
+    static_assert(sizeof(KeyType) % sizeof(int) == 0,
+                  "键宽度需为4字节的倍数，保证子节点ID数组对齐");
+
+    static constexpr int LEAF_CAPACITY =
+        (PAGE_SIZE - sizeof(FixedKeyPageHeader)) / (sizeof(KeyType) + ValueSize);
+    static constexpr int INTERNAL_CAPACITY =
+        (PAGE_SIZE - sizeof(FixedKeyPageHeader) - sizeof(int)) /
+        (sizeof(KeyType) + sizeof(int));
+
+    static_assert(LEAF_CAPACITY >= 2, "ValueSize过大，页面放不下两条记录");
+
+    FixedKeyBPlusTree()
+        : rootPageId(-1),
+          nextPageId(0),
+          entryCount(0),
+          cacheCapacity(100),
+          accessClock(0) {}
+
+    ~FixedKeyBPlusTree() { close(); }
+
+    FixedKeyBPlusTree(const FixedKeyBPlusTree&) = delete;
+    FixedKeyBPlusTree& operator=(const FixedKeyBPlusTree&) = delete;
+
+    /**
+     * @brief 创建或打开数据文件
+     * @param filename 文件名
+     * @param cacheSize 缓存的最大页面数
+     * @return true如果成功；已有文件的键宽度或值大小不匹配时返回false
+     */
+    bool create(const std::string& filename, size_t cacheSize = 100) {
+        close();
+        cacheCapacity = std::max<size_t>(cacheSize, 4);
+
+        storage.reset(new PosixStorageManager(PAGE_SIZE, METADATA_SIZE));
+        bool created = false;
+        if (!storage->open(filename, created)) {
+            storage.reset();
+            return false;
+        }
+
+        if (created) {
+            rootPageId = -1;
+            nextPageId = 0;
+            entryCount = 0;
+            return writeMetadata();
+        }
+
+        if (!readMetadata()) {
+            storage->close();
+            storage.reset();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 写回所有脏页和元数据并关闭文件
+     * @return false 有页面或元数据未能写回，未写回的修改丢失
+     */
+    bool close() {
+        if (!storage) return true;
+        bool flushed = flush();
+        pages.clear();
+        storage->close();
+        storage.reset();
+        return flushed;
+    }
+
+    /**
+     * @brief 插入键值对，键存在时更新值
+     * @return true如果成功；读取途经的页面失败时返回false，树不变
+     */
+    bool insert(KeyType key, const std::string& value) {
+        if (!storage) return false;
+        trimCache();
+
+        if (rootPageId == -1) {
+            Node* root = createNode(true);
+            rootPageId = root->header().pageId;
+        }
+
+        KeyType promotedKey{};
+        int newPageId = -1;
+        bool inserted = false;
+        bool split = false;
+        if (!insertRecursive(rootPageId, key, value, inserted, split,
+                             promotedKey, newPageId)) {
+            return false;
+        }
+        if (split) {
+            // 根节点分裂，树长高一层
+            Node* newRoot = createNode(false);
+            newRoot->keys()[0] = promotedKey;
+            newRoot->children()[0] = rootPageId;
+            newRoot->children()[1] = newPageId;
+            newRoot->header().keyCount = 1;
+            rootPageId = newRoot->header().pageId;
+        }
+        if (inserted) entryCount++;
+        return true;
+    }
+
+    /**
+     * @brief 点查
+     * @param key 键
+     * @param value 输出参数，找到时写入值
+     * @return true如果键存在
+     */
+    bool get(KeyType key, std::string& value) {
+        if (!storage || rootPageId == -1) return false;
+        trimCache();
+
+        Node* leaf = findLeaf(key);
+        if (!leaf) return false;
+        int pos = leaf->lowerBound(key);
+        if (!leaf->matches(pos, key)) return false;
+        value = leaf->getValue(pos);
+        return true;
+    }
+
+    /**
+     * @brief 删除键
+     * @return true如果键存在并被删除
+     */
+    bool remove(KeyType key) {
+        if (!storage || rootPageId == -1) return false;
+        trimCache();
+
+        Node* leaf = findLeaf(key);
+        if (!leaf) return false;
+        int pos = leaf->lowerBound(key);
+        if (!leaf->matches(pos, key)) return false;
+        leaf->erase(pos);
+        entryCount--;
+        return true;
+    }
+
+    /**
+     * @brief 范围查询
+     * @param startKey 起始键（包含）
+     * @param endKey 结束键（包含）
+     * @param limit 最多返回的记录数，-1表示不限制
+     * @return 按键有序的记录列表，读取页面失败时只包含之前读到的记录
+     */
+    std::vector<std::pair<KeyType, std::string>> scan(KeyType startKey,
+                                                      KeyType endKey,
+                                                      int limit = -1) {
+        std::vector<std::pair<KeyType, std::string>> results;
+        if (!storage || rootPageId == -1 || KeyTraits::less(endKey, startKey)) {
+            return results;
+        }
+        trimCache();
+
+        Node* leaf = findLeaf(startKey);
+        int pos = leaf ? leaf->lowerBound(startKey) : 0;
+        while (leaf) {
+            for (; pos < leaf->header().keyCount; pos++) {
+                KeyType key = leaf->keys()[pos];
+                if (KeyTraits::less(endKey, key)) return results;
+                if (limit >= 0 && (int)results.size() >= limit) return results;
+                results.emplace_back(key, leaf->getValue(pos));
+            }
+            int next = leaf->header().nextLeafId;
+            leaf = next == -1 ? nullptr : fetch(next);
+            pos = 0;
+        }
+        return results;
+    }
+
+    /**
+     * @brief 写回所有脏页和元数据
+     * @return true如果全部写回并持久化
+     *
+     * 写回失败的页面保持为脏页留在缓存中；此时不写元数据，
+     * 文件中的元数据不会引用未写入的页面
+     */
+    bool flush() {
+        if (!storage) return false;
+        bool pagesWritten = true;
+        for (auto& pair : pages) {
+            if (pair.second->dirty && !writeNode(*pair.second)) {
+                pagesWritten = false;
+            }
+        }
+        if (!pagesWritten || !writeMetadata()) return false;
+        return storage->sync();
+    }
+
+    /**
+     * @brief 记录数
+     */
+    size_t size() const { return entryCount; }
+
+    /**
+     * @brief 树高度，空树为0
+     */
+    int height() {
+        int levels = 0;
+        int pageId = rootPageId;
+        while (pageId != -1) {
+            Node* node = fetch(pageId);
+            if (!node) break;
+            levels++;
+            pageId = node->header().isLeaf ? -1 : node->children()[0];
+        }
+        return levels;
+    }
+
+   private:
+    static const uint32_t MAGIC = 0x464B4254;  // "FKBT"
+
+    // 持久化的元数据
+    struct FixedKeyMetadata {
+        uint32_t magic;
+        uint32_t keySize;
+        uint32_t valueSize;
+        int rootPageId;
+        int nextPageId;
+        uint64_t entryCount;
+    };
+
+    // 页面及其在内存中的状态；键和子节点直接在页面字节上访问，读写磁盘无需转换
+    struct Node {
+        alignas(8) char data[PAGE_SIZE];
+        bool dirty;
+        uint64_t lastAccess;
+
+        FixedKeyPageHeader& header() {
+            return *reinterpret_cast<FixedKeyPageHeader*>(data);
+        }
+        KeyType* keys() {
+            return reinterpret_cast<KeyType*>(data + sizeof(FixedKeyPageHeader));
+        }
+        int* children() {
+            return reinterpret_cast<int*>(data + sizeof(FixedKeyPageHeader) +
+                                          INTERNAL_CAPACITY * sizeof(KeyType));
+        }
+        char* valueAt(int index) {
+            return data + sizeof(FixedKeyPageHeader) +
+                   LEAF_CAPACITY * sizeof(KeyType) + index * ValueSize;
+        }
+
+        int capacity() {
+            return header().isLeaf ? LEAF_CAPACITY : INTERNAL_CAPACITY;
+        }
+
+        /**
+         * @brief 第一个不小于key的位置
+         */
+        int lowerBound(KeyType key) {
+            return KeyTraits::lowerBound(keys(), header().keyCount, key);
+        }
+
+        /**
+         * @brief 第一个大于key的位置，即内部节点中应进入的子节点下标
+         */
+        int upperBound(KeyType key) {
+            return KeyTraits::upperBound(keys(), header().keyCount, key);
+        }
+
+        bool matches(int pos, KeyType key) {
+            return pos < header().keyCount && !KeyTraits::less(key, keys()[pos]);
+        }
+
+        std::string getValue(int index) {
+            const char* value = valueAt(index);
+            return std::string(value, strnlen(value, ValueSize));
+        }
+
+        void setValue(int index, const std::string& value) {
+            char* dest = valueAt(index);
+            size_t length = std::min(value.size(), ValueSize);
+            memcpy(dest, value.data(), length);
+            memset(dest + length, 0, ValueSize - length);
+        }
+
+        /**
+         * @brief 在叶子的pos处插入记录，调用方保证未满
+         */
+        void insertEntry(int pos, KeyType key, const std::string& value) {
+            int count = header().keyCount;
+            memmove(keys() + pos + 1, keys() + pos, (count - pos) * sizeof(KeyType));
+            memmove(valueAt(pos + 1), valueAt(pos), (count - pos) * ValueSize);
+            keys()[pos] = key;
+            setValue(pos, value);
+            header().keyCount++;
+            dirty = true;
+        }
+
+        /**
+         * @brief 在内部节点中插入分隔键及其右侧子节点，调用方保证未满
+         */
+        void insertSeparator(KeyType key, int rightChildId) {
+            int pos = upperBound(key);
+            int count = header().keyCount;
+            memmove(keys() + pos + 1, keys() + pos, (count - pos) * sizeof(KeyType));
+            memmove(children() + pos + 2, children() + pos + 1,
+                    (count - pos) * sizeof(int));
+            keys()[pos] = key;
+            children()[pos + 1] = rightChildId;
+            header().keyCount++;
+            dirty = true;
+        }
+
+        void erase(int pos) {
+            int count = header().keyCount;
+            memmove(keys() + pos, keys() + pos + 1,
+                    (count - pos - 1) * sizeof(KeyType));
+            memmove(valueAt(pos), valueAt(pos + 1), (count - pos - 1) * ValueSize);
+            header().keyCount--;
+            dirty = true;
+        }
+    };
+
+    std::unique_ptr<StorageManager> storage;
+    int rootPageId;
+    int nextPageId;
+    uint64_t entryCount;
+
+    // 页面缓存：只在公开操作开始时淘汰，操作过程中持有的Node*始终有效
+    std::unordered_map<int, std::unique_ptr<Node>> pages;
+    size_t cacheCapacity;
+    uint64_t accessClock;
+
+    bool readMetadata() {
+        std::vector<char> buffer(METADATA_SIZE, 0);
+        if (!storage->readMetadata(buffer.data())) return false;
+
+        FixedKeyMetadata meta;
+        memcpy(&meta, buffer.data(), sizeof(meta));
+        if (meta.magic != MAGIC || meta.keySize != sizeof(KeyType) ||
+            meta.valueSize != ValueSize) {
+            return false;
+        }
+        rootPageId = meta.rootPageId;
+        nextPageId = meta.nextPageId;
+        entryCount = meta.entryCount;
+        return true;
+    }
+
+    bool writeMetadata() {
+        FixedKeyMetadata meta;
+        meta.magic = MAGIC;
+        meta.keySize = sizeof(KeyType);
+        meta.valueSize = ValueSize;
+        meta.rootPageId = rootPageId;
+        meta.nextPageId = nextPageId;
+        meta.entryCount = entryCount;
+
+        std::vector<char> buffer(METADATA_SIZE, 0);
+        memcpy(buffer.data(), &meta, sizeof(meta));
+        return storage->writeMetadata(buffer.data());
+    }
+
+    bool writeNode(Node& node) {
+        if (!storage->writePage(node.header().pageId, node.data)) return false;
+        node.dirty = false;
+        return true;
+    }
+
+    Node* createNode(bool isLeaf) {
+        std::unique_ptr<Node> node(new Node());
+        memset(node->data, 0, PAGE_SIZE);
+        node->header().pageId = nextPageId++;
+        node->header().isLeaf = isLeaf ? 1 : 0;
+        node->header().keyCount = 0;
+        node->header().nextLeafId = -1;
+        node->dirty = true;
+        node->lastAccess = ++accessClock;
+
+        Node* raw = node.get();
+        pages[raw->header().pageId] = std::move(node);
+        return raw;
+    }
+
+    Node* fetch(int pageId) {
+        auto it = pages.find(pageId);
+        if (it != pages.end()) {
+            it->second->lastAccess = ++accessClock;
+            return it->second.get();
+        }
+
+        std::unique_ptr<Node> node(new Node());
+        if (!storage->readPage(pageId, node->data)) return nullptr;
+        node->dirty = false;
+        node->lastAccess = ++accessClock;
+
+        Node* raw = node.get();
+        pages[pageId] = std::move(node);
+        return raw;
+    }
+
+    /**
+     * @brief 缓存超出容量时淘汰最久未访问的页面，一次淘汰到容量的3/4
+     *
+     * 写回失败的脏页留在缓存中，之后的淘汰或flush再次写回
+     */
+    void trimCache() {
+        if (pages.size() <= cacheCapacity) return;
+
+        std::vector<std::pair<uint64_t, int>> candidates;
+        candidates.reserve(pages.size());
+        for (auto& pair : pages) {
+            if (pair.first != rootPageId) {
+                candidates.emplace_back(pair.second->lastAccess, pair.first);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        size_t target = cacheCapacity * 3 / 4;
+        for (const auto& candidate : candidates) {
+            if (pages.size() <= target) break;
+            auto it = pages.find(candidate.second);
+            if (it->second->dirty && !writeNode(*it->second)) continue;
+            pages.erase(it);
+        }
+    }
+
+    /**
+     * @brief 查找键所在的叶子，途经的页面读取失败时返回nullptr
+     */
+    Node* findLeaf(KeyType key) {
+        Node* node = fetch(rootPageId);
+        while (node && !node->header().isLeaf) {
+            node = fetch(node->children()[node->upperBound(key)]);
+        }
+        return node;
+    }
+
+    /**
+     * @brief 递归插入
+     * @param inserted 输出参数，是否新增了记录（false表示更新）
+     * @param split 输出参数，该节点是否分裂
+     * @param promotedKey 输出参数，节点分裂时上推的分隔键
+     * @param newPageId 输出参数，节点分裂时新建的右节点
+     * @return false 读取页面失败；页面在下降过程中读取，失败时尚未修改任何节点
+     */
+    bool insertRecursive(int pageId, KeyType key, const std::string& value,
+                         bool& inserted, bool& split, KeyType& promotedKey,
+                         int& newPageId) {
+        split = false;
+        Node* node = fetch(pageId);
+        if (!node) return false;
+
+        if (node->header().isLeaf) {
+            int pos = node->lowerBound(key);
+            if (node->matches(pos, key)) {
+                node->setValue(pos, value);
+                node->dirty = true;
+                return true;
+            }
+            inserted = true;
+            if (node->header().keyCount < LEAF_CAPACITY) {
+                node->insertEntry(pos, key, value);
+                return true;
+            }
+
+            Node* right = splitLeaf(node);
+            Node* target = KeyTraits::less(key, right->keys()[0]) ? node : right;
+            target->insertEntry(target->lowerBound(key), key, value);
+            promotedKey = right->keys()[0];
+            newPageId = right->header().pageId;
+            split = true;
+            return true;
+        }
+
+        int childId = node->children()[node->upperBound(key)];
+        KeyType childKey{};
+        int childNewPage = -1;
+        bool childSplit = false;
+        if (!insertRecursive(childId, key, value, inserted, childSplit, childKey,
+                             childNewPage)) {
+            return false;
+        }
+        if (!childSplit) return true;
+
+        if (node->header().keyCount < INTERNAL_CAPACITY) {
+            node->insertSeparator(childKey, childNewPage);
+            return true;
+        }
+
+        Node* right = splitInternal(node, promotedKey);
+        Node* target = KeyTraits::less(childKey, promotedKey) ? node : right;
+        target->insertSeparator(childKey, childNewPage);
+        newPageId = right->header().pageId;
+        split = true;
+        return true;
+    }
+
+    /**
+     * @brief 均分满叶子，返回新建的右节点
+     */
+    Node* splitLeaf(Node* node) {
+        Node* right = createNode(true);
+        int count = node->header().keyCount;
+        int mid = count / 2;
+        int moved = count - mid;
+
+        memcpy(right->keys(), node->keys() + mid, moved * sizeof(KeyType));
+        memcpy(right->valueAt(0), node->valueAt(mid), moved * ValueSize);
+        right->header().keyCount = moved;
+        right->header().nextLeafId = node->header().nextLeafId;
+
+        node->header().keyCount = mid;
+        node->header().nextLeafId = right->header().pageId;
+        node->dirty = true;
+        return right;
+    }
+
+    /**
+     * @brief 均分满内部节点，中间键上推，返回新建的右节点
+     */
+    Node* splitInternal(Node* node, KeyType& promotedKey) {
+        Node* right = createNode(false);
+        int count = node->header().keyCount;
+        int mid = count / 2;
+        int moved = count - mid - 1;
+
+        promotedKey = node->keys()[mid];
+        memcpy(right->keys(), node->keys() + mid + 1, moved * sizeof(KeyType));
+        memcpy(right->children(), node->children() + mid + 1,
+               (moved + 1) * sizeof(int));
+        right->header().keyCount = moved;
+
+        node->header().keyCount = mid;
+        node->dirty = true;
+        return right;
+    }
+};
@@ -0,0 +1,396 @@
+#include "IOEngine.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+// ================================ IOEngine 实现 ================================
+
+/**
+ * @brief 收割已完成的请求
+ * @param completed 输出参数，追加已完成的请求
+ * @param minComplete 至少等待完成的请求数
+ * @return 本次收割的请求数
+ */
+size_t IOEngine::reap(std::vector<PageIORequest*>& completed,
+                      size_t minComplete) {
+    progress(false);
+    while (completed_.size() < minComplete && pending() > 0) {
+        progress(true);
+    }
+
+    size_t count = completed_.size();
+    completed.insert(completed.end(), completed_.begin(), completed_.end());
+    completed_.clear();
+    return count;
+}
+
+/**
+ * @brief 等待指定请求全部完成
+ * @param requests 请求列表
+ * @return true如果全部请求都成功
+ *
+ * 期间完成的其他请求保留在completed_中，仍由其调用方通过reap收割
+ */
+bool IOEngine::wait(const std::vector<PageIORequest*>& requests) {
+    auto allDone = [&requests]() {
+        return std::all_of(
+            requests.begin(), requests.end(),
+            [](const PageIORequest* r) { return r->completed; });
+    };
+
+    progress(false);
+    while (!allDone() && pending() > 0) {
+        progress(true);
+    }
+
+    // 本批请求已由调用方直接处理，不再通过reap返回
+    completed_.erase(
+        std::remove_if(completed_.begin(), completed_.end(),
+                       [&requests](PageIORequest* r) {
+                           return std::find(requests.begin(), requests.end(),
+                                            r) != requests.end();
+                       }),
+        completed_.end());
+
+    return std::all_of(requests.begin(), requests.end(),
+                       [](const PageIORequest* r) { return r->success; });
+}
+
+/**
+ * @brief 同步执行一批请求
+ * @param requests 请求列表
+ * @return true如果全部请求都成功
+ */
+bool IOEngine::runBatch(const std::vector<PageIORequest*>& requests) {
+    if (requests.empty()) return true;
+    if (!submit(requests)) return false;
+    return wait(requests);
+}
+
+// ================================ SyncIOEngine 实现 ================================
+
+SyncIOEngine::SyncIOEngine(StorageManager& storage) : storage_(storage) {}
+
+/**
+ * @brief 逐个执行请求，立即完成
+ */
+bool SyncIOEngine::submit(const std::vector<PageIORequest*>& requests) {
+    for (PageIORequest* req : requests) {
+        if (req->type == PageIORequest::Type::READ) {
+            req->success = storage_.readPage(req->pageId, req->buffer);
+        } else {
+            req->success = storage_.writePage(req->pageId, req->buffer);
+        }
+        req->completed = true;
+        completed_.push_back(req);
+    }
+    return true;
+}
+
+// ================================ IoUringEngine 实现 ================================
+
+static int ioUringSetup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                        unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+/**
+ * @brief IoUringEngine构造函数
+ * @param storage 存储层
+ * @param queueDepth 提交队列深度
+ */
+IoUringEngine::IoUringEngine(PosixStorageManager& storage, unsigned queueDepth)
+    : storage_(storage),
+      ringFd_(-1),
+      sqEntries_(0),
+      cqEntries_(0),
+      inflight_(0),
+      sqRing_(nullptr),
+      cqRing_(nullptr),
+      sqRingSize_(0),
+      cqRingSize_(0),
+      sqes_(nullptr),
+      sqesSize_(0),
+      sqHead_(nullptr),
+      sqTail_(nullptr),
+      sqMask_(nullptr),
+      sqArray_(nullptr),
+      sqPending_(0),
+      cqHead_(nullptr),
+      cqTail_(nullptr),
+      cqMask_(nullptr),
+      cqes_(nullptr) {
+    if (!setup(queueDepth)) {
+        teardown();
+    }
+}
+
+/**
+ * @brief 析构函数，等待所有在途请求完成后释放ring
+ */
+IoUringEngine::~IoUringEngine() {
+    if (isValid()) {
+        while (inflight_ > 0) {
+            if (!enter(1)) break;
+            drainCompletions();
+        }
+    }
+    teardown();
+}
+
+/**
+ * @brief 创建io_uring实例并映射提交/完成队列
+ */
+bool IoUringEngine::setup(unsigned queueDepth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ringFd_ = ioUringSetup(std::max(queueDepth, 1u), &params);
+    if (ringFd_ < 0) {
+        return false;
+    }
+
+    sqEntries_ = params.sq_entries;
+    cqEntries_ = params.cq_entries;
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // 新内核中提交队列和完成队列可以共用一次映射
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        return false;
+    }
+
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            return false;
+        }
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+/**
+ * @brief 解除映射并关闭ring
+ */
+void IoUringEngine::teardown() {
+    if (sqes_) {
+        munmap(sqes_, sqesSize_);
+        sqes_ = nullptr;
+    }
+    if (cqRing_ && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = nullptr;
+    if (sqRing_) {
+        munmap(sqRing_, sqRingSize_);
+        sqRing_ = nullptr;
+    }
+    if (ringFd_ >= 0) {
+        ::close(ringFd_);
+        ringFd_ = -1;
+    }
+}
+
+/**
+ * @brief 提交一批请求
+ *
+ * 队列满或在途请求达到完成队列容量时，先提交已填写的SQE并收割部分完成事件，
+ * 这些提前收割的请求会在下一次reap中返回
+ */
+bool IoUringEngine::submit(const std::vector<PageIORequest*>& requests) {
+    if (!isValid()) return false;
+
+    for (PageIORequest* req : requests) {
+        // 保证完成队列不会溢出
+        while (inflight_ + sqPending_ >= cqEntries_ ||
+               sqPending_ >= sqEntries_) {
+            if (!enter(sqPending_ == 0 ? 1 : 0)) return false;
+            drainCompletions();
+        }
+
+        unsigned tail = *sqTail_;
+        unsigned index = tail & *sqMask_;
+        struct io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+
+        sqe->opcode = req->type == PageIORequest::Type::READ ? IORING_OP_READ
+                                                             : IORING_OP_WRITE;
+        sqe->fd = storage_.fd();
+        sqe->addr = reinterpret_cast<unsigned long long>(req->buffer);
+        sqe->len = static_cast<unsigned>(storage_.pageSize());
+        sqe->off = static_cast<unsigned long long>(
+            storage_.pageOffset(req->pageId));
+        sqe->user_data = reinterpret_cast<unsigned long long>(req);
+
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        sqPending_++;
+    }
+
+    // 一次系统调用提交整批请求
+    return enter(0);
+}
+
+/**
+ * @brief 推进I/O，将完成队列中的事件移入completed_
+ * @param block 是否阻塞等待至少一个请求完成
+ */
+void IoUringEngine::progress(bool block) {
+    if (!isValid()) return;
+
+    if (drainCompletions() > 0 || !block || pending() == 0) {
+        return;
+    }
+    if (enter(1)) {
+        drainCompletions();
+    }
+}
+
+/**
+ * @brief 将已填写的SQE提交给内核，并可选等待完成
+ */
+bool IoUringEngine::enter(unsigned minComplete) {
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (sqPending_ == 0 && minComplete == 0) return true;
+
+    while (true) {
+        int ret = ioUringEnter(ringFd_, sqPending_, minComplete, flags);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "io_uring_enter failed: " << strerror(errno)
+                      << std::endl;
+            return false;
+        }
+        unsigned submitted = static_cast<unsigned>(ret);
+        submitted = std::min(submitted, sqPending_);
+        sqPending_ -= submitted;
+        inflight_ += submitted;
+        return true;
+    }
+}
+
+/**
+ * @brief 从完成队列中取出所有已完成的请求
+ */
+size_t IoUringEngine::drainCompletions() {
+    size_t count = 0;
+    unsigned head = *cqHead_;
+    while (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe* cqe = &cqes_[head & *cqMask_];
+        auto* req = reinterpret_cast<PageIORequest*>(cqe->user_data);
+        complete(req, cqe->res);
+        req->completed = true;
+        completed_.push_back(req);
+        head++;
+        count++;
+        if (inflight_ > 0) inflight_--;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+/**
+ * @brief 处理单个完成事件
+ * @param request 完成的请求
+ * @param result 内核返回的字节数或负的错误码
+ */
+void IoUringEngine::complete(PageIORequest* request, int result) {
+    size_t pageSize = storage_.pageSize();
+    if (result >= 0 && static_cast<size_t>(result) == pageSize) {
+        request->success = true;
+        return;
+    }
+
+    // 读到文件末尾：补零并报告未读到完整页面
+    if (result == 0 && request->type == PageIORequest::Type::READ) {
+        memset(request->buffer, 0, pageSize);
+        request->success = false;
+        return;
+    }
+
+    // 出错（如旧内核不支持该操作码）或短读写：同步重做整个页面
+    if (result < 0 && result != -EINVAL && result != -EOPNOTSUPP) {
+        std::cerr << "Async "
+                  << (request->type == PageIORequest::Type::READ ? "read"
+                                                                 : "write")
+                  << " of page " << request->pageId
+                  << " failed: " << strerror(-result) << ", retrying with "
+                  << (request->type == PageIORequest::Type::READ ? "pread"
+                                                                 : "pwrite")
+                  << std::endl;
+    }
+    if (request->type == PageIORequest::Type::READ) {
+        request->success = storage_.readPage(request->pageId, request->buffer);
+    } else {
+        request->success =
+            storage_.writePage(request->pageId, request->buffer);
+    }
+}
+
+// ================================ 工厂函数 ================================
+
+/**
+ * @brief 创建I/O引擎
+ * @param storage 存储层
+ * @param preferAsync 是否尝试使用io_uring
+ * @param queueDepth 提交队列深度
+ */
+std::unique_ptr<IOEngine> createIOEngine(PosixStorageManager& storage,
+                                         bool preferAsync,
+                                         unsigned queueDepth) {
+    if (preferAsync) {
+        auto engine = std::make_unique<IoUringEngine>(storage, queueDepth);
+        if (engine->isValid()) {
+            return engine;
+        }
+        // 内核不支持或被seccomp禁止，回退到同步I/O
+    }
+    return std::make_unique<SyncIOEngine>(storage);
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "StorageManager.h"
+
+/**
+ * @brief 单个页面I/O请求
+ *
+ * 请求对象由调用方持有，从提交到被reap返回之前必须保持有效
+ */
+struct PageIORequest {
+    enum class Type { READ, WRITE };
+
+    Type type;         // 读或写
+    int pageId;        // 页面ID
+    char* buffer;      // 页面缓冲区，直接I/O时必须按StorageManager要求对齐
+    bool completed;    // 是否已完成
+    bool success;      // 完成后：是否读写了完整页面
+    void* userData;    // 调用方上下文
+
+    PageIORequest(Type t = Type::READ, int id = -1, char* buf = nullptr,
+                  void* data = nullptr)
+        : type(t),
+          pageId(id),
+          buffer(buf),
+          completed(false),
+          success(false),
+          userData(data) {}
+};
+
+/**
+ * @brief 页面I/O引擎抽象接口
+ *
+ * 允许一次提交多个页面读写请求并异步收割完成结果，
+ * 用于批量刷盘、预取和批量查询
+ */
+class IOEngine {
+   public:
+    virtual ~IOEngine() = default;
+
+    /**
+     * @brief 提交一批请求
+     * @param requests 请求列表
+     * @return true如果全部提交成功
+     */
+    virtual bool submit(const std::vector<PageIORequest*>& requests) = 0;
+
+    /**
+     * @brief 引擎名称（调试用）
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief 收割已完成的请求
+     * @param completed 输出参数，追加已完成的请求
+     * @param minComplete 至少等待完成的请求数，0表示不阻塞
+     * @return 本次收割的请求数
+     */
+    size_t reap(std::vector<PageIORequest*>& completed,
+                size_t minComplete = 0);
+
+    /**
+     * @brief 等待指定请求全部完成，这些请求不会再出现在reap结果中
+     * @param requests 请求列表（必须已提交）
+     * @return true如果全部请求都成功
+     */
+    bool wait(const std::vector<PageIORequest*>& requests);
+
+    /**
+     * @brief 同步执行一批请求：提交并等待全部完成
+     * @param requests 请求列表
+     * @return true如果全部请求都成功
+     */
+    bool runBatch(const std::vector<PageIORequest*>& requests);
+
+    /**
+     * @brief 已提交但尚未被收割的请求数
+     */
+    size_t inflight() const { return pending() + completed_.size(); }
+
+   protected:
+    // 已完成、等待调用方收割的请求
+    std::deque<PageIORequest*> completed_;
+
+    /**
+     * @brief 推进I/O：将已完成的请求移入completed_
+     * @param block 是否阻塞等待至少一个请求完成
+     */
+    virtual void progress(bool block) = 0;
+
+    /**
+     * @brief 已提交给底层、尚未完成的请求数
+     */
+    virtual size_t pending() const = 0;
+};
+
+/**
+ * @brief 同步I/O引擎
+ *
+ * 在submit中逐个调用pread/pwrite立即完成请求，
+ * 作为io_uring不可用时的回退实现
+ */
+class SyncIOEngine : public IOEngine {
+   public:
+    explicit SyncIOEngine(StorageManager& storage);
+
+    bool submit(const std::vector<PageIORequest*>& requests) override;
+    const char* name() const override { return "sync"; }
+
+   protected:
+    void progress(bool /*block*/) override {}
+    size_t pending() const override { return 0; }
+
+   private:
+    StorageManager& storage_;
+};
+
+/**
+ * @brief 基于io_uring的异步I/O引擎
+ *
+ * 功能特性：
+ * - 多个页面读写在一次io_uring_enter系统调用中提交
+ * - 完成结果通过共享内存的完成队列收割，无需逐个系统调用
+ * - 直接使用内核接口，不依赖liburing
+ */
+class IoUringEngine : public IOEngine {
+   public:
+    /**
+     * @brief 构造函数
+     * @param storage 提供文件描述符和页面偏移的存储层
+     * @param queueDepth 提交队列深度
+     */
+    IoUringEngine(PosixStorageManager& storage, unsigned queueDepth = 64);
+    ~IoUringEngine() override;
+
+    /**
+     * @brief io_uring是否初始化成功
+     */
+    bool isValid() const { return ringFd_ >= 0; }
+
+    bool submit(const std::vector<PageIORequest*>& requests) override;
+    const char* name() const override { return "io_uring"; }
+
+   protected:
+    void progress(bool block) override;
+    size_t pending() const override { return inflight_ + sqPending_; }
+
+   private:
+    PosixStorageManager& storage_;
+    int ringFd_;          // io_uring文件描述符
+    unsigned sqEntries_;  // 提交队列容量
+    unsigned cqEntries_;  // 完成队列容量
+    size_t inflight_;     // 已提交到内核、尚未完成的请求数
+
+    // 映射的共享内存区域
+    void* sqRing_;
+    void* cqRing_;
+    size_t sqRingSize_;
+    size_t cqRingSize_;
+    struct io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    // 提交队列指针
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned* sqMask_;
+    unsigned* sqArray_;
+    unsigned sqPending_;  // 已填写但尚未通过enter提交的SQE数
+
+    // 完成队列指针
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned* cqMask_;
+    struct io_uring_cqe* cqes_;
+
+    bool setup(unsigned queueDepth);
+    void teardown();
+
+    /**
+     * @brief 将已填写的SQE提交给内核，并可选等待完成
+     */
+    bool enter(unsigned minComplete);
+
+    /**
+     * @brief 从完成队列中取出所有已完成的请求到completed_
+     *
+     * submit过程中为腾出队列空间也会提前调用，这些请求在下一次reap中返回
+     */
+    size_t drainCompletions();
+
+    /**
+     * @brief 处理单个完成事件，必要时用pread/pwrite补齐短读写
+     */
+    void complete(PageIORequest* request, int result);
+};
+
+/**
+ * @brief 创建I/O引擎：优先io_uring，不可用时回退到同步pread/pwrite
+ * @param storage 存储层
+ * @param preferAsync 是否尝试使用io_uring
+ * @param queueDepth 提交队列深度
+ */
+std::unique_ptr<IOEngine> createIOEngine(PosixStorageManager& storage,
+                                         bool preferAsync = true,
+                                         unsigned queueDepth = 64);
@@ -0,0 +1,118 @@
+#include "KeyEncoding.h"
+
+// 转义前缀及其后缀字节
+static const unsigned char ESCAPE = 0x01;
+static const unsigned char ESCAPED_TERMINATOR = 0x01;
+static const unsigned char ESCAPED_ZERO = 0x02;
+static const unsigned char ESCAPED_ESCAPE = 0x03;
+
+/**
+ * @brief 输出一个字节，0x00和0x01需要转义
+ */
+void KeyEncoder::appendEscaped(unsigned char byte) {
+    if (byte == 0x00) {
+        buffer_.push_back(static_cast<char>(ESCAPE));
+        buffer_.push_back(static_cast<char>(ESCAPED_ZERO));
+    } else if (byte == ESCAPE) {
+        buffer_.push_back(static_cast<char>(ESCAPE));
+        buffer_.push_back(static_cast<char>(ESCAPED_ESCAPE));
+    } else {
+        buffer_.push_back(static_cast<char>(byte));
+    }
+}
+
+/**
+ * @brief 追加无符号整数
+ * @param value 整数值
+ */
+KeyEncoder& KeyEncoder::appendUInt(uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        appendEscaped(static_cast<unsigned char>(value >> shift));
+    }
+    return *this;
+}
+
+/**
+ * @brief 追加有符号整数
+ * @param value 整数值
+ *
+ * 翻转符号位后负数排在正数之前，且同号数值的大小顺序不变
+ */
+KeyEncoder& KeyEncoder::appendInt(int64_t value) {
+    return appendUInt(static_cast<uint64_t>(value) ^ (uint64_t(1) << 63));
+}
+
+/**
+ * @brief 追加字符串
+ * @param value 字符串（可包含任意字节）
+ */
+KeyEncoder& KeyEncoder::appendString(const std::string& value) {
+    for (unsigned char byte : value) {
+        appendEscaped(byte);
+    }
+    buffer_.push_back(static_cast<char>(ESCAPE));
+    buffer_.push_back(static_cast<char>(ESCAPED_TERMINATOR));
+    return *this;
+}
+
+bool KeyDecoder::readEscaped(unsigned char& byte, bool& terminator) {
+    terminator = false;
+    if (pos_ >= key_.size()) return false;
+
+    byte = static_cast<unsigned char>(key_[pos_++]);
+    if (byte != ESCAPE) return true;
+
+    if (pos_ >= key_.size()) return false;
+    unsigned char code = static_cast<unsigned char>(key_[pos_++]);
+    switch (code) {
+        case ESCAPED_TERMINATOR:
+            terminator = true;
+            return true;
+        case ESCAPED_ZERO:
+            byte = 0x00;
+            return true;
+        case ESCAPED_ESCAPE:
+            byte = ESCAPE;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief 读取无符号整数列
+ */
+bool KeyDecoder::readUInt(uint64_t& value) {
+    value = 0;
+    for (int i = 0; i < 8; i++) {
+        unsigned char byte;
+        bool terminator;
+        if (!readEscaped(byte, terminator) || terminator) return false;
+        value = (value << 8) | byte;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取有符号整数列
+ */
+bool KeyDecoder::readInt(int64_t& value) {
+    uint64_t raw;
+    if (!readUInt(raw)) return false;
+    value = static_cast<int64_t>(raw ^ (uint64_t(1) << 63));
+    return true;
+}
+
+/**
+ * @brief 读取字符串列
+ */
+bool KeyDecoder::readString(std::string& value) {
+    value.clear();
+    while (true) {
+        unsigned char byte;
+        bool terminator;
+        if (!readEscaped(byte, terminator)) return false;
+        if (terminator) return true;
+        value.push_back(static_cast<char>(byte));
+    }
+}
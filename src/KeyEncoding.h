@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 保序二进制键编码（memcomparable）
+ *
+ * 编码结果按字节比较的顺序与原值的顺序一致，多列元组按列依次比较，
+ * 因此整数范围在叶子链表中是连续的。编码中不含0字节，
+ * 可以直接作为BPlusTree的键（C字符串）使用。
+ *
+ * 字节转义规则（0x01作为转义前缀）：
+ * - 0x00 -> 0x01 0x02
+ * - 0x01 -> 0x01 0x03
+ * - 其他字节原样输出
+ * - 字符串结束符 -> 0x01 0x01（小于任何字符，使"ab" < "abc"）
+ */
+class KeyEncoder {
+   public:
+    /**
+     * @brief 追加有符号整数：翻转符号位后按大端序输出8字节
+     */
+    KeyEncoder& appendInt(int64_t value);
+
+    /**
+     * @brief 追加无符号整数：按大端序输出8字节
+     */
+    KeyEncoder& appendUInt(uint64_t value);
+
+    /**
+     * @brief 追加字符串：转义后加结束符，作为元组中间列时仍然保序
+     */
+    KeyEncoder& appendString(const std::string& value);
+
+    /**
+     * @brief 编码结果
+     */
+    const std::string& data() const { return buffer_; }
+
+    size_t size() const { return buffer_.size(); }
+    void clear() { buffer_.clear(); }
+
+   private:
+    std::string buffer_;
+
+    void appendEscaped(unsigned char byte);
+};
+
+/**
+ * @brief 按编码时的列顺序解码KeyEncoder生成的键
+ */
+class KeyDecoder {
+   public:
+    explicit KeyDecoder(const std::string& key) : key_(key), pos_(0) {}
+
+    bool readInt(int64_t& value);
+    bool readUInt(uint64_t& value);
+    bool readString(std::string& value);
+
+    /**
+     * @brief 是否已读完全部列
+     */
+    bool atEnd() const { return pos_ >= key_.size(); }
+
+   private:
+    const std::string& key_;
+    size_t pos_;
+
+    /**
+     * @brief 读取一个转义后的字节
+     * @param byte 输出参数，原始字节
+     * @param terminator 输出参数，是否读到字符串结束符
+     * @return false如果数据不完整
+     */
+    bool readEscaped(unsigned char& byte, bool& terminator);
+};
+
+/**
+ * @brief 编码单个整数键
+ */
+inline std::string encodeIntKey(int64_t value) {
+    return KeyEncoder().appendInt(value).data();
+}
+
+/**
+ * @brief 编码单个字符串键
+ */
+inline std::string encodeStringKey(const std::string& value) {
+    return KeyEncoder().appendString(value).data();
+}
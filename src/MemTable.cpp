@@ -0,0 +1,530 @@
+#include "MemTable.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+// ================================ MemTable 实现 ================================
+
+MemTable::MemTable()
+    : head_(new Node()), level_(1), size_(0), memoryUsage_(0), rng_(0x5eed) {
+    head_->next.assign(MAX_LEVEL, nullptr);
+}
+
+/**
+ * @brief 新节点的层数，每层以1/4的概率继续上升
+ */
+int MemTable::randomLevel() {
+    int level = 1;
+    while (level < MAX_LEVEL && (rng_() & 3) == 0) {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief 查找第一个不小于key的节点
+ * @param key 键
+ * @param prev 不为nullptr时输出每层最后一个小于key的节点
+ */
+MemTable::Node* MemTable::findGreaterOrEqual(const std::string& key,
+                                             Node** prev) const {
+    Node* current = head_.get();
+    for (int i = level_ - 1; i >= 0; i--) {
+        while (current->next[i] && current->next[i]->key < key) {
+            current = current->next[i];
+        }
+        if (prev) prev[i] = current;
+    }
+    return current->next[0];
+}
+
+void MemTable::put(const std::string& key, const Entry& entry) {
+    Node* prev[MAX_LEVEL];
+    Node* found = findGreaterOrEqual(key, prev);
+    if (found && found->key == key) {
+        memoryUsage_ += entry.value.size() + entry.rowId.size();
+        memoryUsage_ -= found->entry.value.size() + found->entry.rowId.size();
+        found->entry = entry;
+        return;
+    }
+
+    int level = randomLevel();
+    for (int i = level_; i < level; i++) {
+        prev[i] = head_.get();
+    }
+    level_ = std::max(level_, level);
+
+    auto node = std::unique_ptr<Node>(new Node{key, entry, {}});
+    node->next.resize(level);
+    for (int i = 0; i < level; i++) {
+        node->next[i] = prev[i]->next[i];
+        prev[i]->next[i] = node.get();
+    }
+    memoryUsage_ += sizeof(Node) + level * sizeof(Node*) + key.size() +
+                    entry.value.size() + entry.rowId.size();
+    nodes_.push_back(std::move(node));
+    size_++;
+}
+
+const MemTable::Entry* MemTable::find(const std::string& key) const {
+    Node* found = findGreaterOrEqual(key, nullptr);
+    if (found && found->key == key) return &found->entry;
+    return nullptr;
+}
+
+// ================================ MemTableTree 实现 ================================
+
+/**
+ * @brief FNV-1a校验和，用于识别日志末尾写了一半的记录
+ */
+static uint64_t fnv1a(uint64_t h, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// 日志记录头：三个字段的长度和墓碑标记，之后是键、rowId、值和校验和
+struct LogRecordHeader {
+    uint32_t keyLength;
+    uint32_t rowIdLength;
+    uint32_t valueLength;
+    uint32_t deleted;
+};
+
+MemTableTree::MemTableTree(BPlusTree& tree)
+    : tree_(tree),
+      memtableBytes_(4 << 20),
+      syncWrites_(false),
+      longValues_(false),
+      activeLogSeq_(0),
+      logFd_(-1),
+      stopping_(false),
+      mergeFailing_(false),
+      mergedTables_(0),
+      mergedRecords_(0),
+      writeStalls_(0),
+      mergeFailures_(0) {}
+
+MemTableTree::~MemTableTree() { close(); }
+
+std::string MemTableTree::logPath(uint64_t seq) const {
+    return logPrefix_ + "." + std::to_string(seq);
+}
+
+bool MemTableTree::open(const std::string& logPrefix, size_t memtableBytes,
+                        bool syncWrites) {
+    close();
+    logPrefix_ = logPrefix;
+    memtableBytes_ = std::max<size_t>(memtableBytes, 1);
+    syncWrites_ = syncWrites;
+    longValues_ = tree_.storesFullValues();
+
+    if (!replayLogs()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!openLog(activeLogSeq_)) return false;
+    active_ = std::make_shared<MemTable>();
+    stopping_ = false;
+    merger_ = std::thread(&MemTableTree::mergeLoop, this);
+    return true;
+}
+
+/**
+ * @brief 按序号重放遗留的日志
+ *
+ * 每个日志读入一个内存表后直接合并到树中并提交，再删除该日志；
+ * 写入中的日志从最大序号之后开始编号
+ */
+bool MemTableTree::replayLogs() {
+    size_t slash = logPrefix_.rfind('/');
+    std::string directory =
+        slash == std::string::npos ? "." : logPrefix_.substr(0, slash);
+    std::string namePrefix =
+        (slash == std::string::npos ? logPrefix_ : logPrefix_.substr(slash + 1)) +
+        ".";
+
+    std::vector<uint64_t> sequences;
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() <= namePrefix.size() ||
+                name.compare(0, namePrefix.size(), namePrefix) != 0) {
+                continue;
+            }
+            std::string digits = name.substr(namePrefix.size());
+            if (digits.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+            sequences.push_back(std::stoull(digits));
+        }
+        closedir(dir);
+    }
+    std::sort(sequences.begin(), sequences.end());
+    activeLogSeq_ = sequences.empty() ? 1 : sequences.back() + 1;
+
+    for (uint64_t seq : sequences) {
+        int fd = ::open(logPath(seq).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        std::string data;
+        char buffer[65536];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            data.append(buffer, n);
+        }
+        ::close(fd);
+
+        // 校验和不符或长度不足的记录是崩溃时写了一半的末尾，之后的内容忽略
+        MemTable table;
+        size_t offset = 0;
+        while (offset + sizeof(LogRecordHeader) <= data.size()) {
+            LogRecordHeader header;
+            memcpy(&header, data.data() + offset, sizeof(header));
+            size_t bodyLength = (size_t)header.keyLength + header.rowIdLength +
+                                header.valueLength;
+            size_t recordLength =
+                sizeof(header) + bodyLength + sizeof(uint64_t);
+            if (offset + recordLength > data.size()) break;
+
+            uint64_t checksum;
+            memcpy(&checksum, data.data() + offset + sizeof(header) + bodyLength,
+                   sizeof(checksum));
+            if (fnv1a(1469598103934665603ULL, data.data() + offset,
+                      sizeof(header) + bodyLength) != checksum) {
+                break;
+            }
+
+            const char* body = data.data() + offset + sizeof(header);
+            std::string key(body, header.keyLength);
+            MemTable::Entry entry;
+            entry.rowId.assign(body + header.keyLength, header.rowIdLength);
+            entry.value.assign(body + header.keyLength + header.rowIdLength,
+                               header.valueLength);
+            entry.deleted = header.deleted != 0;
+            table.put(key, entry);
+            offset += recordLength;
+        }
+
+        if (!mergeIntoTree(table)) return false;
+        {
+            std::lock_guard<std::mutex> lock(treeMutex_);
+            if (!tree_.commit()) return false;
+        }
+        ::unlink(logPath(seq).c_str());
+    }
+    return true;
+}
+
+bool MemTableTree::openLog(uint64_t seq) {
+    logFd_ = ::open(logPath(seq).c_str(),
+                    O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (logFd_ < 0) {
+        std::cerr << "Failed to open memtable log " << logPath(seq) << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 把一次写入追加到当前日志
+ */
+bool MemTableTree::appendLog(const std::string& key,
+                             const MemTable::Entry& entry) {
+    if (logFd_ < 0) return false;
+
+    LogRecordHeader header;
+    header.keyLength = key.size();
+    header.rowIdLength = entry.rowId.size();
+    header.valueLength = entry.value.size();
+    header.deleted = entry.deleted ? 1 : 0;
+
+    std::string record(reinterpret_cast<const char*>(&header), sizeof(header));
+    record += key;
+    record += entry.rowId;
+    record += entry.value;
+    uint64_t checksum =
+        fnv1a(1469598103934665603ULL, record.data(), record.size());
+    record.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+
+    size_t written = 0;
+    while (written < record.size()) {
+        ssize_t n = ::write(logFd_, record.data() + written,
+                            record.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        written += n;
+    }
+    return !syncWrites_ || ::fdatasync(logFd_) == 0;
+}
+
+/**
+ * @brief 写入日志和内存表，写满时封存
+ *
+ * 合并持续失败且封存的内存表已达上限时拒绝写入，不再无限占用内存
+ */
+bool MemTableTree::write(const std::string& key, const MemTable::Entry& entry) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!active_) return false;
+    if (mergeFailing_ && sealed_.size() >= MAX_SEALED_TABLES) {
+        std::cerr << "Memtable merge is failing, rejecting write" << std::endl;
+        return false;
+    }
+    // 封存时新日志打开失败，重新尝试并报告错误
+    if (logFd_ < 0 && !openLog(activeLogSeq_)) return false;
+    if (!appendLog(key, entry)) return false;
+    active_->put(key, entry);
+    if (active_->memoryUsage() >= memtableBytes_) {
+        seal(lock, true);
+    }
+    return true;
+}
+
+/**
+ * @brief 封存写入中的内存表，交给后台线程合并
+ * @param lock 已持有的mutex_
+ * @param reopen 是否为新的内存表打开日志（关闭时为false）
+ *
+ * 等待合并的内存表达到上限时先等待合并完成，限制内存占用；
+ * 合并失败时不再等待，之后的写入由write拒绝
+ */
+void MemTableTree::seal(std::unique_lock<std::mutex>& lock, bool reopen) {
+    while (sealed_.size() >= MAX_SEALED_TABLES && !mergeFailing_) {
+        writeStalls_++;
+        mergeDone_.wait(lock);
+    }
+    if (active_->empty()) return;            // 等待期间已被其他写入封存
+
+    if (logFd_ >= 0) {
+        ::close(logFd_);
+        logFd_ = -1;
+    }
+    sealed_.push_back({active_, activeLogSeq_});
+    active_ = std::make_shared<MemTable>();
+    activeLogSeq_++;
+    if (reopen && !openLog(activeLogSeq_)) {
+        // logFd_保持-1，下一次写入重新尝试打开
+        std::cerr << "Memtable writes fail until the log can be opened"
+                  << std::endl;
+    }
+    mergeWork_.notify_one();
+}
+
+bool MemTableTree::insert(const std::string& key,
+                          const std::vector<std::string>& value,
+                          const std::string& rowId) {
+    // 与树中的存储一致：树会截断的值按KeyValue截断后写入，合并前后读到的值相同；
+    // 值日志或溢出页模式下原样写入，合并时由BPlusTree::write保存完整的值
+    KeyValue kv(key, rowId, value.empty() ? "" : value[0]);
+    std::string stored = longValues_ && !value.empty() ? value[0] : kv.getValue();
+    return write(kv.getKey(), {stored, kv.getRowId(), false});
+}
+
+bool MemTableTree::remove(const std::string& key) {
+    return write(KeyValue(key, "", "").getKey(), {"", "", true});
+}
+
+std::vector<std::vector<std::string>> MemTableTree::get(const std::string& key) {
+    std::string storedKey = KeyValue(key, "", "").getKey();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active_) {
+            const MemTable::Entry* entry = active_->find(storedKey);
+            for (auto it = sealed_.rbegin(); !entry && it != sealed_.rend();
+                 ++it) {
+                entry = it->table->find(storedKey);
+            }
+            if (entry) {
+                if (entry->deleted) return {};
+                return {{entry->value}};
+            }
+        }
+    }
+
+    // 封存的内存表在合并并提交之后才移出，不在内存表中的键以树为准
+    std::lock_guard<std::mutex> lock(treeMutex_);
+    return tree_.get(key);
+}
+
+std::vector<KeyValue> MemTableTree::scan(const std::string& startKey,
+                                         const std::string& endKey, int limit) {
+    // 由旧到新叠加范围内的内存表写入
+    std::map<std::string, MemTable::Entry> overlay;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto collect = [&](const MemTable& table) {
+            for (auto it = table.lowerBound(startKey);
+                 it.isValid() && it.key() <= endKey; it.next()) {
+                overlay[it.key()] = it.entry();
+            }
+        };
+        for (const auto& sealed : sealed_) {
+            collect(*sealed.table);
+        }
+        if (active_) {
+            collect(*active_);
+        }
+    }
+
+    // 每个内存表写入最多遮盖树中的一条记录
+    std::vector<KeyValue> base;
+    {
+        std::lock_guard<std::mutex> lock(treeMutex_);
+        base = tree_.scan(startKey, endKey,
+                          limit < 0 ? -1 : limit + (int)overlay.size());
+    }
+
+    std::vector<KeyValue> result;
+    auto o = overlay.begin();
+    size_t b = 0;
+    while ((limit < 0 || (int)result.size() < limit) &&
+           (o != overlay.end() || b < base.size())) {
+        if (o != overlay.end() &&
+            (b == base.size() || base[b].compareKey(o->first) >= 0)) {
+            if (b < base.size() && base[b].compareKey(o->first) == 0) b++;
+            if (!o->second.deleted) {
+                result.emplace_back(o->first, o->second.rowId, o->second.value);
+            }
+            ++o;
+        } else {
+            result.push_back(base[b++]);
+        }
+    }
+    return result;
+}
+
+bool MemTableTree::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!active_) return false;
+    seal(lock, true);
+    size_t failures = mergeFailures_;
+    mergeDone_.wait(lock, [this, failures] {
+        return sealed_.empty() || mergeFailures_ != failures;
+    });
+    return sealed_.empty();
+}
+
+bool MemTableTree::close() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!active_) return true;
+        seal(lock, false);
+        stopping_ = true;
+    }
+    mergeWork_.notify_all();
+    if (merger_.joinable()) {
+        merger_.join();                      // 后台线程合并完所有内存表后退出
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool merged = sealed_.empty();
+    if (!merged) {
+        std::cerr << sealed_.size()
+                  << " memtables not merged, keeping their logs for replay"
+                  << std::endl;
+        sealed_.clear();
+    }
+    if (logFd_ >= 0) {
+        ::close(logFd_);
+        logFd_ = -1;
+    }
+    ::unlink(logPath(activeLogSeq_).c_str());  // 空的写入中日志
+    active_.reset();
+    stopping_ = false;
+    mergeFailing_ = false;
+    return merged;
+}
+
+/**
+ * @brief 按键顺序把内存表分批写入树
+ *
+ * 每批只在WriteBatch应用期间持有树的锁，读取最多等待一批
+ */
+bool MemTableTree::mergeIntoTree(const MemTable& table) {
+    bool ok = true;
+    WriteBatch batch;
+    auto apply = [&]() {
+        std::lock_guard<std::mutex> lock(treeMutex_);
+        ok = tree_.write(batch) && ok;
+        batch.clear();
+    };
+    for (auto it = table.begin(); it.isValid(); it.next()) {
+        if (it.entry().deleted) {
+            batch.remove(it.key());
+        } else {
+            batch.put(it.key(), {it.entry().value}, it.entry().rowId);
+        }
+        if (batch.size() >= MERGE_CHUNK) apply();
+    }
+    if (!batch.empty()) apply();
+    return ok;
+}
+
+/**
+ * @brief 后台合并线程：依次合并最旧的封存内存表，提交后删除其日志
+ *
+ * 合并完成后才把内存表移出，期间读取仍能在其中找到这些写入。
+ * 合并或提交失败时内存表和日志都保留，间隔一段时间后重新合并
+ * （重复应用已写入的部分不改变结果）；关闭时不再重试，日志在下次打开时重放
+ */
+void MemTableTree::mergeLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        mergeWork_.wait(lock, [this] { return stopping_ || !sealed_.empty(); });
+        if (sealed_.empty()) return;         // 停止且已合并完
+
+        SealedTable next = sealed_.front();
+        lock.unlock();
+        bool merged = mergeIntoTree(*next.table);
+        if (merged) {
+            std::lock_guard<std::mutex> treeLock(treeMutex_);
+            merged = tree_.commit();
+        }
+        if (merged) {
+            ::unlink(logPath(next.logSeq).c_str());
+        } else {
+            std::cerr << "Memtable merge failed, keeping " << logPath(next.logSeq)
+                      << std::endl;
+        }
+        lock.lock();
+
+        if (!merged) {
+            mergeFailures_++;
+            mergeFailing_ = true;
+            mergeDone_.notify_all();
+            if (stopping_) return;
+            mergeWork_.wait_for(lock, std::chrono::milliseconds(MERGE_RETRY_MS),
+                                [this] { return stopping_; });
+            continue;
+        }
+        mergeFailing_ = false;
+        sealed_.pop_front();
+        mergedTables_++;
+        mergedRecords_ += next.table->size();
+        mergeDone_.notify_all();
+    }
+}
+
+MemTableTree::Stats MemTableTree::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.activeEntries = active_ ? active_->size() : 0;
+    stats.sealedTables = sealed_.size();
+    stats.mergedTables = mergedTables_;
+    stats.mergedRecords = mergedRecords_;
+    stats.writeStalls = writeStalls_;
+    stats.mergeFailures = mergeFailures_;
+    return stats;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BPlusTree.h"
+
+/**
+ * @brief 按键有序的内存表（跳表）
+ *
+ * 保存尚未合并到B+树的写入，删除记为墓碑。本身不加锁：
+ * 写入中的内存表由MemTableTree在互斥锁下访问，写满封存后只读，可以并发读取
+ */
+class MemTable {
+   public:
+    struct Entry {
+        std::string value;
+        std::string rowId;
+        bool deleted;  // 墓碑
+    };
+
+    MemTable();
+
+    /**
+     * @brief 写入或覆盖一个键
+     */
+    void put(const std::string& key, const Entry& entry);
+
+    /**
+     * @brief 查找键
+     * @return 键的最新写入（可能是墓碑），不存在时返回nullptr
+     */
+    const Entry* find(const std::string& key) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * @brief 近似占用的内存字节数，用于判断是否写满
+     */
+    size_t memoryUsage() const { return memoryUsage_; }
+
+   private:
+    static const int MAX_LEVEL = 12;
+
+    struct Node {
+        std::string key;
+        Entry entry;
+        std::vector<Node*> next;  // 各层的后继
+    };
+
+   public:
+    /**
+     * @brief 按键有序的只读遍历
+     */
+    class Iterator {
+       public:
+        bool isValid() const { return node_ != nullptr; }
+        const std::string& key() const { return node_->key; }
+        const Entry& entry() const { return node_->entry; }
+        void next() { node_ = node_->next[0]; }
+
+       private:
+        friend class MemTable;
+        explicit Iterator(const Node* node) : node_(node) {}
+        const Node* node_;
+    };
+
+    Iterator begin() const { return Iterator(head_->next[0]); }
+
+    /**
+     * @brief 定位到第一个不小于key的键
+     */
+    Iterator lowerBound(const std::string& key) const {
+        return Iterator(findGreaterOrEqual(key, nullptr));
+    }
+
+   private:
+    std::unique_ptr<Node> head_;
+    std::vector<std::unique_ptr<Node>> nodes_;  // 持有所有节点
+    int level_;                                 // 当前最高层数
+    size_t size_;
+    size_t memoryUsage_;
+    std::mt19937 rng_;
+
+    int randomLevel();
+    Node* findGreaterOrEqual(const std::string& key, Node** prev) const;
+};
+
+/**
+ * @brief 位于BPlusTree之前的内存表写入层（LSM式）
+ *
+ * 写入先追加到日志，再写入有序的内存表后立即返回；内存表写满后封存，
+ * 由后台线程按键顺序分批经BPlusTree::write合并到树中，提交后删除其日志。
+ * 读取依次查找写入中的内存表、封存的内存表（由新到旧）和树。
+ * 打开时重放上次未合并完的日志。打开期间树只能经由本对象访问
+ */
+class MemTableTree {
+   public:
+    /**
+     * @brief 构造函数
+     * @param tree 已create的B+树
+     */
+    explicit MemTableTree(BPlusTree& tree);
+    ~MemTableTree();
+
+    /**
+     * @brief 重放遗留的日志并启动后台合并线程
+     * @param logPrefix 日志文件名前缀，日志为"<前缀>.<序号>"
+     * @param memtableBytes 内存表写满封存的近似字节数
+     * @param syncWrites true时每次写入后fdatasync日志，否则日志只进入操作系统缓存
+     * @return true如果成功
+     */
+    bool open(const std::string& logPrefix, size_t memtableBytes = 4 << 20,
+              bool syncWrites = false);
+
+    /**
+     * @brief 合并所有内存表、停止后台线程并删除日志
+     * @return false如果有内存表未能合并，其日志保留到下次打开时重放
+     */
+    bool close();
+
+    bool insert(const std::string& key, const std::vector<std::string>& value,
+                const std::string& rowId);
+
+    /**
+     * @brief 写入删除墓碑，不检查键是否存在
+     * @return true如果日志写入成功
+     */
+    bool remove(const std::string& key);
+
+    /**
+     * @brief 点查询，与BPlusTree::get的返回值相同
+     */
+    std::vector<std::vector<std::string>> get(const std::string& key);
+
+    /**
+     * @brief 范围查询，内存表中的写入覆盖树中的记录
+     *
+     * 与BPlusTree::scan相同，结果中的值截断到VALUE_SIZE-1字节，完整的值经get读取
+     */
+    std::vector<KeyValue> scan(const std::string& startKey,
+                               const std::string& endKey, int limit = -1);
+
+    /**
+     * @brief 封存当前内存表，等待所有内存表合并到树中
+     * @return false如果合并失败，失败的内存表留在内存中由后台线程重试
+     */
+    bool flush();
+
+    struct Stats {
+        size_t activeEntries;    // 写入中的内存表的键数
+        size_t sealedTables;     // 等待合并的内存表数
+        size_t mergedTables;     // 已合并的内存表数
+        size_t mergedRecords;    // 已合并的记录数（含墓碑）
+        size_t writeStalls;      // 封存的内存表过多、写入等待合并的次数
+        size_t mergeFailures;    // 合并或提交失败的次数
+
+        Stats()
+            : activeEntries(0),
+              sealedTables(0),
+              mergedTables(0),
+              mergedRecords(0),
+              writeStalls(0),
+              mergeFailures(0) {}
+    };
+
+    Stats getStats() const;
+
+   private:
+    static constexpr size_t MAX_SEALED_TABLES = 2;  // 超过时写入等待合并
+    static constexpr size_t MERGE_CHUNK = 256;      // 每次持有树的锁合并的记录数
+    static constexpr int MERGE_RETRY_MS = 100;      // 合并失败后重试的间隔
+
+    struct SealedTable {
+        std::shared_ptr<const MemTable> table;
+        uint64_t logSeq;
+    };
+
+    BPlusTree& tree_;
+    std::string logPrefix_;
+    size_t memtableBytes_;
+    bool syncWrites_;
+    bool longValues_;                    // 树完整保存长值，内存表不截断
+
+    std::shared_ptr<MemTable> active_;   // 写入中的内存表，nullptr表示未打开
+    uint64_t activeLogSeq_;
+    int logFd_;
+    std::deque<SealedTable> sealed_;     // 由旧到新
+
+    mutable std::mutex mutex_;           // 保护内存表、日志和统计
+    std::mutex treeMutex_;               // 保护tree_
+    std::condition_variable mergeWork_;  // 有封存的内存表或需要停止
+    std::condition_variable mergeDone_;  // 一个内存表合并完成
+    std::thread merger_;
+    bool stopping_;
+    bool mergeFailing_;                  // 最旧的封存内存表上次合并失败
+
+    size_t mergedTables_;
+    size_t mergedRecords_;
+    size_t writeStalls_;
+    size_t mergeFailures_;
+
+    std::string logPath(uint64_t seq) const;
+    bool openLog(uint64_t seq);
+    bool appendLog(const std::string& key, const MemTable::Entry& entry);
+    bool write(const std::string& key, const MemTable::Entry& entry);
+    void seal(std::unique_lock<std::mutex>& lock, bool reopen);
+    bool replayLogs();
+    bool mergeIntoTree(const MemTable& table);
+    void mergeLoop();
+};
@@ -0,0 +1,110 @@
+#include "NodeSearch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NODE_SEARCH_X86 1
+#endif
+
+// 二分查找缩小到该窗口大小后改为SIMD统计
+static const int SEARCH_WINDOW = 32;
+
+static int countLessScalar(const int64_t* keys, int count, int64_t key) {
+    int less = 0;
+    for (int i = 0; i < count; i++) {
+        less += keys[i] < key;
+    }
+    return less;
+}
+
+#ifdef NODE_SEARCH_X86
+__attribute__((target("sse4.2"))) static int countLessSSE42(const int64_t* keys,
+                                                             int count,
+                                                             int64_t key) {
+    __m128i target = _mm_set1_epi64x(key);
+    int less = 0;
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        // key > keys[i] 的通道全为1
+        __m128i greater = _mm_cmpgt_epi64(target, block);
+        less += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(greater)));
+    }
+    return less + countLessScalar(keys + i, count - i, key);
+}
+
+__attribute__((target("avx2"))) static int countLessAVX2(const int64_t* keys,
+                                                          int count,
+                                                          int64_t key) {
+    __m256i target = _mm256_set1_epi64x(key);
+    int less = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        __m256i greater = _mm256_cmpgt_epi64(target, block);
+        less +=
+            __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(greater)));
+    }
+    return less + countLessScalar(keys + i, count - i, key);
+}
+#endif
+
+SearchKernel detectSearchKernel() {
+#ifdef NODE_SEARCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SearchKernel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return SearchKernel::SSE42;
+#endif
+    return SearchKernel::SCALAR;
+}
+
+const char* searchKernelName(SearchKernel kernel) {
+    switch (kernel) {
+        case SearchKernel::AVX2:
+            return "AVX2";
+        case SearchKernel::SSE42:
+            return "SSE4.2";
+        default:
+            return "scalar";
+    }
+}
+
+int lowerBoundInt64(const int64_t* keys, int count, int64_t key,
+                    SearchKernel kernel) {
+    int left = 0;
+    int right = count;
+    while (right - left > SEARCH_WINDOW) {
+        int mid = left + (right - left) / 2;
+        if (keys[mid] < key) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+
+    // 窗口内有序，小于key的键数就是插入位置的偏移
+    const int64_t* window = keys + left;
+    int size = right - left;
+#ifdef NODE_SEARCH_X86
+    static const SearchKernel supported = detectSearchKernel();
+    if (kernel > supported) kernel = supported;
+    switch (kernel) {
+        case SearchKernel::AVX2:
+            return left + countLessAVX2(window, size, key);
+        case SearchKernel::SSE42:
+            return left + countLessSSE42(window, size, key);
+        default:
+            break;
+    }
+#else
+    (void)kernel;
+#endif
+    return left + countLessScalar(window, size, key);
+}
+
+int lowerBoundInt64(const int64_t* keys, int count, int64_t key) {
+    static const SearchKernel best = detectSearchKernel();
+    return lowerBoundInt64(keys, count, key, best);
+}
+
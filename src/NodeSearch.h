@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief 节点内搜索使用的指令集
+ */
+enum class SearchKernel {
+    SCALAR,  // 逐个比较
+    SSE42,   // 每条指令比较2个int64键
+    AVX2     // 每条指令比较4个int64键
+};
+
+/**
+ * @brief 检测当前CPU支持的最快搜索指令集
+ */
+SearchKernel detectSearchKernel();
+
+/**
+ * @brief 指令集名称
+ */
+const char* searchKernelName(SearchKernel kernel);
+
+/**
+ * @brief 在有序int64数组中查找第一个不小于key的位置
+ * @param keys 有序键数组
+ * @param count 键数量
+ * @param key 目标键
+ * @return 与std::lower_bound相同的下标
+ *
+ * 先二分缩小到一个小窗口，再在窗口内用SIMD统计小于key的键数，
+ * 窗口内的比较没有分支，也不会像二分那样在数组中跳跃访问。
+ * 使用运行时检测到的最快指令集（AVX2 > SSE4.2 > 标量）
+ */
+int lowerBoundInt64(const int64_t* keys, int count, int64_t key);
+
+/**
+ * @brief 使用指定指令集查找（用于基准测试）；CPU不支持时回退到标量
+ */
+int lowerBoundInt64(const int64_t* keys, int count, int64_t key,
+                    SearchKernel kernel);
+
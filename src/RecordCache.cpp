@@ -0,0 +1,71 @@
+#include "RecordCache.h"
+
+RecordCache::RecordCache(size_t capacity)
+    : capacity_(capacity), hitCount_(0), missCount_(0), evictions_(0) {}
+
+bool RecordCache::lookup(const std::string& key, Result& result) {
+    if (capacity_ == 0) return false;
+
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        missCount_++;
+        return false;
+    }
+    hitCount_++;
+    lruList_.splice(lruList_.begin(), lruList_, it->second);
+    result = it->second->second;
+    return true;
+}
+
+void RecordCache::put(const std::string& key, const Result& result) {
+    if (capacity_ == 0) return;
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = result;
+        lruList_.splice(lruList_.begin(), lruList_, it->second);
+        return;
+    }
+    lruList_.emplace_front(key, result);
+    index_[key] = lruList_.begin();
+    evictToCapacity();
+}
+
+void RecordCache::invalidate(const std::string& key) {
+    if (index_.empty()) return;
+
+    auto it = index_.find(key);
+    if (it == index_.end()) return;
+    lruList_.erase(it->second);
+    index_.erase(it);
+}
+
+void RecordCache::clear() {
+    lruList_.clear();
+    index_.clear();
+}
+
+void RecordCache::setCapacity(size_t capacity) {
+    capacity_ = capacity;
+    evictToCapacity();
+}
+
+void RecordCache::evictToCapacity() {
+    while (lruList_.size() > capacity_) {
+        index_.erase(lruList_.back().first);
+        lruList_.pop_back();
+        evictions_++;
+    }
+}
+
+RecordCache::Stats RecordCache::getStats() const {
+    Stats stats;
+    stats.entries = lruList_.size();
+    stats.capacity = capacity_;
+    stats.hitCount = hitCount_;
+    stats.missCount = missCount_;
+    stats.evictions = evictions_;
+    long long total = hitCount_ + missCount_;
+    stats.hitRatio = total > 0 ? (double)hitCount_ / total : 0.0;
+    return stats;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 点查询结果缓存
+ *
+ * 按键缓存get的完整结果（包括"不存在"），命中时不需要自根向下查找。
+ * 容量按条目数计，与BufferPool的页面数相互独立，超出时按LRU淘汰。
+ * 写操作由调用方按键使缓存失效
+ */
+class RecordCache {
+   public:
+    using Result = std::vector<std::vector<std::string>>;
+
+    /**
+     * @brief 构造函数
+     * @param capacity 最多缓存的键数，0表示禁用
+     */
+    explicit RecordCache(size_t capacity = 0);
+
+    bool enabled() const { return capacity_ > 0; }
+
+    /**
+     * @brief 查找缓存的结果，命中时移到LRU链表头部
+     * @param key 键
+     * @param result 输出结果
+     * @return true如果命中
+     */
+    bool lookup(const std::string& key, Result& result);
+
+    /**
+     * @brief 缓存查询结果，超出容量时淘汰最久未使用的键
+     */
+    void put(const std::string& key, const Result& result);
+
+    /**
+     * @brief 使键的缓存结果失效
+     */
+    void invalidate(const std::string& key);
+
+    /**
+     * @brief 清空缓存，保留命中统计
+     */
+    void clear();
+
+    /**
+     * @brief 修改容量，多出的条目按LRU淘汰
+     * @param capacity 新容量，0表示禁用并清空
+     */
+    void setCapacity(size_t capacity);
+
+    /**
+     * @brief 获取缓存统计信息
+     */
+    struct Stats {
+        size_t entries;       // 当前缓存的键数
+        size_t capacity;      // 最大容量
+        long long hitCount;   // 命中次数
+        long long missCount;  // 未命中次数
+        long long evictions;  // 因容量淘汰的条目数
+        double hitRatio;      // 命中率
+
+        Stats()
+            : entries(0),
+              capacity(0),
+              hitCount(0),
+              missCount(0),
+              evictions(0),
+              hitRatio(0.0) {}
+    };
+
+    Stats getStats() const;
+
+   private:
+    // LRU链表：最近使用的在前，最久未使用的在后
+    using LRUList = std::list<std::pair<std::string, Result>>;
+
+    LRUList lruList_;
+    std::unordered_map<std::string, LRUList::iterator> index_;
+
+    size_t capacity_;
+    long long hitCount_;
+    long long missCount_;
+    long long evictions_;
+
+    void evictToCapacity();
+};
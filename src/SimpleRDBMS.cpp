@@ -621,9 +621,18 @@ QueryResult SimpleRDBMS::executeInsert(const SQLStatement& stmt) {
         }
     }
     
+    // 主键按列类型做保序编码，整数主键按数值而不是字符串排序
+    std::string indexKey = primaryKeyValue;
+    for (const auto& col : table->columns) {
+        if (col.isPrimaryKey) {
+            indexKey = encodePrimaryKey(primaryKeyValue, col);
+            break;
+        }
+    }
+
     // 插入到索引
     std::string rowId = generateRowId();
-    if (!table->index->insert(primaryKeyValue, rowData, rowId)) {
+    if (!table->index->insert(indexKey, rowData, rowId)) {
         result.success = false;
         result.message = "Failed to insert record into index";
         return result;
@@ -719,6 +728,24 @@ bool SimpleRDBMS::validateValue(const std::string& value, const Column& column)
     return true;
 }
 
+std::string SimpleRDBMS::encodePrimaryKey(const std::string& value,
+                                          const Column& column) {
+    switch (column.type) {
+        case DataType::INTEGER:
+            try {
+                return encodeIntKey(std::stoll(value));
+            } catch (...) {
+                // 自动生成的行ID不是整数，按字符串编码
+                return encodeStringKey(value);
+            }
+        case DataType::BOOLEAN:
+            return encodeIntKey(value == "true" || value == "1" ? 1 : 0);
+        case DataType::VARCHAR:
+        default:
+            return encodeStringKey(value);
+    }
+}
+
 std::string SimpleRDBMS::getIndexFileName(const std::string& tableName) {
     return dbPath_ + "/" + tableName + ".idx";
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BPlusTree.h"
+#include "KeyEncoding.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -171,6 +172,7 @@ private:
                           const WhereCondition& condition, 
                           const Table& table);
     std::string formatValue(const std::string& value, DataType type);
+    std::string encodePrimaryKey(const std::string& value, const Column& column);
     std::vector<std::string> parseValueList(const std::string& valueStr);
     
     // 文件操作
@@ -0,0 +1,624 @@
+#include "StorageManager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// O_DIRECT要求缓冲区、偏移和长度都按逻辑块对齐，统一按4KB处理
+static const size_t DIRECT_IO_ALIGNMENT = 4096;
+
+char* allocateAligned(size_t size, size_t alignment) {
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<char*>(ptr);
+}
+
+void freeAligned(char* buffer) { free(buffer); }
+
+/**
+ * @brief PosixStorageManager构造函数
+ * @param pageSize 页面大小
+ * @param metadataSize 元数据区大小
+ * @param directIO 是否使用O_DIRECT
+ */
+PosixStorageManager::PosixStorageManager(size_t pageSize, size_t metadataSize,
+                                         bool directIO)
+    : StorageManager(pageSize, metadataSize),
+      fd_(-1),
+      directIO_(directIO),
+      directIOActive_(false) {}
+
+/**
+ * @brief 析构函数，确保文件被关闭
+ */
+PosixStorageManager::~PosixStorageManager() { close(); }
+
+/**
+ * @brief 打开数据文件，不存在时创建
+ * @param filename 文件名
+ * @param created 输出参数，文件是否为新建
+ * @return true如果成功
+ */
+bool PosixStorageManager::open(const std::string& filename, bool& created) {
+    close();
+
+    created = access(filename.c_str(), F_OK) != 0;
+    int flags = O_RDWR | O_CREAT;
+
+    if (directIO_) {
+        fd_ = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+        if (fd_ >= 0) {
+            directIOActive_ = true;
+            return true;
+        }
+        // tmpfs等文件系统不支持O_DIRECT，回退到普通I/O
+        std::cerr << "Warning: O_DIRECT not supported for " << filename
+                  << " (" << strerror(errno) << "), falling back to buffered I/O"
+                  << std::endl;
+    }
+
+    fd_ = ::open(filename.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open " << filename << ": " << strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    directIOActive_ = false;
+    return true;
+}
+
+/**
+ * @brief 关闭数据文件
+ */
+void PosixStorageManager::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    directIOActive_ = false;
+}
+
+/**
+ * @brief 读取一个完整页面
+ * @param pageId 页面ID
+ * @param buffer 目标缓冲区
+ * @return true如果读到完整页面
+ */
+bool PosixStorageManager::readPage(int pageId, char* buffer) {
+    if (fd_ < 0 || pageId < 0) return false;
+
+    ssize_t n = readFully(buffer, pageSize_, pageOffset(pageId));
+    if (n < 0) {
+        std::cerr << "Failed to read page " << pageId << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+    if (n > 0 && static_cast<size_t>(n) < pageSize_) {
+        // 部分读取，可能是文件末尾
+        std::cerr << "Partial read of page " << pageId << ": " << n
+                  << " bytes" << std::endl;
+    }
+    return static_cast<size_t>(n) == pageSize_;
+}
+
+/**
+ * @brief 写入一个完整页面
+ * @param pageId 页面ID
+ * @param buffer 源缓冲区
+ * @return true如果成功
+ */
+bool PosixStorageManager::writePage(int pageId, const char* buffer) {
+    if (fd_ < 0 || pageId < 0) return false;
+
+    if (!writeFully(buffer, pageSize_, pageOffset(pageId))) {
+        std::cerr << "Failed to write page " << pageId << " to disk: "
+                  << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取元数据区
+ */
+bool PosixStorageManager::readMetadata(char* buffer) {
+    if (fd_ < 0) return false;
+    return readFully(buffer, metadataSize_, 0) ==
+           static_cast<ssize_t>(metadataSize_);
+}
+
+/**
+ * @brief 写入元数据区
+ */
+bool PosixStorageManager::writeMetadata(const char* buffer) {
+    if (fd_ < 0) return false;
+    if (!writeFully(buffer, metadataSize_, 0)) {
+        std::cerr << "Failed to write metadata: " << strerror(errno)
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 将已写入的数据持久化到磁盘
+ */
+bool PosixStorageManager::sync() {
+    if (fd_ < 0) return false;
+    return fdatasync(fd_) == 0;
+}
+
+size_t PosixStorageManager::alignment() const {
+    return directIOActive_ ? DIRECT_IO_ALIGNMENT : 1;
+}
+
+bool PosixStorageManager::isAligned(const void* buffer) const {
+    return reinterpret_cast<uintptr_t>(buffer) % alignment() == 0;
+}
+
+/**
+ * @brief 完整读取指定区间，处理短读
+ * @return 实际读取的字节数，出错返回-1
+ *
+ * 直接I/O模式下若调用方缓冲区未对齐，经由临时对齐缓冲区中转
+ */
+ssize_t PosixStorageManager::readFully(char* buffer, size_t size,
+                                       off_t offset) {
+    char* target = buffer;
+    char* bounce = nullptr;
+    if (!isAligned(buffer)) {
+        bounce = allocateAligned(size, alignment());
+        if (!bounce) return -1;
+        target = bounce;
+    }
+
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd_, target + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            freeAligned(bounce);
+            return -1;
+        }
+        if (n == 0) break;  // 文件末尾
+        done += n;
+    }
+
+    if (done < size) {
+        memset(target + done, 0, size - done);
+    }
+    if (bounce) {
+        memcpy(buffer, bounce, size);
+        freeAligned(bounce);
+    }
+    return static_cast<ssize_t>(done);
+}
+
+/**
+ * @brief 完整写入指定区间，处理短写
+ */
+bool PosixStorageManager::writeFully(const char* buffer, size_t size,
+                                     off_t offset) {
+    const char* source = buffer;
+    char* bounce = nullptr;
+    if (!isAligned(buffer)) {
+        bounce = allocateAligned(size, alignment());
+        if (!bounce) return false;
+        memcpy(bounce, buffer, size);
+        source = bounce;
+    }
+
+    size_t done = 0;
+    bool ok = true;
+    while (done < size) {
+        ssize_t n = pwrite(fd_, source + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        done += n;
+    }
+
+    freeAligned(bounce);
+    return ok;
+}
+
+// ================================ ShadowStorageManager 实现
+// ================================
+
+// 文件开头元数据区中的格式标记，区分写时复制文件和原地更新文件
+static const char SHADOW_MAGIC[8] = {'B', 'P', 'T', 'S', 'H', 'D', 'W', '1'};
+
+// 元数据槽的首页，之后的页面保存元数据区
+struct ShadowMetaHeader {
+    char magic[8];
+    uint64_t txnId;        // 提交序号，打开时选择校验通过且序号最大的槽
+    int32_t tableHead;     // 映射表的第一个物理页面，-1表示空表
+    int32_t logicalCount;  // 映射表的项数
+    uint64_t checksum;     // 以上字段、映射表和元数据区的校验和
+};
+
+// 映射表页面：下一页、本页项数，之后是映射项
+static const int TABLE_PAGE_HEADER_INTS = 2;
+
+/**
+ * @brief FNV-1a校验和
+ */
+static uint64_t fnv1a(uint64_t h, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief ShadowStorageManager构造函数
+ * @param inner 保存物理页面的底层存储
+ */
+ShadowStorageManager::ShadowStorageManager(
+    std::unique_ptr<PosixStorageManager> inner)
+    : StorageManager(inner->pageSize(), inner->metadataSize()),
+      inner_(std::move(inner)),
+      physicalCount_(0),
+      freeListStale_(false) {}
+
+ShadowStorageManager::~ShadowStorageManager() { close(); }
+
+/**
+ * @brief 每个元数据槽占用的物理页面数：首页加元数据区
+ */
+int ShadowStorageManager::metaPages() const {
+    return 1 + static_cast<int>((metadataSize_ + pageSize_ - 1) / pageSize_);
+}
+
+/**
+ * @brief 检查已打开的文件是否为写时复制格式
+ */
+bool ShadowStorageManager::isShadowFile(StorageManager& storage) {
+    std::vector<char> buffer(storage.metadataSize());
+    return storage.readMetadata(buffer.data()) &&
+           memcmp(buffer.data(), SHADOW_MAGIC, sizeof(SHADOW_MAGIC)) == 0;
+}
+
+/**
+ * @brief 打开数据文件
+ * @param filename 文件名
+ * @param created 输出参数，文件是否为新建
+ * @return true如果成功
+ *
+ * 新文件写入格式标记并提交空版本；已有文件从两个元数据槽中
+ * 选择校验通过且提交序号最大的版本，之后的写入都在其基础上进行
+ */
+bool ShadowStorageManager::open(const std::string& filename, bool& created) {
+    if (!inner_->open(filename, created)) return false;
+
+    committed_.reset();
+    pinned_.clear();
+    privatePages_.clear();
+    freePages_.clear();
+    physicalCount_ = 2 * metaPages();
+    freeListStale_ = false;
+
+    if (created) {
+        std::vector<char> marker(metadataSize_, 0);
+        memcpy(marker.data(), SHADOW_MAGIC, sizeof(SHADOW_MAGIC));
+        pageTable_.clear();
+        metadata_.assign(metadataSize_, 0);
+        return inner_->writeMetadata(marker.data()) && sync();
+    }
+
+    if (!isShadowFile(*inner_)) {
+        std::cerr << filename << " is not a copy-on-write file" << std::endl;
+        inner_->close();
+        return false;
+    }
+
+    std::shared_ptr<ShadowVersion> best;
+    for (int slot = 0; slot < 2; slot++) {
+        auto version = std::make_shared<ShadowVersion>();
+        if (loadMetaSlot(slot, *version) &&
+            (!best || version->txnId > best->txnId)) {
+            best = version;
+        }
+    }
+    if (!best) {
+        std::cerr << "No valid metadata slot in " << filename << std::endl;
+        inner_->close();
+        return false;
+    }
+
+    committed_ = best;
+    pageTable_ = best->pageTable;
+    metadata_ = best->metadata;
+    for (const auto* pages : {&best->pageTable, &best->tablePages}) {
+        for (int physical : *pages) {
+            physicalCount_ = std::max(physicalCount_, physical + 1);
+        }
+    }
+    // 上次崩溃前写入、未提交的物理页面不被任何版本引用，第一次分配时回收
+    freeListStale_ = true;
+    return true;
+}
+
+/**
+ * @brief 关闭数据文件，未提交的修改被丢弃
+ */
+void ShadowStorageManager::close() {
+    inner_->close();
+    committed_.reset();
+    pinned_.clear();
+}
+
+/**
+ * @brief 读取工作版本中的页面
+ */
+bool ShadowStorageManager::readPage(int pageId, char* buffer) {
+    if (pageId < 0 || pageId >= static_cast<int>(pageTable_.size()) ||
+        pageTable_[pageId] < 0) {
+        return false;
+    }
+    return inner_->readPage(pageTable_[pageId], buffer);
+}
+
+/**
+ * @brief 写入页面
+ * @param pageId 页面ID
+ * @param buffer 源缓冲区
+ * @return true如果成功
+ *
+ * 已提交版本引用的物理页面从不原地覆盖：页面在本次提交内第一次写入时
+ * 映射到新的物理页面，之后的写入覆盖这个私有页面
+ */
+bool ShadowStorageManager::writePage(int pageId, const char* buffer) {
+    if (!isOpen() || pageId < 0) return false;
+
+    if (pageId >= static_cast<int>(pageTable_.size())) {
+        pageTable_.resize(pageId + 1, -1);
+    }
+    if (privatePages_.insert(pageId).second) {
+        pageTable_[pageId] = allocatePhysical();
+    }
+    return inner_->writePage(pageTable_[pageId], buffer);
+}
+
+bool ShadowStorageManager::readMetadata(char* buffer) {
+    if (!isOpen()) return false;
+    memcpy(buffer, metadata_.data(), metadataSize_);
+    return true;
+}
+
+bool ShadowStorageManager::writeMetadata(const char* buffer) {
+    if (!isOpen()) return false;
+    memcpy(metadata_.data(), buffer, metadataSize_);
+    return true;
+}
+
+/**
+ * @brief 提交工作版本
+ * @return true如果新版本已持久化
+ *
+ * 1. 映射表写到新的物理页面，持久化映射表和本次写入的数据页面
+ * 2. 写入较旧的元数据槽并持久化，写完整后新版本生效
+ * 崩溃发生在第2步完成之前时，另一个槽中的版本及其页面都未被修改
+ */
+bool ShadowStorageManager::sync() {
+    if (!isOpen()) return false;
+
+    auto version = std::make_shared<ShadowVersion>();
+    version->txnId = committedTxnId() + 1;
+    version->pageTable = pageTable_;
+    version->metadata = metadata_;
+
+    const int perPage =
+        static_cast<int>(pageSize_ / sizeof(int32_t)) - TABLE_PAGE_HEADER_INTS;
+    int tablePageCount =
+        (static_cast<int>(pageTable_.size()) + perPage - 1) / perPage;
+    for (int i = 0; i < tablePageCount; i++) {
+        version->tablePages.push_back(allocatePhysical());
+    }
+
+    std::vector<char> buffer(pageSize_);
+    for (int i = 0; i < tablePageCount; i++) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        int begin = i * perPage;
+        int count = std::min(perPage, static_cast<int>(pageTable_.size()) - begin);
+        int32_t header[TABLE_PAGE_HEADER_INTS] = {
+            i + 1 < tablePageCount ? version->tablePages[i + 1] : -1, count};
+        memcpy(buffer.data(), header, sizeof(header));
+        memcpy(buffer.data() + sizeof(header), pageTable_.data() + begin,
+               count * sizeof(int32_t));
+        if (!inner_->writePage(version->tablePages[i], buffer.data())) {
+            return false;
+        }
+    }
+
+    if (!inner_->sync() || !writeMetaSlot(*version) || !inner_->sync()) {
+        return false;
+    }
+
+    // 上一个版本的页面在没有读者固定它之后可以复用
+    committed_ = version;
+    privatePages_.clear();
+    freeListStale_ = true;
+    return true;
+}
+
+/**
+ * @brief 固定最近提交的版本
+ */
+std::shared_ptr<const ShadowVersion> ShadowStorageManager::pinCommitted() {
+    pinned_.erase(std::remove_if(pinned_.begin(), pinned_.end(),
+                                 [](const std::weak_ptr<const ShadowVersion>& v) {
+                                     return v.expired();
+                                 }),
+                  pinned_.end());
+    if (committed_) {
+        pinned_.push_back(committed_);
+    }
+    return committed_;
+}
+
+/**
+ * @brief 读取指定版本中的页面
+ */
+bool ShadowStorageManager::readVersionPage(const ShadowVersion& version,
+                                           int pageId, char* buffer) {
+    if (pageId < 0 || pageId >= static_cast<int>(version.pageTable.size()) ||
+        version.pageTable[pageId] < 0) {
+        return false;
+    }
+    return inner_->readPage(version.pageTable[pageId], buffer);
+}
+
+/**
+ * @brief 分配一个不被任何版本引用的物理页面
+ */
+int ShadowStorageManager::allocatePhysical() {
+    if (freePages_.empty() && freeListStale_) {
+        rebuildFreeList();
+    }
+    if (!freePages_.empty()) {
+        int physical = freePages_.back();
+        freePages_.pop_back();
+        return physical;
+    }
+    return physicalCount_++;
+}
+
+/**
+ * @brief 重新计算空闲物理页面
+ *
+ * 工作版本、最近提交的版本和仍被读者固定的版本引用的页面以及元数据槽
+ * 之外的页面都是空闲的；在空闲列表用尽时才计算，每次提交后最多一次
+ */
+void ShadowStorageManager::rebuildFreeList() {
+    freeListStale_ = false;
+
+    std::vector<char> used(physicalCount_, 0);
+    std::fill(used.begin(), used.begin() + std::min(physicalCount_, 2 * metaPages()), 1);
+    auto mark = [&used](const std::vector<int>& pages) {
+        for (int physical : pages) {
+            if (physical >= 0 && physical < static_cast<int>(used.size())) {
+                used[physical] = 1;
+            }
+        }
+    };
+    mark(pageTable_);
+    std::vector<std::shared_ptr<const ShadowVersion>> versions = {committed_};
+    for (const auto& weak : pinned_) {
+        versions.push_back(weak.lock());
+    }
+    for (const auto& version : versions) {
+        if (!version) continue;
+        mark(version->pageTable);
+        mark(version->tablePages);
+    }
+
+    // 按页面号从小到大分配，文件尽量不增长
+    freePages_.clear();
+    for (int physical = physicalCount_ - 1; physical >= 0; physical--) {
+        if (!used[physical]) freePages_.push_back(physical);
+    }
+}
+
+/**
+ * @brief 版本的校验和：提交序号、映射表页面链、映射项和元数据区
+ *
+ * 映射表页面的内容（下一页和映射项）都计入校验和，映射表页面写坏时
+ * 该槽校验失败，打开文件时回退到另一个槽的版本
+ */
+uint64_t ShadowStorageManager::checksumOf(const ShadowVersion& version) const {
+    int32_t count = static_cast<int32_t>(version.pageTable.size());
+    uint64_t h = fnv1a(1469598103934665603ULL, &version.txnId,
+                       sizeof(version.txnId));
+    h = fnv1a(h, &count, sizeof(count));
+    h = fnv1a(h, version.tablePages.data(),
+              version.tablePages.size() * sizeof(int32_t));
+    h = fnv1a(h, version.pageTable.data(),
+              version.pageTable.size() * sizeof(int32_t));
+    return fnv1a(h, version.metadata.data(), version.metadata.size());
+}
+
+/**
+ * @brief 把版本写入序号对应的元数据槽
+ */
+bool ShadowStorageManager::writeMetaSlot(const ShadowVersion& version) {
+    std::vector<char> buffer(metaPages() * pageSize_, 0);
+    ShadowMetaHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHADOW_MAGIC, sizeof(SHADOW_MAGIC));
+    header.txnId = version.txnId;
+    header.tableHead = version.tablePages.empty() ? -1 : version.tablePages[0];
+    header.logicalCount = static_cast<int32_t>(version.pageTable.size());
+    header.checksum = checksumOf(version);
+    memcpy(buffer.data(), &header, sizeof(header));
+    memcpy(buffer.data() + pageSize_, version.metadata.data(), metadataSize_);
+
+    int first = static_cast<int>(version.txnId % 2) * metaPages();
+    for (int i = 0; i < metaPages(); i++) {
+        if (!inner_->writePage(first + i, buffer.data() + i * pageSize_)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 读取并校验一个元数据槽及其映射表
+ * @return false如果槽未写入、写入不完整或映射表损坏
+ */
+bool ShadowStorageManager::loadMetaSlot(int slot, ShadowVersion& version) {
+    std::vector<char> buffer(metaPages() * pageSize_);
+    int first = slot * metaPages();
+    for (int i = 0; i < metaPages(); i++) {
+        if (!inner_->readPage(first + i, buffer.data() + i * pageSize_)) {
+            return false;
+        }
+    }
+
+    ShadowMetaHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    if (memcmp(header.magic, SHADOW_MAGIC, sizeof(SHADOW_MAGIC)) != 0 ||
+        header.logicalCount < 0) {
+        return false;
+    }
+    version.txnId = header.txnId;
+    version.metadata.assign(buffer.data() + pageSize_,
+                            buffer.data() + pageSize_ + metadataSize_);
+
+    // 沿映射表页面链读取，页数超过项数所需时视为损坏
+    const int perPage =
+        static_cast<int>(pageSize_ / sizeof(int32_t)) - TABLE_PAGE_HEADER_INTS;
+    int maxPages = (header.logicalCount + perPage - 1) / perPage;
+    std::vector<char> page(pageSize_);
+    for (int physical = header.tableHead; physical != -1;) {
+        if (static_cast<int>(version.tablePages.size()) >= maxPages ||
+            !inner_->readPage(physical, page.data())) {
+            return false;
+        }
+        int32_t pageHeader[TABLE_PAGE_HEADER_INTS];
+        memcpy(pageHeader, page.data(), sizeof(pageHeader));
+        int count = pageHeader[1];
+        if (count < 0 || count > perPage) return false;
+
+        size_t begin = version.pageTable.size();
+        version.pageTable.resize(begin + count);
+        memcpy(version.pageTable.data() + begin, page.data() + sizeof(pageHeader),
+               count * sizeof(int32_t));
+        version.tablePages.push_back(physical);
+        physical = pageHeader[0];
+    }
+    return static_cast<int>(version.pageTable.size()) == header.logicalCount &&
+           checksumOf(version) == header.checksum;
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief 页面存储管理器抽象接口
+ *
+ * 数据文件由固定大小的元数据区和紧随其后的页面区组成，
+ * BPlusTree只通过该接口读写磁盘，不再直接持有文件流
+ */
+class StorageManager {
+   public:
+    virtual ~StorageManager() = default;
+
+    /**
+     * @brief 打开数据文件，不存在时创建
+     * @param filename 文件名
+     * @param created 输出参数，文件是否为新建
+     * @return true如果成功
+     */
+    virtual bool open(const std::string& filename, bool& created) = 0;
+
+    /**
+     * @brief 关闭数据文件
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief 文件是否已打开
+     */
+    virtual bool isOpen() const = 0;
+
+    /**
+     * @brief 读取一个完整页面
+     * @param pageId 页面ID
+     * @param buffer 目标缓冲区，大小为pageSize
+     * @return true如果读到完整页面；越过文件末尾或出错返回false
+     */
+    virtual bool readPage(int pageId, char* buffer) = 0;
+
+    /**
+     * @brief 写入一个完整页面
+     * @param pageId 页面ID
+     * @param buffer 源缓冲区，大小为pageSize
+     * @return true如果成功
+     */
+    virtual bool writePage(int pageId, const char* buffer) = 0;
+
+    /**
+     * @brief 读取元数据区
+     * @param buffer 目标缓冲区，大小为metadataSize
+     */
+    virtual bool readMetadata(char* buffer) = 0;
+
+    /**
+     * @brief 写入元数据区
+     * @param buffer 源缓冲区，大小为metadataSize
+     */
+    virtual bool writeMetadata(const char* buffer) = 0;
+
+    /**
+     * @brief 将已写入的数据持久化到磁盘
+     */
+    virtual bool sync() = 0;
+
+    /**
+     * @brief I/O缓冲区要求的对齐字节数（非直接I/O时为1）
+     */
+    virtual size_t alignment() const = 0;
+
+    size_t pageSize() const { return pageSize_; }
+    size_t metadataSize() const { return metadataSize_; }
+
+    /**
+     * @brief 计算页面在文件中的偏移量
+     */
+    off_t pageOffset(int pageId) const {
+        return static_cast<off_t>(metadataSize_) +
+               static_cast<off_t>(pageId) * static_cast<off_t>(pageSize_);
+    }
+
+   protected:
+    StorageManager(size_t pageSize, size_t metadataSize)
+        : pageSize_(pageSize), metadataSize_(metadataSize) {}
+
+    size_t pageSize_;      // 页面大小
+    size_t metadataSize_;  // 元数据区大小
+};
+
+/**
+ * @brief 基于pread/pwrite的存储管理器
+ *
+ * 功能特性：
+ * - 定位读写，不依赖共享的文件偏移，多个线程可并发读写不同页面
+ * - 可选O_DIRECT模式，绕过内核页缓存，使BufferPool成为唯一的缓存层
+ * - 直接I/O模式下自动处理未对齐的调用方缓冲区
+ */
+class PosixStorageManager : public StorageManager {
+   public:
+    /**
+     * @brief 构造函数
+     * @param pageSize 页面大小
+     * @param metadataSize 元数据区大小
+     * @param directIO 是否使用O_DIRECT
+     */
+    PosixStorageManager(size_t pageSize, size_t metadataSize,
+                        bool directIO = false);
+    ~PosixStorageManager() override;
+
+    bool open(const std::string& filename, bool& created) override;
+    void close() override;
+    bool isOpen() const override { return fd_ >= 0; }
+
+    bool readPage(int pageId, char* buffer) override;
+    bool writePage(int pageId, const char* buffer) override;
+    bool readMetadata(char* buffer) override;
+    bool writeMetadata(const char* buffer) override;
+    bool sync() override;
+    size_t alignment() const override;
+
+    /**
+     * @brief 是否实际启用了O_DIRECT（文件系统不支持时会自动回退）
+     */
+    bool isDirectIO() const { return directIOActive_; }
+
+    /**
+     * @brief 底层文件描述符，供异步I/O引擎使用
+     */
+    int fd() const { return fd_; }
+
+   private:
+    int fd_;               // 文件描述符
+    bool directIO_;        // 是否请求O_DIRECT
+    bool directIOActive_;  // O_DIRECT是否生效
+
+    /**
+     * @brief 完整读取指定区间，处理短读
+     * @return 实际读取的字节数，出错返回-1
+     */
+    ssize_t readFully(char* buffer, size_t size, off_t offset);
+
+    /**
+     * @brief 完整写入指定区间，处理短写
+     */
+    bool writeFully(const char* buffer, size_t size, off_t offset);
+
+    bool isAligned(const void* buffer) const;
+};
+
+/**
+ * @brief 写时复制存储的一个已提交版本
+ *
+ * 版本提交后不再修改；其引用的物理页面在所有持有者释放之前不会被复用
+ */
+struct ShadowVersion {
+    uint64_t txnId;               // 提交序号
+    std::vector<int> pageTable;   // 页面ID到物理页面的映射，-1表示未写入
+    std::vector<int> tablePages;  // 保存映射表的物理页面
+    std::vector<char> metadata;   // 元数据区
+};
+
+/**
+ * @brief 写时复制（影子分页）存储管理器
+ *
+ * 包装PosixStorageManager，上层看到的页面ID经页面映射表定位到物理页面：
+ * - 已提交版本引用的页面从不原地覆盖，第一次修改时写到空闲的物理页面
+ * - sync即提交：先写映射表和数据并持久化，再交替写两个带校验和的元数据槽，
+ *   元数据槽写完整之前崩溃时打开文件得到上一个版本，无需预写日志
+ * - pinCommitted返回的版本在释放前其页面保持不变，读者可不加锁地遍历
+ *
+ * 物理页面0到2*META_PAGES-1是两个元数据槽，文件开头的元数据区只写格式标记
+ */
+class ShadowStorageManager : public StorageManager {
+   public:
+    /**
+     * @brief 构造函数
+     * @param inner 保存物理页面的底层存储（尚未打开）
+     */
+    explicit ShadowStorageManager(std::unique_ptr<PosixStorageManager> inner);
+    ~ShadowStorageManager() override;
+
+    /**
+     * @brief 打开数据文件，不存在时创建并提交一个空版本
+     * @return false如果文件不是写时复制格式或没有完整的元数据槽
+     */
+    bool open(const std::string& filename, bool& created) override;
+    void close() override;
+    bool isOpen() const override { return inner_->isOpen(); }
+
+    bool readPage(int pageId, char* buffer) override;
+    bool writePage(int pageId, const char* buffer) override;
+
+    /**
+     * @brief 读写工作版本的元数据，sync时随版本一起发布
+     */
+    bool readMetadata(char* buffer) override;
+    bool writeMetadata(const char* buffer) override;
+
+    /**
+     * @brief 提交工作版本
+     */
+    bool sync() override;
+    size_t alignment() const override { return inner_->alignment(); }
+
+    /**
+     * @brief 固定最近提交的版本
+     * @return 版本，持有期间其页面不会被复用
+     */
+    std::shared_ptr<const ShadowVersion> pinCommitted();
+
+    /**
+     * @brief 读取指定版本中的页面
+     * @param version 已固定的版本
+     * @param pageId 页面ID
+     * @param buffer 目标缓冲区
+     */
+    bool readVersionPage(const ShadowVersion& version, int pageId,
+                         char* buffer);
+
+    /**
+     * @brief 最近提交的版本序号
+     */
+    uint64_t committedTxnId() const { return committed_ ? committed_->txnId : 0; }
+
+    /**
+     * @brief 检查已打开的文件是否为写时复制格式
+     */
+    static bool isShadowFile(StorageManager& storage);
+
+   private:
+    std::unique_ptr<PosixStorageManager> inner_;
+    std::shared_ptr<const ShadowVersion> committed_;  // 最近提交的版本
+    std::vector<std::weak_ptr<const ShadowVersion>> pinned_;  // 读者固定的版本
+
+    std::vector<int> pageTable_;         // 工作版本的页面映射
+    std::vector<char> metadata_;         // 工作版本的元数据区
+    std::unordered_set<int> privatePages_;  // 本次提交前已重新映射的页面ID
+
+    std::vector<int> freePages_;  // 不被任何版本引用的物理页面
+    int physicalCount_;           // 已使用的物理页面上界
+    bool freeListStale_;          // 提交或版本释放后需重新计算空闲页面
+
+    int metaPages() const;
+    int allocatePhysical();
+    void rebuildFreeList();
+    bool writeMetaSlot(const ShadowVersion& version);
+    bool loadMetaSlot(int slot, ShadowVersion& version);
+    uint64_t checksumOf(const ShadowVersion& version) const;
+};
+
+/**
+ * @brief 分配按指定字节对齐的缓冲区（用于O_DIRECT）
+ * @param size 缓冲区大小
+ * @param alignment 对齐字节数
+ * @return 缓冲区指针，需用freeAligned释放
+ */
+char* allocateAligned(size_t size, size_t alignment);
+
+/**
+ * @brief 释放allocateAligned分配的缓冲区
+ */
+void freeAligned(char* buffer);
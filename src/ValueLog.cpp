@@ -0,0 +1,222 @@
+#include "ValueLog.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// ================================ ValueLog 实现 ================================
+
+ValueLog::File::~File() {
+    if (fd >= 0) ::close(fd);
+}
+
+ValueLog::ValueLog() : garbageBytes_(0), collections_(0), reclaimedBytes_(0) {}
+
+ValueLog::~ValueLog() { close(); }
+
+std::string ValueLog::filePath(uint32_t generation) const {
+    return basePath_ + "." + std::to_string(generation);
+}
+
+/**
+ * @brief 打开（必要时创建）一代文件，追加位置为文件末尾
+ */
+std::shared_ptr<ValueLog::File> ValueLog::openFile(uint32_t generation) {
+    auto file = std::make_shared<File>();
+    file->generation = generation;
+    file->path = filePath(generation);
+    file->fd = ::open(file->path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (file->fd < 0) {
+        std::cerr << "Failed to open value log " << file->path << ": "
+                  << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(file->fd, &st) != 0) return nullptr;
+    file->size = st.st_size;
+    return file;
+}
+
+/**
+ * @brief 打开全部代号文件
+ *
+ * 回收中途退出时新旧两代文件同时存在，叶子可能引用其中任意一代，都要打开；
+ * 多余的旧文件在下一次回收时删除
+ */
+bool ValueLog::open(const std::string& basePath) {
+    close();
+    basePath_ = basePath;
+
+    size_t slash = basePath.rfind('/');
+    std::string directory =
+        slash == std::string::npos ? "." : basePath.substr(0, slash);
+    std::string namePrefix =
+        (slash == std::string::npos ? basePath : basePath.substr(slash + 1)) + ".";
+
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() <= namePrefix.size() ||
+                name.compare(0, namePrefix.size(), namePrefix) != 0) {
+                continue;
+            }
+            std::string digits = name.substr(namePrefix.size());
+            if (digits.size() > 9 ||
+                digits.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+            uint32_t generation = std::stoul(digits);
+            if (generation == 0) continue;
+            auto file = openFile(generation);
+            if (!file) {
+                close();
+                return false;
+            }
+            files_[generation] = file;
+        }
+        closedir(dir);
+    }
+
+    if (files_.empty()) {
+        auto file = openFile(1);
+        if (!file) return false;
+        files_[1] = file;
+    }
+    return true;
+}
+
+void ValueLog::close() {
+    files_.clear();
+    garbageBytes_ = 0;
+}
+
+std::string ValueLog::append(const std::string& value) {
+    if (files_.empty()) return "";
+    File& file = *files_.rbegin()->second;
+
+    size_t written = 0;
+    while (written < value.size()) {
+        ssize_t n = ::pwrite(file.fd, value.data() + written,
+                             value.size() - written, file.size + written);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Failed to append to value log " << file.path << ": "
+                      << strerror(errno) << std::endl;
+            return "";
+        }
+        written += n;
+    }
+
+    char pointer[POINTER_LENGTH + 1];
+    snprintf(pointer, sizeof(pointer), "\x01%08x%012llx%08x", file.generation,
+             (unsigned long long)file.size, (unsigned)value.size());
+    file.size += value.size();
+    return std::string(pointer, POINTER_LENGTH);
+}
+
+bool ValueLog::isPointer(const std::string& stored) {
+    return stored.size() == POINTER_LENGTH && stored[0] == '\x01';
+}
+
+bool ValueLog::parsePointer(const std::string& pointer, uint32_t& generation,
+                            uint64_t& offset, uint64_t& length) {
+    if (!isPointer(pointer)) return false;
+    if (pointer.find_first_not_of("0123456789abcdef", 1) != std::string::npos) {
+        return false;
+    }
+    generation = std::stoul(pointer.substr(1, 8), nullptr, 16);
+    offset = std::stoull(pointer.substr(9, 12), nullptr, 16);
+    length = std::stoull(pointer.substr(21, 8), nullptr, 16);
+    return true;
+}
+
+bool ValueLog::read(const FileSet& files, const std::string& pointer,
+                    std::string& value) {
+    uint32_t generation;
+    uint64_t offset, length;
+    if (!parsePointer(pointer, generation, offset, length)) return false;
+    auto it = files.find(generation);
+    if (it == files.end() || offset + length > it->second->size) return false;
+
+    value.resize(length);
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(it->second->fd, &value[done], length - done,
+                            offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+void ValueLog::release(const std::string& stored) {
+    uint32_t generation;
+    uint64_t offset, length;
+    if (parsePointer(stored, generation, offset, length)) {
+        garbageBytes_ += length;
+    }
+}
+
+bool ValueLog::sync() {
+    bool ok = true;
+    for (const auto& entry : files_) {
+        if (::fdatasync(entry.second->fd) != 0) ok = false;
+    }
+    return ok;
+}
+
+uint32_t ValueLog::startGeneration() {
+    if (files_.empty()) return 0;
+    uint32_t generation = files_.rbegin()->first + 1;
+    auto file = openFile(generation);
+    if (!file) return 0;
+    files_[generation] = file;
+    return generation;
+}
+
+/**
+ * @brief 删除旧代号文件
+ *
+ * 只从目录中删除，仍被快照引用的文件在最后一个引用释放时才关闭
+ */
+uint64_t ValueLog::dropGenerationsBefore(uint32_t generation) {
+    uint64_t dropped = 0;
+    auto it = files_.begin();
+    while (it != files_.end() && it->first < generation) {
+        dropped += it->second->size;
+        ::unlink(it->second->path.c_str());
+        it = files_.erase(it);
+    }
+
+    uint64_t moved = it != files_.end() ? it->second->size.load() : 0;
+    uint64_t reclaimed = dropped > moved ? dropped - moved : 0;
+    garbageBytes_ = 0;
+    collections_++;
+    reclaimedBytes_ += reclaimed;
+    return reclaimed;
+}
+
+uint64_t ValueLog::totalBytes() const {
+    uint64_t total = 0;
+    for (const auto& entry : files_) {
+        total += entry.second->size;
+    }
+    return total;
+}
+
+ValueLog::Stats ValueLog::getStats() const {
+    Stats stats;
+    stats.files = files_.size();
+    stats.totalBytes = totalBytes();
+    stats.garbageBytes = garbageBytes_;
+    stats.collections = collections_;
+    stats.reclaimedBytes = reclaimedBytes_;
+    return stats;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * @brief 键值分离（WiscKey式）的追加写值日志
+ *
+ * 值按写入顺序追加到"<路径>.<代号>"文件中，叶子只保存定长的指针
+ * （代号、偏移、长度），值的大小不再受叶子值槽限制。
+ * 被覆盖或删除的值留在日志中成为垃圾，由BPlusTree回收时把仍被引用的值
+ * 复制到下一代文件、提交后删除旧文件。本身不加锁，由所属的树串行访问
+ */
+class ValueLog {
+   public:
+    // 指针："\x01" + 8位十六进制代号 + 12位十六进制偏移 + 8位十六进制长度
+    static const size_t POINTER_LENGTH = 29;
+
+    /**
+     * @brief 一代日志文件，被快照引用时删除后仍可读取
+     */
+    struct File {
+        int fd;
+        uint32_t generation;
+        std::atomic<uint64_t> size;  // 已追加的字节数，快照读者并发读取
+        std::string path;
+
+        File() : fd(-1), generation(0), size(0) {}
+        ~File();
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+    };
+    using FileSet = std::map<uint32_t, std::shared_ptr<File>>;
+
+    ValueLog();
+    ~ValueLog();
+
+    ValueLog(const ValueLog&) = delete;
+    ValueLog& operator=(const ValueLog&) = delete;
+
+    /**
+     * @brief 打开路径下已有的全部代号文件，没有时创建第1代
+     * @param basePath 日志路径前缀
+     * @return true如果成功
+     */
+    bool open(const std::string& basePath);
+    void close();
+    bool isOpen() const { return !files_.empty(); }
+
+    /**
+     * @brief 把值追加到最新一代文件
+     * @return 指向该值的指针，写入失败时返回空字符串
+     */
+    std::string append(const std::string& value);
+
+    /**
+     * @brief 按指针读取值
+     * @return false如果指针无效或超出文件范围
+     */
+    bool read(const std::string& pointer, std::string& value) const {
+        return read(files_, pointer, value);
+    }
+    static bool read(const FileSet& files, const std::string& pointer,
+                     std::string& value);
+
+    /**
+     * @brief 字符串是否为值日志指针（否则是直接保存在叶子中的短值）
+     */
+    static bool isPointer(const std::string& stored);
+
+    /**
+     * @brief 指针指向的值不再被引用，计入垃圾字节数
+     */
+    void release(const std::string& stored);
+
+    /**
+     * @brief 把所有代号文件写入的数据持久化
+     */
+    bool sync();
+
+    /**
+     * @brief 当前全部文件，快照持有后即使回收删除了文件也能继续读取
+     */
+    FileSet files() const { return files_; }
+
+    /**
+     * @brief 新建下一代文件，之后的追加都写入它
+     * @return 新的代号，失败时返回0
+     */
+    uint32_t startGeneration();
+
+    /**
+     * @brief 删除代号小于generation的文件（回收的最后一步）
+     * @return 回收的字节数（删除的文件大小减去搬到新文件的字节数）
+     */
+    uint64_t dropGenerationsBefore(uint32_t generation);
+
+    uint64_t totalBytes() const;
+    uint64_t garbageBytes() const { return garbageBytes_; }
+
+    struct Stats {
+        size_t files;             // 代号文件数
+        uint64_t totalBytes;      // 全部文件的字节数
+        uint64_t garbageBytes;    // 已知不再被引用的字节数（打开后开始统计）
+        size_t collections;       // 完成的回收次数
+        uint64_t reclaimedBytes;  // 回收释放的字节数
+
+        Stats()
+            : files(0),
+              totalBytes(0),
+              garbageBytes(0),
+              collections(0),
+              reclaimedBytes(0) {}
+    };
+
+    Stats getStats() const;
+
+   private:
+    std::string basePath_;
+    FileSet files_;           // 按代号，最后一个接收追加
+    uint64_t garbageBytes_;
+    size_t collections_;
+    uint64_t reclaimedBytes_;
+
+    std::string filePath(uint32_t generation) const;
+    std::shared_ptr<File> openFile(uint32_t generation);
+    static bool parsePointer(const std::string& pointer, uint32_t& generation,
+                             uint64_t& offset, uint64_t& length);
+};
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BPlusTree.h"
+#include "KeyEncoding.h"
+#include "NodeSearch.h"
+
+/**
+ * @brief 节点内搜索基准测试
+ *
+ * 对比当前BPlusTreeNode::findKey（在64字节字符串键的列数组上二分）
+ * 与int64键数组上的std::lower_bound、标量窗口搜索和SIMD窗口搜索。
+ * 每种页面大小生成约64MB的节点，随机选择节点和键，
+ * 使大部分访问落在缓存之外，接近真实树下降时的访问模式
+ */
+class SearchBenchmark {
+   private:
+    static const size_t WORKING_SET = 64 * 1024 * 1024;
+    static const int PROBES = 2000000;
+
+    std::mt19937 rng;
+    long long checksum;  // 防止编译器优化掉搜索
+
+    struct Probe {
+        int node;
+        int64_t key;
+    };
+
+    std::vector<Probe> makeProbes(int nodeCount, int keysPerNode) {
+        std::uniform_int_distribution<int> nodeDis(0, nodeCount - 1);
+        // 键为偶数，探测值覆盖命中和未命中
+        std::uniform_int_distribution<int64_t> keyDis(-1, 2 * keysPerNode);
+        std::vector<Probe> probes(PROBES);
+        for (auto& probe : probes) {
+            probe.node = nodeDis(rng);
+            probe.key = keyDis(rng);
+        }
+        return probes;
+    }
+
+    template <typename Fn>
+    double measure(const std::vector<Probe>& probes, Fn search) {
+        auto start = std::chrono::high_resolution_clock::now();
+        long long sum = 0;
+        for (const auto& probe : probes) {
+            sum += search(probe);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        checksum += sum;
+        return std::chrono::duration<double, std::nano>(end - start).count() /
+               probes.size();
+    }
+
+    void printRow(const std::string& name, int keys, double ns) {
+        std::cout << "  " << std::left << std::setw(28) << name << std::right
+                  << std::setw(6) << keys << " 键/节点" << std::setw(10)
+                  << std::fixed << std::setprecision(1) << ns << " ns/次"
+                  << std::endl;
+    }
+
+   public:
+    SearchBenchmark() : rng(42), checksum(0) {}
+
+    void run(int pageSize) {
+        std::cout << "\n=== 页面大小 " << pageSize / 1024 << "KB ===" << std::endl;
+
+        // 当前布局：字符串键列数组，键为保序编码的整数
+        int recordKeys = (pageSize - sizeof(PageHeader)) / sizeof(KeyValue);
+        int recordNodes = WORKING_SET / pageSize;
+        std::vector<BPlusTreeNode> recordTree(recordNodes);
+        std::vector<std::string> encoded;
+        for (int i = 0; i < recordKeys; i++) {
+            encoded.push_back(encodeIntKey(2 * i));
+        }
+        for (auto& node : recordTree) {
+            for (int i = 0; i < recordKeys; i++) {
+                node.keys.push_back(KeyValue(encoded[i], "", ""));
+            }
+            node.header.keyCount = recordKeys;
+        }
+        auto recordProbes = makeProbes(recordNodes, recordKeys);
+        std::vector<std::string> probeKeys;
+        probeKeys.reserve(recordProbes.size());
+        for (const auto& probe : recordProbes) {
+            probeKeys.push_back(encodeIntKey(probe.key));
+        }
+        size_t next = 0;
+        double recordNs = measure(recordProbes, [&](const Probe& probe) {
+            return recordTree[probe.node].findKey(probeKeys[next++]);
+        });
+        printRow("BPlusTreeNode::findKey", recordKeys, recordNs);
+        recordTree.clear();
+        recordTree.shrink_to_fit();
+
+        // 定长键布局：与FixedKeyBPlusTree内部节点相同的int64键数组
+        int intKeys = (pageSize - 4 * sizeof(int) - sizeof(int)) /
+                      (sizeof(int64_t) + sizeof(int));
+        int intNodes = WORKING_SET / pageSize;
+        int stride = pageSize / sizeof(int64_t);
+        std::vector<int64_t> pages((size_t)intNodes * stride);
+        for (int n = 0; n < intNodes; n++) {
+            for (int i = 0; i < intKeys; i++) {
+                pages[(size_t)n * stride + i] = 2 * i;
+            }
+        }
+        auto intProbes = makeProbes(intNodes, intKeys);
+        auto keysOf = [&](const Probe& probe) {
+            return pages.data() + (size_t)probe.node * stride;
+        };
+
+        // 所有实现的结果必须一致
+        SearchKernel best = detectSearchKernel();
+        for (int i = 0; i < 10000; i++) {
+            const Probe& probe = intProbes[i];
+            int expected = std::lower_bound(keysOf(probe), keysOf(probe) + intKeys,
+                                            probe.key) - keysOf(probe);
+            if (lowerBoundInt64(keysOf(probe), intKeys, probe.key, best) != expected ||
+                lowerBoundInt64(keysOf(probe), intKeys, probe.key,
+                                SearchKernel::SCALAR) != expected) {
+                std::cout << "✗ 搜索结果不一致" << std::endl;
+                return;
+            }
+        }
+
+        double stdNs = measure(intProbes, [&](const Probe& probe) {
+            return (int)(std::lower_bound(keysOf(probe), keysOf(probe) + intKeys,
+                                          probe.key) - keysOf(probe));
+        });
+        printRow("int64 std::lower_bound", intKeys, stdNs);
+
+        std::vector<SearchKernel> kernels = {SearchKernel::SCALAR};
+        if (best >= SearchKernel::SSE42) kernels.push_back(SearchKernel::SSE42);
+        if (best >= SearchKernel::AVX2) kernels.push_back(SearchKernel::AVX2);
+        for (SearchKernel kernel : kernels) {
+            double ns = measure(intProbes, [&](const Probe& probe) {
+                return lowerBoundInt64(keysOf(probe), intKeys, probe.key, kernel);
+            });
+            printRow(std::string("int64 窗口搜索 ") + searchKernelName(kernel),
+                     intKeys, ns);
+        }
+    }
+
+    long long getChecksum() const { return checksum; }
+};
+
+int main() {
+    std::cout << "节点内搜索基准测试 (CPU支持: "
+              << searchKernelName(detectSearchKernel()) << ")" << std::endl;
+
+    SearchBenchmark benchmark;
+    benchmark.run(4 * 1024);
+    benchmark.run(16 * 1024);
+
+    std::cout << "\n(checksum " << benchmark.getChecksum() << ")" << std::endl;
+    return 0;
+}
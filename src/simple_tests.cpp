@@ -1,9 +1,23 @@
+#include <dirent.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "BPlusTree.h"
+#include "FixedKeyBPlusTree.h"
+#include "KeyEncoding.h"
+#include "MemTable.h"
 
 class SimpleBPlusTreeTester {
    private:
@@ -275,6 +289,1727 @@ class SimpleBPlusTreeTester {
         tree.close();
     }
 
+    void test5_RangeScan() {
+        printTestHeader("测试5: 范围扫描与顺序预读");
+
+        if (!tree.create("scan_test.db", PAGE_SIZE, 50)) {
+            std::cout << "✗ 数据库创建失败!" << std::endl;
+            return;
+        }
+
+        // 插入足够多的数据，使扫描跨越多个叶子
+        const int count = MAX_KEYS_PER_PAGE * 20;
+        for (int i = count - 1; i >= 0; i--) {
+            std::string num = std::to_string(i);
+            std::string key = "scan" + std::string(4 - num.length(), '0') + num;
+            tree.insert(key, {"value" + num}, "row" + num);
+        }
+        printTreeStats();
+
+        // 全量扫描应按键有序返回所有记录
+        std::cout << "\n-- 全量扫描 --" << std::endl;
+        auto all = tree.scan("", "scan9999");
+        bool ordered = (int)all.size() == count;
+        for (size_t i = 1; ordered && i < all.size(); i++) {
+            ordered = all[i - 1].getKey() < all[i].getKey();
+        }
+        if (ordered) {
+            std::cout << "✓ 全量扫描返回 " << all.size() << " 条有序记录"
+                      << std::endl;
+        } else {
+            std::cout << "✗ 全量扫描结果错误: " << all.size() << "/" << count
+                      << std::endl;
+        }
+
+        // 闭区间范围扫描
+        std::cout << "\n-- 范围扫描 --" << std::endl;
+        auto range = tree.scan("scan0100", "scan0149");
+        if (range.size() == 50 && range.front().getKey() == "scan0100" &&
+            range.back().getKey() == "scan0149") {
+            std::cout << "✓ 范围扫描 [scan0100, scan0149] 返回 50 条记录"
+                      << std::endl;
+        } else {
+            std::cout << "✗ 范围扫描结果错误: " << range.size() << " 条"
+                      << std::endl;
+        }
+
+        // 游标遍历，并查看预读后的缓冲池命中情况
+        std::cout << "\n-- 游标遍历 --" << std::endl;
+        int visited = 0;
+        for (auto cursor = tree.seek("scan0200"); cursor.isValid();
+             cursor.next()) {
+            visited++;
+        }
+        std::cout << (visited == count - 200 ? "✓" : "✗") << " 游标从 scan0200 "
+                  << "遍历 " << visited << " 条记录" << std::endl;
+        auto poolStats = tree.getBufferPoolStats();
+        std::cout << "I/O引擎: " << tree.getIOEngineName()
+                  << ", 缓冲池命中率: " << std::fixed << std::setprecision(1)
+                  << poolStats.hitRatio * 100 << "%" << std::endl;
+
+        tree.close();
+    }
+
+    void test6_MultiGet() {
+        printTestHeader("测试6: 批量查询");
+
+        if (!tree.create("multiget_test.db", PAGE_SIZE, 50)) {
+            std::cout << "✗ 数据库创建失败!" << std::endl;
+            return;
+        }
+
+        const int count = MAX_KEYS_PER_PAGE * 10;
+        for (int i = 0; i < count; i++) {
+            std::string num = std::to_string(i);
+            tree.insert("mget" + std::string(4 - num.length(), '0') + num,
+                        {"value" + num}, "row" + num);
+        }
+
+        // 无序、含重复和不存在的键
+        std::vector<std::string> keys = {"mget0150", "mget0003", "missing",
+                                         "mget0150", "mget0077", "mget9999"};
+        auto results = tree.multiGet(keys);
+
+        bool correct = results.size() == keys.size();
+        for (size_t i = 0; correct && i < keys.size(); i++) {
+            auto expected = tree.get(keys[i]);
+            correct = results[i] == expected;
+            std::cout << (correct ? "✓ " : "✗ ") << keys[i] << " -> "
+                      << (results[i].empty() ? "(未找到)" : results[i][0][0])
+                      << std::endl;
+        }
+        std::cout << (correct ? "✓ 批量查询结果与逐个查询一致"
+                              : "✗ 批量查询结果不一致")
+                  << std::endl;
+
+        tree.close();
+    }
+
+    void test7_WriteBatch() {
+        printTestHeader("测试7: 批量写入");
+
+        if (!tree.create("batch_test.db", PAGE_SIZE, 50)) {
+            std::cout << "✗ 数据库创建失败!" << std::endl;
+            return;
+        }
+
+        // 先逐个插入偶数键，再用批量写入插入奇数键并删除部分偶数键
+        const int count = MAX_KEYS_PER_PAGE * 20;
+        for (int i = 0; i < count; i += 2) {
+            std::string num = std::to_string(i);
+            tree.insert("batch" + std::string(4 - num.length(), '0') + num,
+                        {"value" + num}, "row" + num);
+        }
+
+        WriteBatch batch;
+        for (int i = count - 1; i >= 0; i--) {
+            std::string num = std::to_string(i);
+            std::string key = "batch" + std::string(4 - num.length(), '0') + num;
+            if (i % 2 == 1) {
+                batch.put(key, {"value" + num}, "row" + num);
+            } else if (i % 6 == 0) {
+                batch.remove(key);
+            }
+        }
+        // 同一键的多次操作以最后一次为准
+        batch.put("batch0001", {"overwritten"}, "row1");
+        batch.remove("batch0003");
+
+        TreeStats before = tree.getStat();
+        bool applied = tree.write(batch);
+        TreeStats after = tree.getStat();
+        std::cout << (applied ? "✓ " : "✗ ") << "批量写入 " << batch.size()
+                  << " 个操作，分裂次数: " << before.splitCount << " -> "
+                  << after.splitCount << std::endl;
+
+        int errors = 0;
+        for (int i = 0; i < count; i++) {
+            std::string num = std::to_string(i);
+            std::string key = "batch" + std::string(4 - num.length(), '0') + num;
+            bool expected = !(i % 6 == 0 || i == 3);
+            auto result = tree.get(key);
+            if (result.empty() == expected) errors++;
+        }
+        auto overwritten = tree.get("batch0001");
+        if (overwritten.empty() || overwritten[0][0] != "overwritten") errors++;
+
+        auto all = tree.scan("batch0000", "batch9999");
+        bool ordered = std::is_sorted(
+            all.begin(), all.end(), [](const KeyValue& a, const KeyValue& b) {
+                return a.getKey() < b.getKey();
+            });
+        std::cout << (errors == 0 && ordered ? "✓ " : "✗ ")
+                  << "批量写入后共 " << all.size() << " 条记录，错误 " << errors
+                  << " 个" << std::endl;
+
+        tree.close();
+    }
+
+    void test8_Upsert() {
+        printTestHeader("测试8: 读-改-写");
+
+        // 累加结果依赖初始状态，删除上次运行留下的文件
+        std::remove("upsert_test.db");
+        if (!tree.create("upsert_test.db", PAGE_SIZE, 50)) {
+            std::cout << "✗ 数据库创建失败!" << std::endl;
+            return;
+        }
+
+        // 计数器：多个键反复累加，触发分裂后仍应保持正确
+        const int counters = MAX_KEYS_PER_PAGE * 3;
+        for (int round = 0; round < 5; round++) {
+            for (int i = 0; i < counters; i++) {
+                tree.merge("counter" + std::to_string(i), "add",
+                           std::to_string(i), "row" + std::to_string(i));
+            }
+        }
+        int errors = 0;
+        for (int i = 0; i < counters; i++) {
+            auto result = tree.get("counter" + std::to_string(i));
+            if (result.empty() || result[0][0] != std::to_string(i * 5)) {
+                errors++;
+            }
+        }
+        std::cout << (errors == 0 ? "✓ " : "✗ ") << counters
+                  << " 个计数器累加结果，错误 " << errors << " 个" << std::endl;
+
+        tree.merge("log", "append", "a");
+        tree.merge("log", "append", "b");
+        tree.merge("peak", "max", "7");
+        tree.merge("peak", "max", "3");
+        tree.upsert("custom", [](const std::string* existing) {
+            return existing ? *existing + "!" : std::string("init");
+        });
+        tree.upsert("custom", [](const std::string* existing) {
+            return existing ? *existing + "!" : std::string("init");
+        });
+
+        bool correct = tree.get("log")[0][0] == "ab" &&
+                       tree.get("peak")[0][0] == "7" &&
+                       tree.get("custom")[0][0] == "init!";
+        std::cout << (correct ? "✓ " : "✗ ") << "append/max/自定义合并函数"
+                  << std::endl;
+
+        bool rejected = !tree.merge("log", "unknown", "x");
+        std::cout << (rejected ? "✓ " : "✗ ") << "未注册的操作符被拒绝"
+                  << std::endl;
+
+        tree.close();
+    }
+
+    void test9_SequentialAppend() {
+        printTestHeader("测试9: 顺序追加与分裂策略");
+
+        const int count = MAX_KEYS_PER_PAGE * 50;
+        double evenFill = 0;
+        for (SplitPolicy policy : {SplitPolicy::EVEN, SplitPolicy::ADAPTIVE}) {
+            std::remove("append_test.db");
+            BPlusTree appendTree;
+            appendTree.setSplitPolicy(policy);
+            if (!appendTree.create("append_test.db", PAGE_SIZE, 50)) {
+                std::cout << "✗ 数据库创建失败!" << std::endl;
+                return;
+            }
+
+            // 键单调递增，走最右叶子追加快速路径
+            for (int i = 0; i < count; i++) {
+                std::string num = std::to_string(i);
+                appendTree.insert("seq" + std::string(6 - num.length(), '0') + num,
+                                  {"value" + num}, "row" + num);
+            }
+
+            int missing = 0;
+            for (int i = 0; i < count; i++) {
+                std::string num = std::to_string(i);
+                if (appendTree.get("seq" + std::string(6 - num.length(), '0') + num)
+                        .empty()) {
+                    missing++;
+                }
+            }
+
+            TreeStats stats = appendTree.getStat();
+            bool adaptive = policy == SplitPolicy::ADAPTIVE;
+            std::cout << (missing == 0 ? "✓ " : "✗ ")
+                      << (adaptive ? "ADAPTIVE" : "EVEN") << " - 节点数: "
+                      << stats.nodeCount << ", 填充率: " << std::fixed
+                      << std::setprecision(2) << stats.fillFactor * 100
+                      << "%, 丢失 " << missing << " 个键" << std::endl;
+            if (!adaptive) {
+                evenFill = stats.fillFactor;
+            } else {
+                std::cout << (stats.fillFactor > evenFill ? "✓ " : "✗ ")
+                          << "自适应分裂提高了顺序写入的填充率" << std::endl;
+            }
+            appendTree.close();
+        }
+    }
+
+    void test10_SiblingRedistribution() {
+        printTestHeader("测试10: 分裂前兄弟重分布");
+
+        // 固定顺序的乱序键，两次运行插入相同序列
+        const int count = MAX_KEYS_PER_PAGE * 100;
+        std::vector<int> order(count);
+        for (int i = 0; i < count; i++) order[i] = (i * 7919) % count;
+
+        double plainFill = 0;
+        for (bool enabled : {false, true}) {
+            std::remove("bstar_test.db");
+            BPlusTree bstarTree;
+            bstarTree.setSiblingRedistribution(enabled);
+            if (!bstarTree.create("bstar_test.db", PAGE_SIZE, 50)) {
+                std::cout << "✗ 数据库创建失败!" << std::endl;
+                return;
+            }
+
+            for (int i : order) {
+                std::string num = std::to_string(i);
+                bstarTree.insert("bstar" + std::string(5 - num.length(), '0') + num,
+                                 {"value" + num}, "row" + num);
+            }
+
+            auto all = bstarTree.scan("bstar00000", "bstar99999");
+            TreeStats stats = bstarTree.getStat();
+            std::cout << ((int)all.size() == count ? "✓ " : "✗ ")
+                      << (enabled ? "启用" : "关闭") << "重分布 - 记录数: "
+                      << all.size() << ", 节点数: " << stats.nodeCount
+                      << ", 填充率: " << std::fixed << std::setprecision(2)
+                      << stats.fillFactor * 100 << "%, 移键: "
+                      << stats.redistributionCount
+                      << ", 2分3: " << stats.threeWaySplitCount << std::endl;
+            if (!enabled) {
+                plainFill = stats.fillFactor;
+            } else {
+                std::cout << (stats.fillFactor > plainFill ? "✓ " : "✗ ")
+                          << "重分布提高了填充率" << std::endl;
+            }
+            bstarTree.close();
+        }
+    }
+
+    void test11_MergeThreshold() {
+        printTestHeader("测试11: 合并阈值");
+
+        // 顺序插入使叶子恰好半满，再在同一位置反复删除、插入
+        const int count = MAX_KEYS_PER_PAGE * 10;
+        int defaultChurn = 0;
+        for (int threshold : {MAX_KEYS_PER_PAGE / 2, MAX_KEYS_PER_PAGE / 4}) {
+            std::remove("threshold_test.db");
+            BPlusTree queueTree;
+            queueTree.setMergeThreshold(threshold);
+            if (!queueTree.create("threshold_test.db", PAGE_SIZE, 50)) {
+                std::cout << "✗ 数据库创建失败!" << std::endl;
+                return;
+            }
+
+            auto makeKey = [](int i) {
+                std::string num = std::to_string(i);
+                return "queue" + std::string(4 - num.length(), '0') + num;
+            };
+            for (int i = 0; i < count; i++) {
+                queueTree.insert(makeKey(i), {"value"}, "row");
+            }
+
+            TreeStats before = queueTree.getStat();
+            for (int round = 0; round < 100; round++) {
+                int i = (round * 37) % count;
+                queueTree.remove(makeKey(i));
+                queueTree.insert(makeKey(i), {"value"}, "row");
+            }
+            TreeStats after = queueTree.getStat();
+
+            int churn = (after.splitCount - before.splitCount) +
+                        (after.mergeCount - before.mergeCount);
+            auto all = queueTree.scan("queue0000", "queue9999");
+            std::cout << ((int)all.size() == count ? "✓ " : "✗ ") << "阈值 "
+                      << threshold << " - 分裂+合并: " << churn
+                      << ", 避免的结构修改: " << after.avoidedUnderflowCount
+                      << std::endl;
+            if (threshold == MAX_KEYS_PER_PAGE / 2) {
+                defaultChurn = churn;
+            } else {
+                std::cout << (churn < defaultChurn ? "✓ " : "✗ ")
+                          << "放宽阈值减少了合并/分裂抖动" << std::endl;
+
+                // 叶子低于半满但高于阈值时，只有插入的批量写不会使其下溢，
+                // 不应计入避免的结构修改
+                for (int i = 0; i < 3; i++) {
+                    queueTree.remove(makeKey(i));
+                }
+                int avoided = queueTree.getStat().avoidedUnderflowCount;
+                WriteBatch batch;
+                batch.put(makeKey(3), {"updated"}, "row");
+                batch.put(makeKey(4), {"updated"}, "row");
+                queueTree.write(batch);
+                std::cout << (queueTree.getStat().avoidedUnderflowCount == avoided
+                                  ? "✓ "
+                                  : "✗ ")
+                          << "只有插入的批量写不计入避免的结构修改" << std::endl;
+            }
+            queueTree.close();
+        }
+    }
+
+    void test12_KeyEncoding() {
+        printTestHeader("测试12: 保序键编码");
+
+        std::remove("encoding_test.db");
+        if (!tree.create("encoding_test.db", PAGE_SIZE, 50)) {
+            std::cout << "✗ 数据库创建失败!" << std::endl;
+            return;
+        }
+
+        // 整数键乱序插入，包含负数和0x00/0x01字节
+        const int range = 500;
+        for (int i = 0; i < 2 * range; i++) {
+            int64_t value = ((i * 7919) % (2 * range)) - range;
+            tree.insert(encodeIntKey(value), {std::to_string(value)}, "row");
+        }
+
+        auto rows = tree.scan(encodeIntKey(-10), encodeIntKey(255));
+        bool ordered = rows.size() == 266;
+        int64_t expected = -10;
+        for (const auto& row : rows) {
+            int64_t decoded = 0;
+            KeyDecoder decoder(row.getKey());
+            if (!decoder.readInt(decoded) || decoded != expected ||
+                row.getValue() != std::to_string(expected)) {
+                ordered = false;
+                break;
+            }
+            expected++;
+        }
+        std::cout << (ordered ? "✓ " : "✗ ") << "整数范围 [-10, 255] 按数值顺序返回 "
+                  << rows.size() << " 条记录" << std::endl;
+
+        // 多列元组：先按字符串列，再按整数列
+        std::vector<std::string> tuples = {
+            KeyEncoder().appendString("ab").appendInt(9).data(),
+            KeyEncoder().appendString("ab").appendInt(10).data(),
+            KeyEncoder().appendString("abc").appendInt(-1).data(),
+            KeyEncoder().appendString("b").appendInt(0).data()};
+        bool tupleOrdered = std::is_sorted(tuples.begin(), tuples.end());
+
+        std::string name;
+        int64_t id = 0;
+        KeyDecoder decoder(tuples[1]);
+        bool roundTrip = decoder.readString(name) && decoder.readInt(id) &&
+                         decoder.atEnd() && name == "ab" && id == 10;
+        std::cout << (tupleOrdered && roundTrip ? "✓ " : "✗ ")
+                  << "多列元组编码保序且可解码" << std::endl;
+
+        tree.close();
+    }
+
+    void test13_FixedKeyTree() {
+        printTestHeader("测试13: 定长整数键B+树");
+
+        std::remove("fixed_key_test.db");
+        std::vector<int64_t> keys;
+        {
+            FixedKeyBPlusTree<Int64KeyTraits> intTree;
+            if (!intTree.create("fixed_key_test.db", 20)) {
+                std::cout << "✗ 数据库创建失败!" << std::endl;
+                return;
+            }
+
+            // 乱序插入，包含负数，足以让内部节点分裂
+            const int count = 20000;
+            for (int i = 0; i < count; i++) {
+                int64_t key = (int64_t)((i * 7919) % count) - count / 2;
+                keys.push_back(key);
+                intTree.insert(key, "v" + std::to_string(key));
+            }
+            intTree.insert(keys[0], "updated");
+
+            std::cout << "内部节点容量: "
+                      << FixedKeyBPlusTree<Int64KeyTraits>::INTERNAL_CAPACITY
+                      << " (BPlusTree: " << MAX_KEYS_PER_PAGE << ")"
+                      << ", 树高度: " << intTree.height() << std::endl;
+            std::cout << (intTree.size() == keys.size() ? "✓ " : "✗ ")
+                      << "记录数 " << intTree.size() << "，重复键更新值" << std::endl;
+
+            for (size_t i = 0; i < keys.size(); i += 2) {
+                intTree.remove(keys[i]);
+            }
+        }
+
+        // 重新打开后验证持久化
+        FixedKeyBPlusTree<Int64KeyTraits> intTree;
+        if (!intTree.create("fixed_key_test.db", 20)) {
+            std::cout << "✗ 重新打开失败!" << std::endl;
+            return;
+        }
+        int found = 0;
+        int wrong = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            std::string value;
+            bool exists = intTree.get(keys[i], value);
+            if (exists) found++;
+            if (exists != (i % 2 == 1) ||
+                (exists && value != "v" + std::to_string(keys[i]))) {
+                wrong++;
+            }
+        }
+        std::cout << (wrong == 0 ? "✓ " : "✗ ") << "重新打开后查到 " << found
+                  << " 条记录，错误 " << wrong << std::endl;
+
+        auto rows = intTree.scan(-100, 100);
+        bool ordered = !rows.empty();
+        for (size_t i = 1; i < rows.size(); i++) {
+            if (rows[i - 1].first >= rows[i].first) ordered = false;
+        }
+        std::cout << (ordered ? "✓ " : "✗ ") << "范围 [-100, 100] 按数值顺序返回 "
+                  << rows.size() << " 条记录" << std::endl;
+        intTree.close();
+
+        // 文件大小受限时写回失败的脏页留在缓存中，放开限制后flush全部写回
+        std::remove("fixed_key_test.db");
+        {
+            FixedKeyBPlusTree<Int64KeyTraits> limitedTree;
+            limitedTree.create("fixed_key_test.db", 4);
+            limitedTree.flush();
+            struct rlimit saved;
+            getrlimit(RLIMIT_FSIZE, &saved);
+            struct rlimit limited = saved;
+            limited.rlim_cur = METADATA_SIZE;
+            std::signal(SIGXFSZ, SIG_IGN);
+            setrlimit(RLIMIT_FSIZE, &limited);
+            bool inserted = true;
+            for (int64_t key = 0; key < 2000; key++) {
+                inserted = limitedTree.insert(key, "v" + std::to_string(key)) &&
+                           inserted;
+            }
+            bool flushFailed = !limitedTree.flush();
+            setrlimit(RLIMIT_FSIZE, &saved);
+            std::signal(SIGXFSZ, SIG_DFL);
+            bool flushed = limitedTree.flush();
+            std::cout << (inserted && flushFailed && flushed ? "✓ " : "✗ ")
+                      << "写回失败时flush返回false，放开限制后写回成功"
+                      << std::endl;
+        }
+        {
+            FixedKeyBPlusTree<Int64KeyTraits> reopened;
+            reopened.create("fixed_key_test.db", 4);
+            int lost = 0;
+            for (int64_t key = 0; key < 2000; key++) {
+                std::string value;
+                if (!reopened.get(key, value) || value != "v" + std::to_string(key)) {
+                    lost++;
+                }
+            }
+            std::cout << (lost == 0 && reopened.size() == 2000 ? "✓ " : "✗ ")
+                      << "写回失败的页面未从缓存中丢弃，丢失 " << lost << std::endl;
+        }
+
+        // 页面读取失败时插入返回false，不访问空节点
+        if (truncate("fixed_key_test.db", METADATA_SIZE) == 0) {
+            FixedKeyBPlusTree<Int64KeyTraits> truncated;
+            truncated.create("fixed_key_test.db", 4);
+            std::string value;
+            bool rejected = !truncated.insert(1, "x") && !truncated.get(1, value) &&
+                            truncated.size() == 2000;
+            std::cout << (rejected ? "✓ " : "✗ ") << "页面读取失败时插入和查询返回false"
+                      << std::endl;
+        }
+        std::remove("fixed_key_test.db");
+    }
+
+    void test14_ColumnLayout() {
+        printTestHeader("测试14: 列式节点布局");
+
+        BPlusTreeNode leaf(7, true);
+        for (int i = 0; i < MAX_KEYS_PER_PAGE; i++) {
+            std::string suffix = std::to_string(100 + i);
+            leaf.insertKey(KeyValue("col" + suffix, "row" + suffix, "val" + suffix));
+        }
+
+        std::vector<char> page(PAGE_SIZE);
+        leaf.serialize(page.data());
+
+        // 键在页面头之后按KEY_SIZE连续存放
+        bool contiguous = true;
+        for (int i = 0; i < MAX_KEYS_PER_PAGE; i++) {
+            const char* slot = page.data() + sizeof(PageHeader) + i * KEY_SIZE;
+            if (std::string(slot) != "col" + std::to_string(100 + i)) {
+                contiguous = false;
+            }
+        }
+        std::cout << (contiguous ? "✓ " : "✗ ") << "叶子的键区域连续存放 "
+                  << MAX_KEYS_PER_PAGE << " 个键" << std::endl;
+
+        // 节点直接在页面帧上读写，不保留单独的副本
+        bool inPlace = leaf.keys.key(0) == leaf.frame + KEY_REGION_OFFSET &&
+                       reinterpret_cast<char*>(&leaf.header) == leaf.frame;
+        std::cout << (inPlace ? "✓ " : "✗ ") << "页面头和键直接位于节点的页面帧中"
+                  << std::endl;
+
+        BPlusTreeNode loaded;
+        loaded.deserialize(page.data());
+        bool roundTrip = loaded.header.keyCount == MAX_KEYS_PER_PAGE;
+        for (int i = 0; roundTrip && i < MAX_KEYS_PER_PAGE; i++) {
+            KeyValue kv = loaded.keys.get(i);
+            std::string suffix = std::to_string(100 + i);
+            roundTrip = kv.getKey() == "col" + suffix &&
+                        kv.getRowId() == "row" + suffix &&
+                        kv.getValue() == "val" + suffix;
+        }
+        std::cout << (roundTrip ? "✓ " : "✗ ") << "叶子序列化后键、rowId和值一致"
+                  << std::endl;
+
+        // 满的内部节点（键数+1个子节点）也能放入一个页面
+        BPlusTreeNode internal(8, false);
+        internal.children.push_back(100);
+        for (int i = 0; i < MAX_KEYS_PER_PAGE; i++) {
+            internal.insertKey(KeyValue("sep" + std::to_string(100 + i), "", ""),
+                               101 + i);
+        }
+        internal.serialize(page.data());
+        BPlusTreeNode loadedInternal;
+        loadedInternal.deserialize(page.data());
+        bool childrenKept = loadedInternal.children == internal.children &&
+                            loadedInternal.keys.getKey(MAX_KEYS_PER_PAGE - 1) ==
+                                internal.keys.getKey(MAX_KEYS_PER_PAGE - 1);
+        std::cout << (childrenKept ? "✓ " : "✗ ") << "满内部节点的 "
+                  << internal.children.size() << " 个子节点指针序列化后一致"
+                  << std::endl;
+
+        // 旧布局的文件：元数据只有根页面等5个字段，页面按行存放
+        const std::string legacyFile = "column_legacy.db";
+        std::remove(legacyFile.c_str());
+        std::vector<char> legacy(METADATA_SIZE + PAGE_SIZE, 0);
+        int legacyMeta[5] = {1, 2, 1, 0, 0};
+        memcpy(legacy.data(), legacyMeta, sizeof(legacyMeta));
+        memset(legacy.data() + METADATA_SIZE + 64, 'k', 64);
+        {
+            std::ofstream out(legacyFile, std::ios::binary);
+            out.write(legacy.data(), legacy.size());
+        }
+        {
+            BPlusTree tree;
+            bool rejected = !tree.create(legacyFile);
+            std::cout << (rejected ? "✓ " : "✗ ") << "旧格式的文件打开失败"
+                      << std::endl;
+        }
+        std::ifstream in(legacyFile, std::ios::binary);
+        std::vector<char> after((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+        std::cout << (after == legacy ? "✓ " : "✗ ") << "拒绝打开的旧文件未被改写"
+                  << std::endl;
+        std::remove(legacyFile.c_str());
+    }
+
+    void test15_PrefixCompression() {
+        printTestHeader("测试15: 叶子前缀压缩");
+
+        const int count = 2000;
+        auto makeKey = [](int i) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "tenant:region:user:%06d", i * 7);
+            return std::string(buffer);
+        };
+
+        int leafNodes[2] = {0, 0};
+        for (int compressed = 0; compressed < 2; compressed++) {
+            std::remove("prefix_test.db");
+            BPlusTree prefixTree;
+            prefixTree.setPrefixCompression(compressed == 1);
+            if (!prefixTree.create("prefix_test.db")) {
+                std::cout << "✗ 创建文件失败!" << std::endl;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                int k = (i * 577) % count;  // 乱序插入
+                prefixTree.insert(makeKey(k), {"v" + std::to_string(k)},
+                                  "r" + std::to_string(k));
+            }
+            leafNodes[compressed] = prefixTree.getStat().nodeCount;
+            prefixTree.close();
+        }
+        std::cout << (leafNodes[1] < leafNodes[0] ? "✓ " : "✗ ")
+                  << "压缩后节点数 " << leafNodes[1] << "，未压缩 "
+                  << leafNodes[0] << std::endl;
+
+        // 重新打开压缩的树，插入不共享前缀的键使页面重新排布
+        BPlusTree prefixTree;
+        prefixTree.setPrefixCompression(true);
+        if (!prefixTree.create("prefix_test.db")) {
+            std::cout << "✗ 重新打开失败!" << std::endl;
+            return;
+        }
+        std::vector<std::string> others = {"a", "tenant:", "tenant:region:zz",
+                                           std::string(60, 'z')};
+        for (const auto& key : others) {
+            prefixTree.insert(key, {"other"}, "r");
+        }
+
+        int wrong = 0;
+        for (int i = 0; i < count; i++) {
+            auto result = prefixTree.get(makeKey(i));
+            if (result.empty() || result[0][0] != "v" + std::to_string(i)) {
+                wrong++;
+            }
+        }
+        for (const auto& key : others) {
+            if (prefixTree.get(key).empty()) wrong++;
+        }
+        std::cout << (wrong == 0 ? "✓ " : "✗ ") << "重新打开并插入不同前缀的键后，"
+                  << "查询错误 " << wrong << std::endl;
+
+        auto rows = prefixTree.scan(makeKey(100), makeKey(199));
+        bool ordered = rows.size() == 100;
+        for (size_t i = 0; ordered && i < rows.size(); i++) {
+            ordered = rows[i].getKey() == makeKey(100 + (int)i) &&
+                      rows[i].getRowId() == "r" + std::to_string(100 + i);
+        }
+        std::cout << (ordered ? "✓ " : "✗ ") << "范围扫描返回 " << rows.size()
+                  << " 条完整键的记录" << std::endl;
+
+        for (int i = 0; i < count; i += 2) {
+            prefixTree.remove(makeKey(i));
+        }
+        int remaining = 0;
+        for (int i = 0; i < count; i++) {
+            if (!prefixTree.get(makeKey(i)).empty()) remaining++;
+        }
+        std::cout << (remaining == count / 2 ? "✓ " : "✗ ") << "删除一半后剩余 "
+                  << remaining << " 条记录" << std::endl;
+    }
+
+    void test16_SuffixTruncation() {
+        printTestHeader("测试16: 分隔键截断");
+
+        const int count = 20000;
+        auto makeKey = [](int i) {
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer),
+                     "customer/region-north/account-%08d/orders", i * 13);
+            return std::string(buffer);
+        };
+
+        int heights[2] = {0, 0};
+        int nodes[2] = {0, 0};
+        for (int truncated = 0; truncated < 2; truncated++) {
+            std::remove("truncation_test.db");
+            BPlusTree truncTree;
+            truncTree.setSuffixTruncation(truncated == 1);
+            if (!truncTree.create("truncation_test.db")) {
+                std::cout << "✗ 创建文件失败!" << std::endl;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                int k = (int)((i * 7919LL) % count);  // 乱序插入
+                truncTree.insert(makeKey(k), {"v" + std::to_string(k)}, "r");
+            }
+            TreeStats stats = truncTree.getStat();
+            heights[truncated] = stats.height;
+            nodes[truncated] = stats.nodeCount;
+            truncTree.close();
+        }
+        std::cout << (heights[1] < heights[0] ? "✓ " : "✗ ") << "截断后树高度 "
+                  << heights[1] << "（节点 " << nodes[1] << "），未截断 "
+                  << heights[0] << "（节点 " << nodes[0] << "）" << std::endl;
+
+        // 重新打开后插入长键使压缩的内部节点重新排布或分裂
+        BPlusTree truncTree;
+        truncTree.setSuffixTruncation(true);
+        if (!truncTree.create("truncation_test.db")) {
+            std::cout << "✗ 重新打开失败!" << std::endl;
+            return;
+        }
+        std::vector<std::string> longKeys;
+        for (int i = 0; i < 500; i++) {
+            longKeys.push_back(std::string(40, 'a' + i % 26) + std::to_string(i));
+            truncTree.insert(longKeys.back(), {"long"}, "r");
+        }
+
+        int wrong = 0;
+        for (int i = 0; i < count; i++) {
+            auto result = truncTree.get(makeKey(i));
+            if (result.empty() || result[0][0] != "v" + std::to_string(i)) {
+                wrong++;
+            }
+        }
+        for (const auto& key : longKeys) {
+            if (truncTree.get(key).empty()) wrong++;
+        }
+        std::cout << (wrong == 0 ? "✓ " : "✗ ") << "插入长键后查询错误 " << wrong
+                  << std::endl;
+
+        for (int i = 0; i < count; i += 3) {
+            truncTree.remove(makeKey(i));
+        }
+        auto rows = truncTree.scan(makeKey(0), makeKey(count - 1));
+        bool ordered = rows.size() == (size_t)(count - (count + 2) / 3);
+        for (size_t i = 1; ordered && i < rows.size(); i++) {
+            ordered = rows[i - 1].getKey() < rows[i].getKey();
+        }
+        std::cout << (ordered ? "✓ " : "✗ ") << "删除后范围扫描返回 " << rows.size()
+                  << " 条有序记录" << std::endl;
+    }
+
+    void test17_BloomFilter() {
+        printTestHeader("测试17: Bloom过滤器");
+
+        const int count = 5000;
+        auto makeKey = [](int i) { return "dedup:" + std::to_string(i); };
+        std::remove("bloom_test.db");
+        std::remove("bloom_test.db.bloom");
+
+        {
+            BPlusTree bloomTree;
+            // 初始容量小于键数，插入过程中自动扩容重建
+            bloomTree.setBloomFilter(true, 1000);
+            if (!bloomTree.create("bloom_test.db")) {
+                std::cout << "✗ 创建文件失败!" << std::endl;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                bloomTree.insert(makeKey(i), {"v" + std::to_string(i)}, "r");
+            }
+            for (int i = 0; i < count; i += 2) {
+                bloomTree.remove(makeKey(i));
+            }
+
+            int missing = 0;
+            for (int i = 1; i < count; i += 2) {
+                if (bloomTree.get(makeKey(i)).empty()) missing++;
+            }
+            int falseHits = 0;
+            for (int i = count; i < 2 * count; i++) {
+                if (!bloomTree.get(makeKey(i)).empty()) falseHits++;
+            }
+            size_t rejects = bloomTree.getStat().bloomFilterRejects;
+            std::cout << (missing == 0 && falseHits == 0 ? "✓ " : "✗ ")
+                      << "存在的键全部查到，不存在的键全部未命中" << std::endl;
+            std::cout << (rejects >= count * 95 / 100 ? "✓ " : "✗ ")
+                      << count << " 次不存在键的查询中 " << rejects
+                      << " 次由过滤器直接返回" << std::endl;
+        }
+
+        // 正常关闭后加载保存的过滤器，删除的键仍然查不到
+        {
+            BPlusTree bloomTree;
+            bloomTree.setBloomFilter(true, 1000);
+            bloomTree.create("bloom_test.db");
+            int wrong = 0;
+            for (int i = 0; i < count; i++) {
+                bool found = !bloomTree.get(makeKey(i)).empty();
+                if (found != (i % 2 == 1)) wrong++;
+            }
+            std::cout << (wrong == 0 ? "✓ " : "✗ ") << "重新打开后查询错误 "
+                      << wrong << std::endl;
+        }
+
+        // 过滤器文件缺失（模拟异常退出）时按现有键重建
+        std::remove("bloom_test.db.bloom");
+        {
+            BPlusTree bloomTree;
+            bloomTree.setBloomFilter(true, 1000);
+            bloomTree.create("bloom_test.db");
+            int missing = 0;
+            for (int i = 1; i < count; i += 2) {
+                if (bloomTree.get(makeKey(i)).empty()) missing++;
+            }
+            bool rejected = bloomTree.get("absent").empty() &&
+                            bloomTree.getStat().bloomFilterRejects == 1;
+            std::cout << (missing == 0 && rejected ? "✓ " : "✗ ")
+                      << "过滤器文件缺失时重建，遗漏 " << missing << std::endl;
+        }
+
+        // 未启用过滤器的会话插入的键，之后启用过滤器时仍能查到
+        {
+            BPlusTree plainTree;
+            plainTree.create("bloom_test.db");
+            plainTree.insert("plain:added", {"v"}, "r");
+        }
+        {
+            BPlusTree bloomTree;
+            bloomTree.setBloomFilter(true, 1000);
+            bloomTree.create("bloom_test.db");
+            bool found = !bloomTree.get("plain:added").empty() &&
+                         bloomTree.getStat().bloomFilterRejects == 0;
+            std::cout << (found ? "✓ " : "✗ ")
+                      << "未启用过滤器的会话写入的键重新启用后仍能查到" << std::endl;
+        }
+        std::remove("bloom_test.db");
+        std::remove("bloom_test.db.bloom");
+    }
+
+    void test18_RecordCache() {
+        printTestHeader("测试18: 点查询结果缓存");
+
+        std::remove("record_cache_test.db");
+        BPlusTree cacheTree;
+        cacheTree.setRecordCacheSize(16);
+        if (!cacheTree.create("record_cache_test.db")) {
+            std::cout << "✗ 创建文件失败!" << std::endl;
+            return;
+        }
+        for (int i = 0; i < 1000; i++) {
+            cacheTree.insert("hot" + std::to_string(i), {"v" + std::to_string(i)},
+                             "r");
+        }
+
+        // 反复读取少量热点键，只有第一次需要下降
+        for (int round = 0; round < 10; round++) {
+            for (int i = 0; i < 8; i++) {
+                cacheTree.get("hot" + std::to_string(i));
+            }
+        }
+        auto stats = cacheTree.getRecordCacheStats();
+        std::cout << (stats.hitCount == 72 && stats.missCount == 8 ? "✓ " : "✗ ")
+                  << "热点键命中 " << stats.hitCount << " 次，未命中 "
+                  << stats.missCount << " 次" << std::endl;
+
+        // 写操作使缓存失效，之后读到新值
+        cacheTree.get("hot1000");
+        cacheTree.insert("hot0", {"new0"}, "r");
+        cacheTree.upsert("hot1", [](const std::string*) { return "new1"; });
+        cacheTree.remove("hot2");
+        cacheTree.insert("hot1000", {"new1000"}, "r");
+        WriteBatch batch;
+        batch.put("hot3", {"new3"}, "r");
+        batch.remove("hot4");
+        cacheTree.write(batch);
+
+        auto valueOf = [&cacheTree](const std::string& key) {
+            auto result = cacheTree.get(key);
+            return result.empty() ? std::string("<none>") : result[0][0];
+        };
+        bool fresh = valueOf("hot0") == "new0" && valueOf("hot1") == "new1" &&
+                     valueOf("hot2") == "<none>" && valueOf("hot3") == "new3" &&
+                     valueOf("hot4") == "<none>" &&
+                     valueOf("hot1000") == "new1000" && valueOf("hot5") == "v5";
+        std::cout << (fresh ? "✓ " : "✗ ") << "写操作后读到最新结果" << std::endl;
+
+        // 容量独立于缓冲池，超出时按LRU淘汰
+        for (int i = 100; i < 200; i++) {
+            cacheTree.get("hot" + std::to_string(i));
+        }
+        stats = cacheTree.getRecordCacheStats();
+        std::cout << (stats.entries == 16 && stats.evictions > 0 ? "✓ " : "✗ ")
+                  << "缓存条目 " << stats.entries << "/" << stats.capacity
+                  << "，淘汰 " << stats.evictions << std::endl;
+    }
+
+    void test19_ResidentUpperLevels() {
+        printTestHeader("测试19: 上层内部节点常驻内存");
+
+        const int count = 20000;
+        auto makeKey = [](int i) { return "res:" + std::to_string(i * 7919 % count); };
+        std::remove("resident_test.db");
+        {
+            BPlusTree buildTree;
+            buildTree.create("resident_test.db");
+            for (int i = 0; i < count; i++) {
+                buildTree.insert(makeKey(i), {"v"}, "r");
+            }
+        }
+
+        // 缓冲池只有8页，所有内部节点常驻后点查询最多读一次磁盘
+        BPlusTree residentTree;
+        residentTree.setResidentLevels(-1);
+        residentTree.create("resident_test.db", PAGE_SIZE, 8);
+        auto stats = residentTree.getBufferPoolStats();
+        size_t residentPages = stats.residentPages;
+        std::cout << (residentPages > 8 && stats.totalPages <= residentPages + 8
+                          ? "✓ "
+                          : "✗ ")
+                  << "常驻页面 " << residentPages << "（"
+                  << stats.residentBytes / 1024 << " KB），不占用8页的缓冲池容量"
+                  << std::endl;
+
+        // 穿插插入，分裂新建的内部节点同样常驻
+        long long maxMisses = 0;
+        int wrong = 0;
+        for (int i = 0; i < 4000; i++) {
+            residentTree.insert("res:new" + std::to_string(i), {"n"}, "r");
+            long long before = residentTree.getBufferPoolStats().missCount;
+            if (residentTree.get(makeKey(i * 13 % count)).size() != 1) wrong++;
+            maxMisses = std::max(
+                maxMisses, residentTree.getBufferPoolStats().missCount - before);
+        }
+        std::cout << (wrong == 0 && maxMisses <= 1 ? "✓ " : "✗ ")
+                  << "每次点查询最多未命中 " << maxMisses << " 页，常驻页面增至 "
+                  << residentTree.getBufferPoolStats().residentPages << std::endl;
+
+        // 按层数常驻时，常驻层分裂出的节点与重新加载常驻层的结果一致
+        residentTree.setResidentLevels(2);
+        for (int i = 0; i < 20000; i++) {
+            residentTree.insert("res:more" + std::to_string(i), {"m"}, "r");
+        }
+        size_t afterSplits = residentTree.getBufferPoolStats().residentPages;
+        residentTree.setResidentLevels(2);
+        size_t repinned = residentTree.getBufferPoolStats().residentPages;
+        std::cout << (afterSplits == repinned ? "✓ " : "✗ ")
+                  << "两层常驻时分裂后常驻 " << afterSplits << " 页，重新加载为 "
+                  << repinned << " 页" << std::endl;
+
+        // 只保留根节点常驻
+        residentTree.setResidentLevels(1);
+        size_t rootOnly = residentTree.getBufferPoolStats().residentPages;
+        residentTree.setResidentLevels(0);
+        size_t none = residentTree.getBufferPoolStats().residentPages;
+        std::cout << (rootOnly == 1 && none == 0 ? "✓ " : "✗ ")
+                  << "只常驻根节点时 " << rootOnly << " 页，关闭后 " << none
+                  << " 页" << std::endl;
+    }
+
+    void test20_CopyOnWriteSnapshot() {
+        printTestHeader("测试20: 写时复制与只读快照");
+
+        auto makeKey = [](int i) { return "cow:" + std::to_string(i * 7919 % 10000); };
+        std::remove("cow_test.db");
+        std::remove("cow_crash.db");
+
+        {
+            BPlusTree cowTree;
+            cowTree.setCopyOnWrite(true);
+            if (!cowTree.create("cow_test.db", PAGE_SIZE, 16)) {
+                std::cout << "✗ 创建文件失败!" << std::endl;
+                return;
+            }
+            for (int i = 0; i < 3000; i++) {
+                cowTree.insert(makeKey(i), {"v1"}, "r");
+            }
+            cowTree.commit();
+            BPlusTreeSnapshot before = cowTree.snapshot();
+
+            // 快照之后的插入、更新和删除引起分裂与合并，快照内容不变
+            for (int i = 3000; i < 6000; i++) {
+                cowTree.insert(makeKey(i), {"v2"}, "r");
+            }
+            for (int i = 0; i < 1000; i++) {
+                cowTree.remove(makeKey(i));
+            }
+            cowTree.insert(makeKey(1500), {"updated"}, "r");
+            cowTree.commit();
+            BPlusTreeSnapshot after = cowTree.snapshot();
+            for (int i = 6000; i < 7000; i++) {
+                cowTree.insert(makeKey(i), {"v3"}, "r");
+            }
+            cowTree.commit();
+
+            bool stable = before.scan("", "~").size() == 3000 &&
+                          before.get(makeKey(1500))[0][0] == "v1" &&
+                          !before.get(makeKey(10)).empty() &&
+                          before.get(makeKey(4000)).empty();
+            bool current = after.scan("", "~").size() == 5000 &&
+                           after.get(makeKey(1500))[0][0] == "updated" &&
+                           after.get(makeKey(10)).empty() &&
+                           cowTree.scan("", "~").size() == 6000;
+            std::cout << (stable && current ? "✓ " : "✗ ")
+                      << "快照 " << before.txnId() << " 和 " << after.txnId()
+                      << " 不受之后的写入和提交影响" << std::endl;
+
+            // 未提交的修改写到新的物理页面，此时复制文件相当于崩溃
+            for (int i = 7000; i < 8000; i++) {
+                cowTree.insert(makeKey(i), {"lost"}, "r");
+            }
+            cowTree.remove(makeKey(5000));
+            cowTree.flushBuffer();
+            std::ifstream src("cow_test.db", std::ios::binary);
+            std::ofstream dst("cow_crash.db", std::ios::binary);
+            dst << src.rdbuf();
+        }
+
+        {
+            BPlusTree recovered;
+            recovered.setCopyOnWrite(true);
+            recovered.create("cow_crash.db");
+            auto all = recovered.scan("", "~");
+            bool consistent = all.size() == 6000 &&
+                              !recovered.get(makeKey(5000)).empty() &&
+                              recovered.get(makeKey(7500)).empty();
+            std::cout << (consistent ? "✓ " : "✗ ")
+                      << "崩溃后打开得到最近一次提交的 " << all.size()
+                      << " 条记录" << std::endl;
+        }
+
+        // 最新版本的映射表页面写坏后，打开文件回退到上一个版本
+        {
+            std::remove("cow_table.db");
+            bool created = false;
+            std::vector<char> page(PAGE_SIZE, 'a');
+            uint64_t lastTxn = 0;
+            {
+                ShadowStorageManager shadow(
+                    std::make_unique<PosixStorageManager>(PAGE_SIZE, METADATA_SIZE));
+                shadow.open("cow_table.db", created);
+                shadow.writePage(0, page.data());
+                shadow.sync();
+                std::fill(page.begin(), page.end(), 'b');
+                shadow.writePage(0, page.data());
+                shadow.sync();
+                lastTxn = shadow.committedTxnId();
+            }
+
+            // 元数据槽首页：8字节标记、8字节提交序号，之后是映射表首页
+            PosixStorageManager raw(PAGE_SIZE, METADATA_SIZE);
+            raw.open("cow_table.db", created);
+            int metaPages = 1 + (METADATA_SIZE + PAGE_SIZE - 1) / PAGE_SIZE;
+            int32_t tableHead = -1;
+            raw.readPage(static_cast<int>(lastTxn % 2) * metaPages, page.data());
+            memcpy(&tableHead, page.data() + 16, sizeof(tableHead));
+            raw.readPage(tableHead, page.data());
+            page[2 * sizeof(int32_t)] ^= 0x01;  // 页面0的映射项
+            raw.writePage(tableHead, page.data());
+            raw.close();
+
+            ShadowStorageManager reopened(
+                std::make_unique<PosixStorageManager>(PAGE_SIZE, METADATA_SIZE));
+            bool opened = reopened.open("cow_table.db", created);
+            bool fellBack = opened && reopened.committedTxnId() == lastTxn - 1 &&
+                            reopened.readPage(0, page.data()) && page[0] == 'a';
+            std::cout << (fellBack ? "✓ " : "✗ ")
+                      << "映射表页面损坏时回退到版本 " << reopened.committedTxnId()
+                      << std::endl;
+            std::remove("cow_table.db");
+        }
+
+        BPlusTree plainTree;
+        bool rejected = !plainTree.create("cow_test.db");
+        std::cout << (rejected ? "✓ " : "✗ ")
+                  << "原地更新模式拒绝打开写时复制文件" << std::endl;
+        std::remove("cow_crash.db");
+    }
+
+    void test21_MVCCSnapshot() {
+        printTestHeader("测试21: 多版本读快照");
+
+        std::remove("mvcc_test.db");
+        BPlusTree mvccTree;
+        mvccTree.create("mvcc_test.db");
+        auto makeKey = [](int i) { return "acct:" + std::to_string(1000 + i); };
+        for (int i = 0; i < 500; i++) {
+            mvccTree.insert(makeKey(i), {"100"}, "r");
+        }
+
+        // 快照开始后继续更新、删除、插入和批量写入
+        MVCCSnapshot report = mvccTree.beginSnapshot();
+        for (int i = 0; i < 500; i += 5) {
+            mvccTree.merge(makeKey(i), "add", "10");
+        }
+        for (int i = 1; i < 500; i += 5) {
+            mvccTree.remove(makeKey(i));
+        }
+        for (int i = 500; i < 600; i++) {
+            mvccTree.insert(makeKey(i), {"new"}, "r");
+        }
+        MVCCSnapshot later = mvccTree.beginSnapshot();
+        WriteBatch batch;
+        batch.put(makeKey(0), {"batch"}, "r");
+        batch.remove(makeKey(2));
+        mvccTree.write(batch);
+
+        auto rows = report.scan("acct:", "acct:~");
+        bool unchanged = rows.size() == 500;
+        for (const auto& row : rows) {
+            if (row.getValue() != "100") unchanged = false;
+        }
+        unchanged = unchanged && report.get(makeKey(1))[0][0] == "100" &&
+                    report.get(makeKey(550)).empty() &&
+                    report.scan(makeKey(1), makeKey(3), 2).size() == 2;
+        std::cout << (unchanged ? "✓ " : "✗ ") << "快照看到开始时的 "
+                  << rows.size() << " 条记录" << std::endl;
+
+        bool middle = later.scan("acct:", "acct:~").size() == 500 &&
+                      later.get(makeKey(0))[0][0] == "110" &&
+                      later.get(makeKey(1)).empty() &&
+                      !later.get(makeKey(2)).empty() &&
+                      mvccTree.get(makeKey(0))[0][0] == "batch" &&
+                      mvccTree.get(makeKey(2)).empty();
+        std::cout << (middle ? "✓ " : "✗ ")
+                  << "较晚的快照看到其之前的写入，当前读看到全部写入" << std::endl;
+
+        // 释放快照后按低水位回收旧版本
+        size_t retained = mvccTree.getStat().retainedVersions;
+        report.release();
+        later.release();
+        mvccTree.insert(makeKey(0), {"final"}, "r");
+        auto stats = mvccTree.getStat();
+        std::cout << (retained > 0 && stats.activeSnapshots == 0 &&
+                              stats.retainedVersions == 0
+                          ? "✓ "
+                          : "✗ ")
+                  << "释放前保留旧版本 " << retained << "，释放后 "
+                  << stats.retainedVersions << std::endl;
+    }
+
+    void test22_MessageBuffering() {
+        printTestHeader("测试22: 写优化消息缓冲");
+
+        std::remove("buffered_test.db");
+        BPlusTree bufferedTree;
+        bufferedTree.setMessageBuffering(16);
+        bufferedTree.create("buffered_test.db");
+        auto makeKey = [](int i) { return "ev:" + std::to_string(i * 7919 % 5000); };
+
+        // 随机键写入、累加和删除都作为消息进入缓冲
+        for (int i = 0; i < 5000; i++) {
+            bufferedTree.insert(makeKey(i), {"0"}, "r");
+        }
+        for (int i = 0; i < 5000; i += 3) {
+            bufferedTree.merge(makeKey(i), "add", "5");
+        }
+        int removed = 0;
+        for (int i = 1; i < 5000; i += 3) {
+            if (bufferedTree.remove(makeKey(i))) removed++;
+        }
+        bool removedAgain = bufferedTree.remove(makeKey(1));
+        auto stats = bufferedTree.getStat();
+        std::cout << (stats.bufferedMessages > 0 && stats.messageFlushes > 0 &&
+                              removed == 1667 && !removedAgain
+                          ? "✓ "
+                          : "✗ ")
+                  << "缓冲中的消息 " << stats.bufferedMessages << "，下推批次 "
+                  << stats.messageFlushes << std::endl;
+
+        // 点查询合并路径上的缓冲
+        bool pointReads = true;
+        for (int i = 0; i < 60; i++) {
+            auto result = bufferedTree.get(makeKey(i));
+            if (i % 3 == 1) {
+                pointReads = pointReads && result.empty();
+            } else {
+                std::string expected = i % 3 == 0 ? "5" : "0";
+                pointReads = pointReads && !result.empty() &&
+                             result[0][0] == expected;
+            }
+        }
+        std::cout << (pointReads ? "✓ " : "✗ ") << "get看到缓冲中的写入、累加和删除"
+                  << std::endl;
+
+        // 范围查询前应用全部消息，关闭后重新打开内容不变
+        size_t scanned = bufferedTree.scan("ev:", "ev:~").size();
+        size_t afterScan = bufferedTree.getStat().bufferedMessages;
+        bufferedTree.close();
+        BPlusTree reopened;
+        reopened.create("buffered_test.db");
+        size_t persisted = reopened.scan("ev:", "ev:~").size();
+        auto sample = reopened.get(makeKey(3));
+        std::cout << (scanned == 3333 && afterScan == 0 && persisted == 3333 &&
+                              !sample.empty() && sample[0][0] == "5"
+                          ? "✓ "
+                          : "✗ ")
+                  << "scan得到 " << scanned << " 条记录，重新打开后 " << persisted
+                  << " 条" << std::endl;
+        reopened.close();
+
+        // 不检查存在性的删除只写入删除消息，每次只访问根节点
+        BPlusTree blindTree;
+        blindTree.setMessageBuffering(16);
+        blindTree.create("buffered_test.db");
+        auto before = blindTree.getBufferPoolStats();
+        for (int i = 0; i < 12; i += 3) {
+            blindTree.removeBlind(makeKey(i));
+        }
+        blindTree.removeBlind("ev:absent");
+        auto after = blindTree.getBufferPoolStats();
+        long long accesses = after.hitCount + after.missCount -
+                             before.hitCount - before.missCount;
+        bool blindRemoved = blindTree.get(makeKey(3)).empty() &&
+                            !blindTree.get(makeKey(2)).empty();
+        std::cout << (accesses <= 5 && blindRemoved ? "✓ " : "✗ ")
+                  << "5 次盲删除访问页面 " << accesses << " 次" << std::endl;
+        blindTree.close();
+        std::remove("buffered_test.db");
+    }
+
+    void test23_MemTableFront() {
+        printTestHeader("测试23: 内存表写入层与后台合并");
+
+        auto makeKey = [](int i) { return "log:" + std::to_string(i * 7919 % 4000); };
+        std::remove("memtable_test.db");
+        std::remove("memtable_crash.db");
+
+        {
+            BPlusTree baseTree;
+            baseTree.create("memtable_test.db");
+            baseTree.insert(makeKey(0), {"old"}, "r");
+            baseTree.insert("log:zzz", {"tree"}, "r");
+
+            // 每个内存表约16KB，写满后由后台线程合并到树中
+            MemTableTree front(baseTree);
+            front.open("memtable_test.log", 16 << 10);
+            for (int i = 0; i < 4000; i++) {
+                front.insert(makeKey(i), {"v" + std::to_string(i)}, "r");
+            }
+            front.remove("log:zzz");
+            bool visible = front.get(makeKey(0))[0][0] == "v0" &&
+                           front.get(makeKey(3999))[0][0] == "v3999" &&
+                           front.get("log:zzz").empty() &&
+                           front.scan("log:", "log:~").size() == 4000;
+            front.flush();
+            auto stats = front.getStats();
+            bool merged = stats.mergedTables > 0 && stats.sealedTables == 0 &&
+                          stats.activeEntries == 0;
+            std::cout << (visible && merged ? "✓ " : "✗ ")
+                      << "读取先查内存表，已合并 " << stats.mergedTables
+                      << " 个内存表共 " << stats.mergedRecords << " 条记录"
+                      << std::endl;
+
+            front.close();
+
+            // 未合并的写入只在日志中，此时复制文件相当于崩溃
+            MemTableTree pending(baseTree);
+            pending.open("memtable_pending.log");
+            for (int i = 0; i < 100; i++) {
+                pending.insert(makeKey(i), {"pending"}, "r");
+            }
+            baseTree.flushBuffer();
+            std::ifstream dbSrc("memtable_test.db", std::ios::binary);
+            std::ofstream dbDst("memtable_crash.db", std::ios::binary);
+            dbDst << dbSrc.rdbuf();
+            std::ifstream logSrc("memtable_pending.log.1", std::ios::binary);
+            std::ofstream logDst("memtable_crash.log.1", std::ios::binary);
+            logDst << logSrc.rdbuf();
+        }
+
+        {
+            BPlusTree recovered;
+            recovered.create("memtable_crash.db");
+            MemTableTree front(recovered);
+            front.open("memtable_crash.log");
+            bool replayed = front.get(makeKey(50))[0][0] == "pending" &&
+                            front.get(makeKey(150))[0][0] == "v150" &&
+                            recovered.getStat().nodeCount > 0;
+            front.close();
+            bool applied = recovered.get(makeKey(99))[0][0] == "pending" &&
+                           recovered.scan("log:", "log:~").size() == 4000;
+            std::cout << (replayed && applied ? "✓ " : "✗ ")
+                      << "重新打开时重放日志并合并到树中" << std::endl;
+        }
+        std::remove("memtable_crash.db");
+
+        // 合并失败时内存表留在内存中并重试，关闭后日志保留到下次打开时重放
+        std::remove("memtable_fail.db");
+        int accepted = 0;
+        {
+            BPlusTree failTree;
+            failTree.create("memtable_fail.db");
+            failTree.close();                // 写入已关闭的树失败，合并无法完成
+            MemTableTree front(failTree);
+            front.open("memtable_fail.log", 4 << 10);
+            for (int i = 0; i < 400; i++) {
+                if (front.insert(makeKey(i), {"kept"}, "r")) accepted++;
+            }
+            bool flushed = front.flush();
+            auto stats = front.getStats();
+            bool readable = front.get(makeKey(0))[0][0] == "kept";
+            bool closed = front.close();
+            std::cout << (!flushed && !closed && readable && accepted < 400 &&
+                                  stats.mergeFailures > 0 &&
+                                  stats.mergedTables == 0 &&
+                                  stats.sealedTables > 0
+                              ? "✓ "
+                              : "✗ ")
+                      << "合并失败 " << stats.mergeFailures << " 次，"
+                      << stats.sealedTables << " 个内存表保留，接受 " << accepted
+                      << " 条写入后拒绝写入" << std::endl;
+        }
+        {
+            BPlusTree failTree;
+            failTree.create("memtable_fail.db");
+            MemTableTree front(failTree);
+            bool reopened = front.open("memtable_fail.log") && front.close();
+            bool replayed =
+                reopened && !failTree.get(makeKey(accepted - 1)).empty() &&
+                (int)failTree.scan("log:", "log:~").size() == accepted;
+            std::cout << (replayed ? "✓ " : "✗ ")
+                      << "重新打开时合并保留的 " << accepted << " 条写入"
+                      << std::endl;
+        }
+        std::remove("memtable_fail.db");
+
+        // 树完整保存长值时，内存表在合并前后都不截断
+        const std::string longValue(1000, 'L');
+        bool longKept = true;
+        for (int mode = 0; mode < 2; mode++) {
+            std::string file = mode == 0 ? "memtable_vlog.db" : "memtable_overflow.db";
+            std::remove(file.c_str());
+            BPlusTree longTree;
+            if (mode == 0) {
+                longTree.setValueLog(true);
+            } else {
+                longTree.setOverflowPages(true);
+            }
+            longTree.create(file);
+            MemTableTree front(longTree);
+            front.open(file + ".log");
+            front.insert("long:1", {longValue}, "r");
+            bool beforeMerge = front.get("long:1")[0][0] == longValue;
+            bool merged = front.flush();
+            bool afterMerge = front.get("long:1")[0][0] == longValue;
+            front.close();
+            longKept = longKept && beforeMerge && merged && afterMerge &&
+                       longTree.get("long:1")[0][0] == longValue;
+            longTree.close();
+            std::remove(file.c_str());
+            std::remove((file + ".vlog.1").c_str());
+        }
+        std::cout << (longKept ? "✓ " : "✗ ")
+                  << "值日志和溢出页模式下1000字节的值合并前后完整" << std::endl;
+    }
+
+    void test24_ValueLog() {
+        printTestHeader("测试24: 键值分离的值日志");
+
+        auto makeValue = [](int i, char fill) {
+            return std::string(200 + i % 4000, fill) + std::to_string(i);
+        };
+        std::remove("vlog_test.db");
+        for (int generation = 1; generation <= 8; generation++) {
+            std::remove(("vlog_test.db.vlog." + std::to_string(generation)).c_str());
+        }
+
+        {
+            BPlusTree tree;
+            tree.setValueLog(true, 0);       // 只手动回收
+            tree.create("vlog_test.db");
+            for (int i = 0; i < 2000; i++) {
+                tree.insert("vlog:" + std::to_string(i), {makeValue(i, 'a')}, "r");
+            }
+            tree.insert("vlog:short", {"inline"}, "r");
+
+            auto value = tree.get("vlog:1234");
+            bool full = !value.empty() && value[0][0] == makeValue(1234, 'a') &&
+                        tree.get("vlog:short")[0][0] == "inline" &&
+                        tree.seek("vlog:1999").value() == makeValue(1999, 'a');
+            auto stats = tree.getStat();
+            std::cout << (full ? "✓ " : "✗ ") << "读取完整的长值，"
+                      << stats.nodeCount << " 个节点保存2001条记录" << std::endl;
+
+            // 覆盖和删除留下垃圾，回收后只保留仍被引用的值
+            for (int i = 0; i < 2000; i += 2) {
+                tree.insert("vlog:" + std::to_string(i), {makeValue(i, 'b')}, "r");
+            }
+            for (int i = 1; i < 2000; i += 4) {
+                tree.remove("vlog:" + std::to_string(i));
+            }
+            auto before = tree.getValueLogStats();
+            uint64_t reclaimed = tree.collectValueLog();
+            auto after = tree.getValueLogStats();
+            bool intact = tree.get("vlog:10")[0][0] == makeValue(10, 'b') &&
+                          tree.get("vlog:3")[0][0] == makeValue(3, 'a') &&
+                          tree.get("vlog:5").empty();
+            std::cout << (reclaimed > 0 && after.files == 1 &&
+                                  after.totalBytes < before.totalBytes && intact
+                              ? "✓ "
+                              : "✗ ")
+                      << "回收释放 " << reclaimed << " 字节，日志从 "
+                      << before.totalBytes << " 缩小到 " << after.totalBytes
+                      << " 字节" << std::endl;
+        }
+
+        {
+            // 是否使用值日志以文件为准
+            BPlusTree reopened;
+            reopened.create("vlog_test.db");
+            bool persisted =
+                reopened.get("vlog:1998")[0][0] == makeValue(1998, 'b') &&
+                reopened.get("vlog:1999")[0][0] == makeValue(1999, 'a') &&
+                reopened.scan("vlog:", "vlog:~").size() == 1501;
+            std::cout << (persisted ? "✓ " : "✗ ")
+                      << "重新打开后按指针读取值日志" << std::endl;
+        }
+
+        {
+            // 值日志达到文件大小上限后追加失败，写入失败且叶子保留原值
+            BPlusTree full;
+            full.setValueLog(true, 0);
+            full.create("vlog_test.db");
+            struct rlimit saved;
+            getrlimit(RLIMIT_FSIZE, &saved);
+            struct rlimit limited = saved;
+            limited.rlim_cur = full.getValueLogStats().totalBytes;
+            std::signal(SIGXFSZ, SIG_IGN);
+            setrlimit(RLIMIT_FSIZE, &limited);
+
+            WriteBatch batch;
+            batch.put("vlog:12", {makeValue(12, 'c')}, "r");
+            batch.put("vlog:14", {makeValue(14, 'c')}, "r");
+            bool rejected =
+                !full.insert("vlog:10", {makeValue(10, 'c')}, "r") &&
+                !full.insert("vlog:new", {makeValue(1, 'c')}, "r") &&
+                !full.upsert("vlog:16", [&](const std::string*) {
+                    return makeValue(16, 'c');
+                }) &&
+                !full.write(batch);
+
+            setrlimit(RLIMIT_FSIZE, &saved);
+            std::signal(SIGXFSZ, SIG_DFL);
+            bool unchanged = full.get("vlog:10")[0][0] == makeValue(10, 'b') &&
+                             full.get("vlog:12")[0][0] == makeValue(12, 'b') &&
+                             full.get("vlog:16")[0][0] == makeValue(16, 'b') &&
+                             full.get("vlog:new").empty() &&
+                             full.insert("vlog:10", {makeValue(10, 'd')}, "r") &&
+                             full.get("vlog:10")[0][0] == makeValue(10, 'd');
+            std::cout << (rejected && unchanged ? "✓ " : "✗ ")
+                      << "值日志追加失败时写入失败，叶子保留原值" << std::endl;
+
+            // 批量写入中途追加失败时整批都不应用，包括已写入值的组
+            limited.rlim_cur = full.getValueLogStats().totalBytes + 4000;
+            std::signal(SIGXFSZ, SIG_IGN);
+            setrlimit(RLIMIT_FSIZE, &limited);
+            WriteBatch spread;
+            for (int i = 100; i < 2000; i += 10) {
+                spread.put("vlog:" + std::to_string(i), {makeValue(i, 'e')}, "r");
+            }
+            spread.remove("vlog:3");
+            bool batchRejected = !full.write(spread);
+            setrlimit(RLIMIT_FSIZE, &saved);
+            std::signal(SIGXFSZ, SIG_DFL);
+            int applied = 0;
+            for (int i = 100; i < 2000; i += 10) {
+                auto value = full.get("vlog:" + std::to_string(i));
+                if (!value.empty() && value[0][0] == makeValue(i, 'e')) applied++;
+            }
+            bool kept = !full.get("vlog:3").empty();
+            std::cout << (batchRejected && applied == 0 && kept ? "✓ " : "✗ ")
+                      << "批量写入中途失败时不应用任何操作，已应用 " << applied
+                      << std::endl;
+        }
+    }
+
+    void test25_OverflowPages() {
+        printTestHeader("测试25: 超长值的溢出页");
+
+        auto makeValue = [](int i, char fill) {
+            return std::string(300 + i % 9000, fill) + std::to_string(i);
+        };
+        std::remove("overflow_test.db");
+
+        {
+            BPlusTree tree;
+            tree.setOverflowPages(true);
+            tree.create("overflow_test.db");
+            for (int i = 0; i < 500; i++) {
+                tree.insert("big:" + std::to_string(i), {makeValue(i, 'a')}, "r");
+            }
+            for (int i = 0; i < 2000; i++) {
+                tree.insert("small:" + std::to_string(i), {"v" + std::to_string(i)}, "r");
+            }
+
+            // 长值完整读出，小记录扫描不受溢出页影响
+            auto value = tree.get("big:321");
+            auto rows = tree.scan("small:", "small:~");
+            bool full = !value.empty() && value[0][0] == makeValue(321, 'a') &&
+                        tree.seek("big:499").value() == makeValue(499, 'a') &&
+                        rows.size() == 2000 && rows[0].getValue() == "v0";
+            auto stats = tree.getStat();
+            int used = stats.overflowPages;
+            std::cout << (full ? "✓ " : "✗ ") << "读取完整的长值，"
+                      << stats.nodeCount << " 个节点和 " << used
+                      << " 个溢出页保存2500条记录" << std::endl;
+
+            // 覆盖为短值或删除后溢出页进入空闲链表，再次写入长值时复用
+            for (int i = 0; i < 500; i += 2) {
+                tree.insert("big:" + std::to_string(i), {"short"}, "r");
+            }
+            for (int i = 1; i < 500; i += 4) {
+                tree.remove("big:" + std::to_string(i));
+            }
+            int released = tree.getStat().overflowPages;
+            int nodes = tree.getStat().nodeCount;
+            for (int i = 0; i < 500; i += 2) {
+                tree.insert("big:" + std::to_string(i), {makeValue(i, 'b')}, "r");
+            }
+            auto reused = tree.getStat();
+            bool intact = tree.get("big:10")[0][0] == makeValue(10, 'b') &&
+                          tree.get("big:3")[0][0] == makeValue(3, 'a') &&
+                          tree.get("big:5").empty();
+            std::cout << (released < used && reused.nodeCount == nodes && intact
+                              ? "✓ "
+                              : "✗ ")
+                      << "释放后剩余 " << released << " 个溢出页，重新写入后 "
+                      << reused.overflowPages << " 个" << std::endl;
+        }
+
+        {
+            // 是否使用溢出页以文件为准
+            BPlusTree reopened;
+            reopened.create("overflow_test.db");
+            bool persisted =
+                reopened.get("big:498")[0][0] == makeValue(498, 'b') &&
+                reopened.get("big:499")[0][0] == makeValue(499, 'a') &&
+                reopened.scan("big:", "big:~").size() == 375;
+            std::cout << (persisted ? "✓ " : "✗ ")
+                      << "重新打开后沿溢出链读取值" << std::endl;
+        }
+
+        {
+            // 未启用溢出页时写入的、形似溢出指针的值在启用后原样读出
+            std::string legacy = std::string("\x02") + "0000000100001000legacy";
+            std::string header = "0000000100001000tail";
+            std::string marked(200, 'm');
+            marked[VALUE_SIZE - 1] = '\x02';
+            std::remove("overflow_legacy.db");
+            {
+                BPlusTree plain;
+                plain.create("overflow_legacy.db");
+                plain.insert("legacy:1", {legacy}, "r");
+                plain.insert("legacy:2", {header}, "r");
+                plain.insert("legacy:3", {marked}, "r");
+            }
+            BPlusTree enabled;
+            enabled.setOverflowPages(true);
+            enabled.create("overflow_legacy.db");
+            enabled.insert("legacy:4", {legacy}, "r");
+            bool unchanged =
+                enabled.get("legacy:1")[0][0] == legacy &&
+                enabled.get("legacy:2")[0][0] == header &&
+                enabled.get("legacy:3")[0][0] == marked.substr(0, VALUE_SIZE - 1) &&
+                enabled.get("legacy:4")[0][0] == legacy &&
+                enabled.scan("legacy:", "legacy:~")[0].getValue() == legacy;
+            for (int i = 1; i <= 4; i++) {
+                enabled.remove("legacy:" + std::to_string(i));
+            }
+            auto stats = enabled.getStat();
+            std::cout << (unchanged && stats.overflowPages == 0 ? "✓ " : "✗ ")
+                      << "启用溢出页后已有的值不被当作溢出指针" << std::endl;
+            std::remove("overflow_legacy.db");
+        }
+    }
+
+    void test26_PosixStorageRoundTrip() {
+        printTestHeader("测试26: pread/pwrite存储层读写");
+
+        // 请求O_DIRECT；文件系统不支持时（如较老内核的tmpfs）回退到普通I/O，
+        // 各种情况都应读回相同数据
+        struct Case {
+            std::string path;
+            bool directIO;
+        };
+        std::vector<Case> cases = {{"storage_test.db", true},
+                                   {"storage_test.db", false}};
+        if (access("/dev/shm", W_OK) == 0) {
+            cases.push_back({"/dev/shm/storage_test.db", true});
+        }
+        for (const Case& test : cases) {
+            const std::string& path = test.path;
+            bool directIO = test.directIO;
+            std::remove(path.c_str());
+            bool ok = true;
+            bool directActive = false;
+            {
+                PosixStorageManager storage(PAGE_SIZE, METADATA_SIZE, directIO);
+                bool created = false;
+                ok = storage.open(path, created) && created;
+                directActive = storage.isDirectIO();
+
+                // 普通vector的缓冲区不保证对齐，直接I/O时经对齐的中转缓冲区读写
+                std::vector<char> metadata(METADATA_SIZE, 'm');
+                ok = ok && storage.writeMetadata(metadata.data());
+                for (int pageId = 0; ok && pageId < 8; pageId++) {
+                    std::vector<char> page(PAGE_SIZE, (char)('a' + pageId));
+                    ok = storage.writePage(pageId, page.data());
+                }
+                std::vector<char> page(PAGE_SIZE + 1);
+                ok = ok && storage.sync() && storage.readPage(5, page.data() + 1) &&
+                     page[1] == 'f' && page[PAGE_SIZE] == 'f' &&
+                     !storage.readPage(8, page.data());  // 越过文件末尾
+                storage.close();
+            }
+            {
+                // 以普通I/O重新打开，读到的内容与写入的一致
+                PosixStorageManager storage(PAGE_SIZE, METADATA_SIZE, false);
+                bool created = true;
+                std::vector<char> metadata(METADATA_SIZE);
+                std::vector<char> page(PAGE_SIZE);
+                ok = ok && storage.open(path, created) && !created &&
+                     storage.readMetadata(metadata.data()) &&
+                     metadata[METADATA_SIZE - 1] == 'm';
+                for (int pageId = 0; ok && pageId < 8; pageId++) {
+                    ok = storage.readPage(pageId, page.data()) &&
+                         page[0] == 'a' + pageId && page[PAGE_SIZE - 1] == 'a' + pageId;
+                }
+            }
+            std::remove(path.c_str());
+            std::cout << (ok ? "✓ " : "✗ ") << path << " "
+                      << (directIO ? "请求O_DIRECT" : "普通I/O")
+                      << "（实际" << (directActive ? "直接I/O" : "普通I/O")
+                      << "）写入的页面和元数据读回一致" << std::endl;
+        }
+    }
+
+    void test27_IOEngineBatch() {
+        printTestHeader("测试27: 批量I/O引擎与预取");
+
+        // 分别通过io_uring（不可用时回退）和同步引擎批量写入、再批量读回
+        for (bool preferAsync : {true, false}) {
+            std::remove("engine_test.db");
+            PosixStorageManager storage(PAGE_SIZE, METADATA_SIZE, false);
+            bool created = false;
+            bool ok = storage.open("engine_test.db", created);
+            auto engine = createIOEngine(storage, preferAsync);
+
+            const int count = 32;
+            std::vector<std::vector<char>> buffers(count, std::vector<char>(PAGE_SIZE));
+            std::vector<PageIORequest> requests(count);
+            std::vector<PageIORequest*> batch;
+            for (int i = 0; i < count; i++) {
+                std::fill(buffers[i].begin(), buffers[i].end(), (char)('A' + i % 26));
+                requests[i] = PageIORequest(PageIORequest::Type::WRITE, i,
+                                            buffers[i].data());
+                batch.push_back(&requests[i]);
+            }
+            ok = ok && engine->runBatch(batch);
+
+            for (int i = 0; i < count; i++) {
+                std::fill(buffers[i].begin(), buffers[i].end(), 0);
+                requests[i] = PageIORequest(PageIORequest::Type::READ, i,
+                                            buffers[i].data());
+            }
+            ok = ok && engine->submit(batch);
+            std::vector<PageIORequest*> completed;
+            while (ok && completed.size() < batch.size()) {
+                engine->reap(completed, 1);
+            }
+            for (int i = 0; ok && i < count; i++) {
+                ok = requests[i].success && buffers[i][0] == 'A' + i % 26 &&
+                     buffers[i][PAGE_SIZE - 1] == 'A' + i % 26;
+            }
+            std::cout << (ok ? "✓ " : "✗ ") << engine->name() << " 引擎批量写入并读回 "
+                      << count << " 个页面" << std::endl;
+        }
+        std::remove("engine_test.db");
+
+        // 树经所选引擎刷盘，重新打开后预取叶子再查询
+        for (bool asyncIO : {true, false}) {
+            std::remove("prefetch_test.db");
+            std::string engineName;
+            {
+                BPlusTree tree;
+                tree.setAsyncIO(asyncIO);
+                tree.create("prefetch_test.db", PAGE_SIZE, 50);
+                for (int i = 0; i < 3000; i++) {
+                    tree.insert("pf" + std::to_string(10000 + i), {std::to_string(i)}, "r");
+                }
+                engineName = tree.getIOEngineName();
+            }
+            BPlusTree tree;
+            tree.setAsyncIO(asyncIO);
+            tree.create("prefetch_test.db", PAGE_SIZE, 50);
+            std::vector<int> pageIds;
+            for (int pageId = 1; pageId <= 40; pageId++) {
+                pageIds.push_back(pageId);
+            }
+            int submitted = tree.prefetchPages(pageIds);
+            int found = 0;
+            for (int i = 0; i < 3000; i++) {
+                auto result = tree.get("pf" + std::to_string(10000 + i));
+                if (!result.empty() && result[0][0] == std::to_string(i)) found++;
+            }
+            std::cout << (found == 3000 && submitted > 0 ? "✓ " : "✗ ") << engineName
+                      << " 引擎刷盘后预取 " << submitted << " 个页面，找到 " << found
+                      << "/3000 个键" << std::endl;
+            tree.close();
+            std::remove("prefetch_test.db");
+        }
+    }
+
     void runAllTests() {
         std::cout << "简单B+树测试开始" << std::endl;
         std::cout << "页面大小: " << PAGE_SIZE << " bytes" << std::endl;
@@ -284,8 +2019,32 @@ class SimpleBPlusTreeTester {
         test2_TriggerSplit();
         test3_OrderedOperations();
         test4_EdgeCases();
+        test5_RangeScan();
+        test6_MultiGet();
+        test7_WriteBatch();
+        test8_Upsert();
+        test9_SequentialAppend();
+        test10_SiblingRedistribution();
+        test11_MergeThreshold();
+        test12_KeyEncoding();
+        test13_FixedKeyTree();
+        test14_ColumnLayout();
+        test15_PrefixCompression();
+        test16_SuffixTruncation();
+        test17_BloomFilter();
+        test18_RecordCache();
+        test19_ResidentUpperLevels();
+        test20_CopyOnWriteSnapshot();
+        test21_MVCCSnapshot();
+        test22_MessageBuffering();
+        test23_MemTableFront();
+        test24_ValueLog();
+        test25_OverflowPages();
+        test26_PosixStorageRoundTrip();
+        test27_IOEngineBatch();
         debugDuplicateKeyIssue();
         debugSplitDistribution();
+        debugInternalSplitParents();
 
         std::cout << "\n" << std::string(50, '=') << std::endl;
         std::cout << "所有测试完成!" << std::endl;
@@ -370,16 +2129,72 @@ class SimpleBPlusTreeTester {
 
         tree.close();
     }
+
+    void debugInternalSplitParents() {
+        std::cout << "\n=== 调试内部节点分裂后的父节点引用 ===" << std::endl;
+
+        std::remove("internal_split.db");
+        BPlusTree tree;
+        tree.create("internal_split.db", PAGE_SIZE, 50);
+
+        // 乱序插入，使内部节点多次分裂；分裂后移到新节点的子节点
+        // 若仍指向原父节点，之后的分隔键会插错位置，键随之丢失
+        const int count = 5000;
+        for (int i = 0; i < count; i++) {
+            int id = (int)((i * 7919LL) % count);
+            tree.insert("split" + std::to_string(100000 + id),
+                        {"value" + std::to_string(id)}, "row");
+        }
+
+        int found = 0;
+        for (int id = 0; id < count; id++) {
+            auto result = tree.get("split" + std::to_string(100000 + id));
+            if (!result.empty() && result[0][0] == "value" + std::to_string(id)) {
+                found++;
+            }
+        }
+        TreeStats stats = tree.getStat();
+        std::cout << (found == count ? "✓ " : "✗ ") << "乱序插入" << count
+                  << "个键后找到 " << found << " 个，高度:" << stats.height
+                  << std::endl;
+
+        tree.close();
+    }
 };
 
+/**
+ * @brief 删除测试目录及其中的文件（数据库、过滤器、值日志、写前日志）
+ */
+static void removeTestDirectory(const std::string& directory) {
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                std::remove((directory + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(directory.c_str());
+}
+
 int main() {
+    // 测试文件写到临时目录，结束后删除，不在当前目录留下数据库文件
+    char directory[] = "/tmp/bptree_simple_tests.XXXXXX";
+    if (!mkdtemp(directory) || chdir(directory) != 0) {
+        std::cerr << "无法创建测试目录" << std::endl;
+        return 1;
+    }
+
+    int status = 0;
     try {
         SimpleBPlusTreeTester tester;
         tester.runAllTests();
     } catch (const std::exception& e) {
         std::cerr << "测试异常: " << e.what() << std::endl;
-        return 1;
+        status = 1;
     }
 
-    return 0;
+    removeTestDirectory(directory);
+    return status;
 }
\ No newline at end of file